@@ -39,6 +39,16 @@ SET COMMON_LINKER_FLAGS=-opt:ref user32.lib Gdi32.lib winmm.lib
 REM Build tests
 cl.exe %COMMON_COMPILER_FLAGS% ..\%CODE_DIR%\tests\unit_tests.cpp /link %COMMON_LINKER_FLAGS% gentle_giant.lib
 
+REM Build the tests again with allocation tracking compiled into the library, & run them. Only this build can check that
+REM rendering doesn't touch the heap once it is set up, so it is run every time to keep it that way
+cl.exe %COMMON_COMPILER_FLAGS% -DGENTLE_TRACK_ALLOCATIONS /c ..\%CODE_DIR%\gentle_giant.cpp -Fogentle_giant_tracked.obj
+cl.exe %COMMON_COMPILER_FLAGS% -DGENTLE_TRACK_ALLOCATIONS ..\%CODE_DIR%\tests\unit_tests.cpp -Founit_tests_tracked.obj -Feunit_tests_tracked.exe /link %COMMON_LINKER_FLAGS% gentle_giant_tracked.obj
+unit_tests_tracked.exe
+if errorlevel 1 (
+	popd
+	exit /b 1
+)
+
 REM build the demo using the gentle_giant.lib
 cl.exe %COMMON_COMPILER_FLAGS% ..\%CODE_DIR%\demo\game.cpp /link %COMMON_LINKER_FLAGS% gentle_giant.lib gentle_giant_win32.lib
 
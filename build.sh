@@ -0,0 +1,38 @@
+#!/bin/sh
+# Linux build of the library, the headless platform layer, the unit tests & the demo
+
+set -e
+
+CODE_DIR=code
+OUTPUT_DIR=bin
+
+COMMON_COMPILER_FLAGS="-std=c++17 -pthread -Wall -Werror -Wno-unused-parameter -Wno-unused-but-set-variable -g -O2"
+
+rm -rf $OUTPUT_DIR
+mkdir $OUTPUT_DIR
+cd $OUTPUT_DIR
+
+# Build the platform independent library
+g++ $COMMON_COMPILER_FLAGS -c ../$CODE_DIR/gentle_giant.cpp
+ar rcs libgentle_giant.a gentle_giant.o
+
+# Build the platform dependent library
+g++ $COMMON_COMPILER_FLAGS -c ../$CODE_DIR/gentle_giant_linux.cpp
+ar rcs libgentle_giant_linux.a gentle_giant_linux.o
+
+# copy the library header files to the output directory
+cp ../$CODE_DIR/*.hpp .
+
+# Build tests
+g++ $COMMON_COMPILER_FLAGS ../$CODE_DIR/tests/unit_tests.cpp libgentle_giant.a -o unit_tests
+
+# Build the tests again with allocation tracking compiled into the library, & run them. Only this build can check that
+# rendering doesn't touch the heap once it is set up, so it is run every time to keep it that way
+g++ $COMMON_COMPILER_FLAGS -DGENTLE_TRACK_ALLOCATIONS -c ../$CODE_DIR/gentle_giant.cpp -o gentle_giant_tracked.o
+g++ $COMMON_COMPILER_FLAGS -DGENTLE_TRACK_ALLOCATIONS ../$CODE_DIR/tests/unit_tests.cpp gentle_giant_tracked.o -o unit_tests_tracked
+./unit_tests_tracked
+
+# build the demo using the libraries. It runs headless, see demo/game_linux.cpp
+g++ $COMMON_COMPILER_FLAGS ../$CODE_DIR/demo/game.cpp libgentle_giant_linux.a libgentle_giant.a -o game
+
+cp ../$CODE_DIR/demo/teapot.obj .
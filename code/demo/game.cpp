@@ -1,21 +1,39 @@
+#include <assert.h>
 #include <math.h>
+#include <thread>
 
 #include "../gentle_giant.hpp"
+#if defined(_WIN32)
 #include "game_win32.cpp"
+#else
+#include "game_linux.cpp"
+#endif
 
 gentle::Camera<float> camera;
 gentle::Mesh<float> mesh;
+gentle::IndexedMesh<float> indexedMesh;
+gentle::ShadingCache<float> shadingCache;
 gentle::Matrix4x4<float> projectionMatrix;
+gentle::RenderSettings renderSettings;
+gentle::MemoryArena frameArena;
+gentle::ThreadPool renderThreadPool;
 
 float theta = 0.0f;
 float cameraYaw = 0.0f;
 
 bool isTeapot = false;
+bool hasCameraMovedLastStep = true;
+
+// Everything Render needs from a frame of Update. The camera before the last step too, so Render can blend between them
+struct Snapshot
+{
+	gentle::Camera<float> previousCamera;
+	gentle::Camera<float> camera;
+	gentle::Matrix4x4<float> worldMatrix;
+};
 
 void gentle::Initialize(const GameMemory &gameMemory, const RenderBuffer &renderBuffer)
 {
-	gentle::ReadObjFileToVec4("teapot.obj", mesh.triangles);
-	
 	// Using a clockwise winding convention
 	if (!isTeapot)
 	{
@@ -53,11 +71,34 @@ void gentle::Initialize(const GameMemory &gameMemory, const RenderBuffer &render
 	camera.up = { 0.0f, 1.0f, 0.0f };
 	camera.position = { 0.0f, 0.0f, 0.0f };
 	camera.direction = { 0.0f, 0.0f, 1.0f };
+
+	// Fill triangles on every core. The workers get started once here & then wait for the triangles of each frame
+	int coreCount = (int)std::thread::hardware_concurrency();
+	gentle::StartThreadPool(renderThreadPool, (coreCount > 1) ? coreCount - 1 : 0);
+	renderSettings.threadPool = &renderThreadPool;
+
+	// Scratch memory for rendering comes out of transient storage, which gets reset every frame, rather than the heap
+	frameArena = gentle::MakeMemoryArena(gameMemory.TransientStorage, gameMemory.TransientStorageSpace);
+	renderSettings.scratchArena = &frameArena;
+
+	// Share vertices between triangles so each one only gets transformed once a frame.
+	// The teapot isn't split into clusters. With only 1024 triangles its clusters curve too much for the cone test to skip many,
+	// so the vertices copied between clusters would cost more than the culling saves
+	if (isTeapot)
+	{
+		gentle::ReadObjFileToIndexedMesh("teapot.obj", indexedMesh);
+	}
+	else
+	{
+		indexedMesh = gentle::MakeIndexedMesh(mesh);
+	}
 }
 
-void gentle::UpdateAndRender(const GameMemory &gameMemory, const Input &input, const RenderBuffer &renderBuffer, float dt)
+bool gentle::Update(const GameMemory &gameMemory, const Input &input, float dt, void* snapshot)
 {
-	const uint32_t BACKGROUND_COLOR = 0x000000;
+	assert(sizeof(Snapshot) <= gameMemory.SnapshotStorageSpace);
+	Snapshot* frame = (Snapshot*)snapshot;
+	frame->previousCamera = camera;
 
 	float positionIncrement = 1.0f;
 	if (!isTeapot) positionIncrement = 0.1f;
@@ -66,13 +107,16 @@ void gentle::UpdateAndRender(const GameMemory &gameMemory, const Input &input, c
 	if (!isTeapot) zOffset = 15.0f;
 
 	// First process any change in yaw and update the camera direction
+	bool hasCameraMoved = false;
 	if (input.buttons[KEY_D].isDown)
 	{
 		cameraYaw -= yawIncrement;
+		hasCameraMoved = true;
 	}
 	else if (input.buttons[KEY_A].isDown)
 	{
 		cameraYaw += yawIncrement;
+		hasCameraMoved = true;
 	}
 
 	// Apply the camera yaw to the camera.direction vector
@@ -85,10 +129,12 @@ void gentle::UpdateAndRender(const GameMemory &gameMemory, const Input &input, c
 	if (input.buttons[KEY_S].isDown)
 	{
 		camera.position = SubtractVectors(camera.position, cameraPositionForwardBack);
+		hasCameraMoved = true;
 	}
 	else if (input.buttons[KEY_W].isDown)
 	{
 		camera.position = AddVectors(camera.position, cameraPositionForwardBack);
+		hasCameraMoved = true;
 	}
 
 	// Strafing - use the cross product between the camera direction and up to get a normal vector to the direction being faced
@@ -96,24 +142,26 @@ void gentle::UpdateAndRender(const GameMemory &gameMemory, const Input &input, c
 	if (input.buttons[KEY_LEFT].isDown)
 	{
 		camera.position = SubtractVectors(camera.position, cameraPositionStrafe);
+		hasCameraMoved = true;
 	}
 	else if (input.buttons[KEY_RIGHT].isDown)
 	{
 		camera.position = AddVectors(camera.position, cameraPositionStrafe);
+		hasCameraMoved = true;
 	}
 
 	// Simply move the camera position vertically with up/down keypress
 	if (input.buttons[KEY_DOWN].isDown)
 	{
 		camera.position.y -= positionIncrement;
+		hasCameraMoved = true;
 	}
 	else if (input.buttons[KEY_UP].isDown)
 	{
 		camera.position.y += positionIncrement;
+		hasCameraMoved = true;
 	}
 
-	gentle::ClearScreen(renderBuffer, BACKGROUND_COLOR);
-
 	theta += dt;
 	// Initialize the rotation matrices
 	gentle::Matrix4x4<float> rotationMatrixX = gentle::MakeXAxisRotationMatrix(theta);
@@ -130,5 +178,27 @@ void gentle::UpdateAndRender(const GameMemory &gameMemory, const Input &input, c
 	worldMatrix = gentle::MakeIdentityMatrix<float>();
 	worldMatrix = gentle::MultiplyMatrixWithMatrix(worldMatrix, translationMatrix);
 
-	gentle::TransformAndRenderMesh(renderBuffer, mesh, camera, worldMatrix, projectionMatrix);
+	frame->camera = camera;
+	frame->worldMatrix = worldMatrix;
+
+	// The mesh never moves, so only the camera changes the picture. Render blends from the last step's camera, so a step
+	// after the camera stops still changes what it draws
+	bool isChanged = hasCameraMoved || hasCameraMovedLastStep;
+	hasCameraMovedLastStep = hasCameraMoved;
+	return isChanged;
+}
+
+void gentle::Render(const GameMemory &gameMemory, const void* snapshot, float alpha, const RenderBuffer &renderBuffer)
+{
+	const uint32_t BACKGROUND_COLOR = 0x000000;
+	const Snapshot* frame = (const Snapshot*)snapshot;
+
+	// Blend the camera between the last two steps. A step only turns it a little, so the direction needn't be renormalized
+	gentle::Camera<float> blendedCamera = frame->camera;
+	blendedCamera.position = AddVectors(MultiplyVectorByScalar(frame->previousCamera.position, 1.0f - alpha), MultiplyVectorByScalar(frame->camera.position, alpha));
+	blendedCamera.direction = AddVectors(MultiplyVectorByScalar(frame->previousCamera.direction, 1.0f - alpha), MultiplyVectorByScalar(frame->camera.direction, alpha));
+
+	gentle::ResetMemoryArena(frameArena);
+	gentle::ClearScreenDeferred(renderBuffer, BACKGROUND_COLOR);
+	gentle::TransformAndRenderMesh(renderBuffer, indexedMesh, blendedCamera, frame->worldMatrix, projectionMatrix, renderSettings, &shadingCache);
 }
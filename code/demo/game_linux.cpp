@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../gentle_giant_linux.hpp"
+
+// game [-frames count] [-fps rate] [-output frames/%05d.ppm] [-buffers count] [-render-thread 1] [-update-hz rate] [-record session.bin] [-replay session.bin]
+//      [-allocation-free-from frame]
+int main(int argc, char** argv)
+{
+	gentle::HeadlessSettings settings = {0};
+	settings.width = 1280;
+	settings.height = 720;
+	settings.fixedDt = 1.0f / 30.0f;
+	settings.frameCount = -1;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "-frames") == 0)
+		{
+			settings.frameCount = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-fps") == 0)
+		{
+			settings.targetFPS = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-output") == 0)
+		{
+			settings.frameOutputPath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-buffers") == 0)
+		{
+			settings.renderBufferCount = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-update-hz") == 0)
+		{
+			int updateHz = atoi(argv[i + 1]);
+			settings.fixedUpdateDt = (updateHz > 0) ? (1.0f / (float)updateHz) : 0.0f;
+		}
+		else if (strcmp(argv[i], "-render-thread") == 0)
+		{
+			settings.isRenderThreaded = (atoi(argv[i + 1]) != 0);
+		}
+		else if (strcmp(argv[i], "-record") == 0)
+		{
+			settings.recordInputPath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-replay") == 0)
+		{
+			settings.replayInputPath = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-allocation-free-from") == 0)
+		{
+			settings.allocationFreeFromFrame = atoi(argv[i + 1]);
+		}
+	}
+
+	// A replay runs to its end unless told otherwise
+	if (settings.frameCount < 0)
+	{
+		settings.frameCount = (settings.replayInputPath) ? 0 : 300;
+	}
+
+	return gentle::HeadlessMain(settings);
+}
@@ -3,10 +3,10 @@
 
 int CALLBACK WinMain(HINSTANCE instance, HINSTANCE prevInstance, LPSTR commandLine, int showCode)
 {
-	gentle::WindowSettings settings;
+	gentle::WindowSettings settings = {0};
 	settings.title = "Demo";
 	settings.width = 1280;
 	settings.height = 720;
 
-	gentle::Win32Main(instance, settings);
+	return gentle::Win32Main(instance, settings);
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <algorithm>
+#include "dirty_region.hpp"
+
+namespace gentle
+{
+	bool IsPixelRectEmpty(const PixelRect &rect)
+	{
+		return (rect.x0 >= rect.x1) || (rect.y0 >= rect.y1);
+	}
+
+	PixelRect IntersectPixelRects(const PixelRect &a, const PixelRect &b)
+	{
+		return PixelRect { std::max(a.x0, b.x0), std::max(a.y0, b.y0), std::min(a.x1, b.x1), std::min(a.y1, b.y1) };
+	}
+
+	static PixelRect UnitePixelRects(const PixelRect &a, const PixelRect &b)
+	{
+		return PixelRect { std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+	}
+
+	static int64_t GetArea(const PixelRect &rect)
+	{
+		return (int64_t)(rect.x1 - rect.x0) * (int64_t)(rect.y1 - rect.y0);
+	}
+
+	// The first rect in the region that overlaps rect, or -1 when none do
+	static int FindOverlappingRect(const DirtyRegion &region, const PixelRect &rect)
+	{
+		for (int i = 0; i < region.rectCount; i += 1)
+		{
+			if (!IsPixelRectEmpty(IntersectPixelRects(region.rects[i], rect)))
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	// Clean pixels the smallest rect around both a & b takes in, for a & b that don't overlap
+	static int64_t GetMergeWaste(const PixelRect &a, const PixelRect &b)
+	{
+		return GetArea(UnitePixelRects(a, b)) - GetArea(a) - GetArea(b);
+	}
+
+	/**
+	 * The pair that wastes the fewest pixels when merged, out of the rects in the region & rect. Sets second to -1 when the
+	 * cheapest pair is rect & the region's rect first
+	 */
+	static void FindCheapestMerge(const DirtyRegion &region, const PixelRect &rect, int &first, int &second)
+	{
+		int64_t cheapestWaste = INT64_MAX;
+		for (int i = 0; i < region.rectCount; i += 1)
+		{
+			int64_t waste = GetMergeWaste(region.rects[i], rect);
+			if (waste < cheapestWaste)
+			{
+				first = i;
+				second = -1;
+				cheapestWaste = waste;
+			}
+			for (int j = i + 1; j < region.rectCount; j += 1)
+			{
+				waste = GetMergeWaste(region.rects[i], region.rects[j]);
+				if (waste < cheapestWaste)
+				{
+					first = i;
+					second = j;
+					cheapestWaste = waste;
+				}
+			}
+		}
+	}
+
+	static void RemoveRect(DirtyRegion &region, int index)
+	{
+		region.rects[index] = region.rects[region.rectCount - 1];
+		region.rectCount -= 1;
+	}
+
+	void ResetDirtyRegion(DirtyRegion &region)
+	{
+		region.rectCount = 0;
+	}
+
+	void AddDirtyRect(DirtyRegion &region, const PixelRect &rect)
+	{
+		if (IsPixelRectEmpty(rect))
+		{
+			return;
+		}
+
+		// Merging can make the rect overlap others it didn't before, so keep going until it overlaps none & there's room for it.
+		// Each merge takes a rect out of the region, so this always ends
+		PixelRect merged = rect;
+		while (true)
+		{
+			int other = FindOverlappingRect(region, merged);
+			if ((other < 0) && (region.rectCount < MAX_DIRTY_RECTS))
+			{
+				break;
+			}
+			if (other >= 0)
+			{
+				merged = UnitePixelRects(merged, region.rects[other]);
+				RemoveRect(region, other);
+				continue;
+			}
+
+			int first = 0;
+			int second = -1;
+			FindCheapestMerge(region, merged, first, second);
+			if (second < 0)
+			{
+				merged = UnitePixelRects(merged, region.rects[first]);
+				RemoveRect(region, first);
+				continue;
+			}
+
+			// Two of the region's own rects are closer than rect is to any of them. Their merged rect can overlap others, so it
+			// goes back in like a new one, with room to spare now both are out
+			PixelRect pair = UnitePixelRects(region.rects[first], region.rects[second]);
+			RemoveRect(region, second);
+			RemoveRect(region, first);
+			AddDirtyRect(region, pair);
+		}
+		region.rects[region.rectCount] = merged;
+		region.rectCount += 1;
+	}
+
+	void MarkAllDirty(DirtyRegion &region, int width, int height)
+	{
+		ResetDirtyRegion(region);
+		AddDirtyRect(region, PixelRect { 0, 0, width, height });
+	}
+}
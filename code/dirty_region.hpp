@@ -0,0 +1,45 @@
+#ifndef GENTLE_DIRTY_REGION_H
+#define GENTLE_DIRTY_REGION_H
+
+namespace gentle
+{
+	/**
+	 * Rectangle of pixel ordinals. x0 & y0 are inclusive, x1 & y1 are exclusive.
+	 * i.e. the rect { 0, 0, 2, 2 } covers the pixels (0, 0), (1, 0), (0, 1) & (1, 1)
+	 */
+	struct PixelRect
+	{
+		int x0;
+		int y0;
+		int x1;
+		int y1;
+	};
+
+	const int MAX_DIRTY_RECTS = 16;
+
+	/**
+	 * The parts of a render buffer that have been drawn to since the region was last reset, so presenting the buffer can
+	 * skip the rest of it. Rects that overlap get merged into one. Once there are MAX_DIRTY_RECTS of them, so do whichever
+	 * pair wastes the fewest pixels, out of the rects already there & the new one. The rects never overlap & cover every
+	 * pixel drawn, plus maybe a few more.
+	 */
+	struct DirtyRegion
+	{
+		PixelRect rects[MAX_DIRTY_RECTS];
+		int rectCount;
+	};
+
+	bool IsPixelRectEmpty(const PixelRect &rect);
+
+	// The pixels in both a & b. Empty when they don't overlap
+	PixelRect IntersectPixelRects(const PixelRect &a, const PixelRect &b);
+
+	void ResetDirtyRegion(DirtyRegion &region);
+
+	void AddDirtyRect(DirtyRegion &region, const PixelRect &rect);
+
+	// Mark the whole of a width x height buffer dirty, e.g. when it's just been allocated & holds nothing worth showing
+	void MarkAllDirty(DirtyRegion &region, int width, int height);
+}
+
+#endif
@@ -0,0 +1,106 @@
+#include "dirty_region.hpp"
+#include <assert.h>
+
+static int CountDirtyPixels(const gentle::DirtyRegion &region)
+{
+	int pixelCount = 0;
+	for (int i = 0; i < region.rectCount; i += 1)
+	{
+		const gentle::PixelRect &rect = region.rects[i];
+		pixelCount += (rect.x1 - rect.x0) * (rect.y1 - rect.y0);
+	}
+	return pixelCount;
+}
+
+static bool IsPixelDirty(const gentle::DirtyRegion &region, int x, int y)
+{
+	for (int i = 0; i < region.rectCount; i += 1)
+	{
+		const gentle::PixelRect &rect = region.rects[i];
+		if ((x >= rect.x0) && (x < rect.x1) && (y >= rect.y0) && (y < rect.y1))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void RunDirtyRegionTests()
+{
+	gentle::DirtyRegion region;
+	gentle::ResetDirtyRegion(region);
+
+	// Empty rects add nothing, rects apart stay apart
+	gentle::AddDirtyRect(region, gentle::PixelRect { 5, 5, 5, 10 });
+	assert(region.rectCount == 0);
+	gentle::AddDirtyRect(region, gentle::PixelRect { 0, 0, 2, 2 });
+	gentle::AddDirtyRect(region, gentle::PixelRect { 10, 0, 12, 2 });
+	assert(region.rectCount == 2);
+	assert(CountDirtyPixels(region) == 8);
+
+	// A rect overlapping both merges them all, & one inside it adds nothing
+	gentle::AddDirtyRect(region, gentle::PixelRect { 1, 1, 11, 3 });
+	assert(region.rectCount == 1);
+	assert(CountDirtyPixels(region) == 12 * 3);
+	gentle::AddDirtyRect(region, gentle::PixelRect { 4, 1, 6, 2 });
+	assert(region.rectCount == 1);
+
+	// Once it's full, the closest rects get merged rather than one being lost
+	gentle::ResetDirtyRegion(region);
+	for (int i = 0; i < gentle::MAX_DIRTY_RECTS; i += 1)
+	{
+		gentle::AddDirtyRect(region, gentle::PixelRect { i * 10, 0, (i * 10) + 1, 1 });
+	}
+	assert(region.rectCount == gentle::MAX_DIRTY_RECTS);
+	gentle::AddDirtyRect(region, gentle::PixelRect { 2, 0, 3, 1 });
+	assert(region.rectCount == gentle::MAX_DIRTY_RECTS);
+	assert(CountDirtyPixels(region) == gentle::MAX_DIRTY_RECTS + 2);
+	for (int i = 0; i < gentle::MAX_DIRTY_RECTS; i += 1)
+	{
+		assert(IsPixelDirty(region, i * 10, 0));
+	}
+	assert(IsPixelDirty(region, 2, 0));
+	assert(!IsPixelDirty(region, 5, 0));
+
+	// When two of its rects are closer to each other than a new rect is to any of them, those two get merged instead
+	gentle::ResetDirtyRegion(region);
+	for (int i = 0; i < gentle::MAX_DIRTY_RECTS; i += 1)
+	{
+		int x = (i == 1) ? 2 : (i * 10);
+		gentle::AddDirtyRect(region, gentle::PixelRect { x, 0, x + 1, 1 });
+	}
+	gentle::AddDirtyRect(region, gentle::PixelRect { 1000, 0, 1001, 1 });
+	assert(region.rectCount == gentle::MAX_DIRTY_RECTS);
+	assert(CountDirtyPixels(region) == gentle::MAX_DIRTY_RECTS + 2);
+	assert(IsPixelDirty(region, 1, 0) && IsPixelDirty(region, 1000, 0));
+	assert(!IsPixelDirty(region, 999, 0));
+
+	// The merged pair goes back in like a new rect, so it takes in any rect it now overlaps. Here the two squares merge across
+	// the gap between them, into the wide rect lying in that gap
+	gentle::ResetDirtyRegion(region);
+	gentle::AddDirtyRect(region, gentle::PixelRect { 0, 0, 10, 10 });
+	gentle::AddDirtyRect(region, gentle::PixelRect { 0, 11, 10, 21 });
+	gentle::AddDirtyRect(region, gentle::PixelRect { -5, 10, 15, 11 });
+	for (int i = 3; i < gentle::MAX_DIRTY_RECTS; i += 1)
+	{
+		gentle::AddDirtyRect(region, gentle::PixelRect { i * 100, 0, (i * 100) + 1, 1 });
+	}
+	gentle::AddDirtyRect(region, gentle::PixelRect { 5000, 0, 5001, 1 });
+	assert(region.rectCount == gentle::MAX_DIRTY_RECTS - 1);
+	assert(IsPixelDirty(region, -5, 0) && IsPixelDirty(region, 14, 20) && IsPixelDirty(region, 5000, 0));
+	for (int i = 0; i < region.rectCount; i += 1)
+	{
+		for (int j = i + 1; j < region.rectCount; j += 1)
+		{
+			assert(gentle::IsPixelRectEmpty(gentle::IntersectPixelRects(region.rects[i], region.rects[j])));
+		}
+	}
+
+	gentle::MarkAllDirty(region, 4, 3);
+	assert(region.rectCount == 1);
+	assert(CountDirtyPixels(region) == 12);
+
+	gentle::PixelRect overlap = gentle::IntersectPixelRects(gentle::PixelRect { 0, 0, 4, 4 }, gentle::PixelRect { 2, 3, 8, 8 });
+	assert((overlap.x0 == 2) && (overlap.y0 == 3) && (overlap.x1 == 4) && (overlap.y1 == 4));
+	assert(gentle::IsPixelRectEmpty(gentle::IntersectPixelRects(gentle::PixelRect { 0, 0, 4, 4 }, gentle::PixelRect { 4, 0, 8, 4 })));
+}
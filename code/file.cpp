@@ -1,5 +1,6 @@
 #include <fstream>
-#include <strstream>
+#include <math.h>
+#include <stdlib.h>
 #include <string>
 #include <iostream>
 #include <vector>
@@ -7,9 +8,55 @@
 
 namespace gentle
 {
+	/**
+	 * Read count numbers separated by spaces from text, e.g. the "1.0 2.0 3.0" after the 'v' of a vertex line. Parsing in place
+	 * rather than through a string stream means reading a line doesn't allocate anything. False when there are fewer numbers,
+	 * or one of them is followed by something other than a space, e.g. the "/2/3" of a face corner with texture co-ordinates.
+	 */
+	static bool ParseObjNumbers(const char* text, double* numbers, int count)
+	{
+		for (int i = 0; i < count; i += 1)
+		{
+			char* end;
+			numbers[i] = strtod(text, &end);
+			if ((end == text) || (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\r'))
+			{
+				return false;
+			}
+			text = end;
+		}
+		return true;
+	}
+
+	// Whether line starts with the keyword of type, e.g. 'v' for a vertex but not "vn" for a vertex normal
+	static bool IsObjLineOfType(const std::string &line, char type)
+	{
+		return (line.size() > 1) && (line[0] == type) && (line[1] == ' ' || line[1] == '\t');
+	}
+
+	// Read the 1-indexed vertices of a face line, as indices from 0. False unless all three are vertices read so far
+	static bool ParseObjFace(const std::string &line, size_t vertexCount, uint32_t* indices)
+	{
+		double points[3];
+		if (!ParseObjNumbers(line.c_str() + 1, points, 3))
+		{
+			return false;
+		}
+		for (int i = 0; i < 3; i += 1)
+		{
+			if (!(points[i] >= 1.0) || !(points[i] <= (double)vertexCount) || (points[i] != floor(points[i])))
+			{
+				return false;
+			}
+			indices[i] = (uint32_t)points[i] - 1;
+		}
+		return true;
+	}
+
 	template<typename T>
-	bool ReadObjFileToVec4(std::string const &filename, std::vector<gentle::Triangle4d<T>> &triangles)
+	bool ReadObjFileToVec4(std::string const &filename, std::vector<gentle::Triangle4d<T>> &triangles, MemoryArena* scratchArena)
 	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_FILE);
 		std::ifstream objFile;
 		objFile.open(filename);
 		if (!objFile.is_open())
@@ -17,32 +64,35 @@ namespace gentle
 			return false;
 		}
 
-		std::vector<gentle::Vec4<T>> vertices;
+		// The vertices are only needed until every triangle has been read
+		ScopedArenaMark scratch(scratchArena);
+		ArenaAllocator<gentle::Vec4<T>> allocator(scratchArena);
+		std::vector<gentle::Vec4<T>, ArenaAllocator<gentle::Vec4<T>>> vertices(allocator);
 
-		while (!objFile.eof())
+		std::string line;
+		while (std::getline(objFile, line))
 		{
-			char junk;
-			std::string line;
-			std::getline(objFile, line);
-
-			std::strstream stringStream;
-			stringStream << line;
-
-			if (line[0] == 'v')
+			if (IsObjLineOfType(line, 'v'))
 			{
-				gentle::Vec4<T> vertex;
 				// expect line to have syntax 'v x y z' where x, y & z are the ordinals of the point position
-				stringStream >> junk >> vertex.x >> vertex.y >> vertex.z;
-				vertex.w = (T)1.0;
+				double position[3];
+				if (!ParseObjNumbers(line.c_str() + 1, position, 3))
+				{
+					return false;
+				}
+				gentle::Vec4<T> vertex = { (T)position[0], (T)position[1], (T)position[2], (T)1.0 };
 				vertices.push_back(vertex);
 			}
 
-			if (line[0] == 'f')
+			if (IsObjLineOfType(line, 'f'))
 			{
-				int points[3];
-				stringStream >> junk >> points[0] >> points[1] >> points[2];
 				// expect line to have syntax 'f 1 2 3' where 1, 2 & 3 are the 1-indexed positions of the points in the file
-				gentle::Triangle4d<T> newTriangle = { vertices[points[0] - 1], vertices[points[1] - 1], vertices[points[2] - 1] };
+				uint32_t indices[3];
+				if (!ParseObjFace(line, vertices.size(), indices))
+				{
+					return false;
+				}
+				gentle::Triangle4d<T> newTriangle = { vertices[indices[0]], vertices[indices[1]], vertices[indices[2]] };
 				triangles.push_back(newTriangle);
 			}
 		}
@@ -51,7 +101,69 @@ namespace gentle
 
 		return true;
 	}
-	template bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<int>> &triangles);
-	template bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<float>> &triangles);
-	template bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<double>> &triangles);
+	template bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<int>> &triangles, MemoryArena* scratchArena);
+	template bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<float>> &triangles, MemoryArena* scratchArena);
+	template bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<double>> &triangles, MemoryArena* scratchArena);
+
+	template<typename T>
+	bool ReadObjFileToVec4(std::string const &filename, Mesh<T> &mesh, MemoryArena* scratchArena)
+	{
+		if (!ReadObjFileToVec4(filename, mesh.triangles, scratchArena))
+		{
+			return false;
+		}
+		ComputeBounds(mesh);
+		return true;
+	}
+	template bool ReadObjFileToVec4(std::string const &filename, Mesh<float> &mesh, MemoryArena* scratchArena);
+
+	template<typename T>
+	bool ReadObjFileToIndexedMesh(std::string const &filename, IndexedMesh<T> &mesh)
+	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_FILE);
+		std::ifstream objFile;
+		objFile.open(filename);
+		if (!objFile.is_open())
+		{
+			return false;
+		}
+
+		std::string line;
+		while (std::getline(objFile, line))
+		{
+			if (IsObjLineOfType(line, 'v'))
+			{
+				// expect line to have syntax 'v x y z' where x, y & z are the ordinals of the point position
+				double position[3];
+				if (!ParseObjNumbers(line.c_str() + 1, position, 3))
+				{
+					return false;
+				}
+				mesh.vertices.x.push_back((T)position[0]);
+				mesh.vertices.y.push_back((T)position[1]);
+				mesh.vertices.z.push_back((T)position[2]);
+			}
+
+			if (IsObjLineOfType(line, 'f'))
+			{
+				// expect line to have syntax 'f 1 2 3' where 1, 2 & 3 are the 1-indexed positions of the points in the file
+				uint32_t indices[3];
+				if (!ParseObjFace(line, mesh.vertices.x.size(), indices))
+				{
+					return false;
+				}
+				mesh.indices.push_back(indices[0]);
+				mesh.indices.push_back(indices[1]);
+				mesh.indices.push_back(indices[2]);
+			}
+		}
+
+		objFile.close();
+
+		ComputeFaceNormals(mesh);
+		ComputeBounds(mesh);
+
+		return true;
+	}
+	template bool ReadObjFileToIndexedMesh(std::string const &filename, IndexedMesh<float> &mesh);
 }
\ No newline at end of file
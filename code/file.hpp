@@ -4,11 +4,25 @@
 #include <string>
 #include <vector>
 #include "geometry.hpp"
+#include "memory.hpp"
 
 namespace gentle
 {
+	// The vertices only get kept while the triangles are read, in scratchArena when there is one. False when the file can't
+	// be opened, or has a vertex without three numbers or a face that isn't three of the vertices before it, e.g. "f 1/2/3 ..."
 	template<typename T>
-	bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<T>> &triangles);
+	bool ReadObjFileToVec4(std::string const &filename, std::vector<Triangle4d<T>> &triangles, MemoryArena* scratchArena = nullptr);
+
+	// Same again, but into mesh.triangles, & then works out the mesh's bounds so it can get culled as a whole
+	template<typename T>
+	bool ReadObjFileToVec4(std::string const &filename, Mesh<T> &mesh, MemoryArena* scratchArena = nullptr);
+
+	/**
+	 * Read an OBJ file keeping each 'v' line as one vertex & each 'f' line as three indices into them, rather than copying
+	 * the vertices into every triangle that uses them. Fails on the same files as ReadObjFileToVec4, so every index is in range.
+	 */
+	template<typename T>
+	bool ReadObjFileToIndexedMesh(std::string const &filename, IndexedMesh<T> &mesh);
 }
 
 #endif
\ No newline at end of file
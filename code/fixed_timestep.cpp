@@ -0,0 +1,64 @@
+#include <assert.h>
+#include "fixed_timestep.hpp"
+
+namespace gentle
+{
+	// Frame times that are a whole number of steps, like 1/30 s at 1/60 s steps, can come out a hair short in float.
+	// Counting anything this close to a step as a whole one stops that from alternating between 1 & 3 steps a frame
+	static const float STEP_TOLERANCE = 0.001f;
+
+	FixedTimestep MakeFixedTimestep(float stepSeconds, int maxStepsPerFrame)
+	{
+		assert((stepSeconds > 0.0f) && (maxStepsPerFrame >= 1));
+
+		FixedTimestep timestep = {};
+		timestep.stepSeconds = stepSeconds;
+		timestep.maxStepsPerFrame = maxStepsPerFrame;
+		timestep.accumulatedSeconds = stepSeconds;
+		return timestep;
+	}
+
+	int AdvanceFixedTimestep(FixedTimestep &timestep, float frameSeconds)
+	{
+		timestep.accumulatedSeconds += frameSeconds;
+
+		int steps = 0;
+		float wholeStepSeconds = timestep.stepSeconds * (1.0f - STEP_TOLERANCE);
+		while (timestep.accumulatedSeconds >= wholeStepSeconds)
+		{
+			timestep.accumulatedSeconds -= timestep.stepSeconds;
+			if (steps < timestep.maxStepsPerFrame)
+			{
+				steps += 1;
+			}
+			else
+			{
+				timestep.droppedStepCount += 1;
+			}
+		}
+		timestep.accumulatedSeconds = (timestep.accumulatedSeconds > 0.0f) ? timestep.accumulatedSeconds : 0.0f;
+
+		timestep.stepCount += steps;
+		return steps;
+	}
+
+	float GetFixedTimestepAlpha(const FixedTimestep &timestep)
+	{
+		float alpha = timestep.accumulatedSeconds / timestep.stepSeconds;
+		return (alpha < 1.0f) ? alpha : 1.0f;
+	}
+
+	Input MakeRepeatedStepInput(const Input &input)
+	{
+		Input repeated = input;
+		for (int i = 0; i < BUTTON_COUNT; i += 1)
+		{
+			if (repeated.buttons[i].keyUp)
+			{
+				repeated.buttons[i].wasDown = false;
+				repeated.buttons[i].keyUp = false;
+			}
+		}
+		return repeated;
+	}
+}
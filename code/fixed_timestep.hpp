@@ -0,0 +1,35 @@
+#ifndef GENTLE_FIXED_TIMESTEP_H
+#define GENTLE_FIXED_TIMESTEP_H
+
+#include "platform.hpp"
+
+namespace gentle
+{
+	/**
+	 * Turns variable frame times into a whole number of equal simulation steps, carrying the remainder over to the next
+	 * frame. Every step sees the same dt however the frames run, so a slow frame means more steps rather than a bigger one,
+	 * & the render can blend the last two steps by how far into the next one the clock already is.
+	 */
+	struct FixedTimestep
+	{
+		float stepSeconds;
+		int maxStepsPerFrame;	// Catch up no further than this after a stall, so a slow frame can't cause more slow frames
+		float accumulatedSeconds;	// Time not simulated yet. Less than a step once a frame's steps are taken
+		int stepCount;
+		int droppedStepCount;	// Steps skipped when a frame fell further behind than maxStepsPerFrame could make up
+	};
+
+	// Starts with a whole step in hand, so the first frame always has a step to draw
+	FixedTimestep MakeFixedTimestep(float stepSeconds, int maxStepsPerFrame);
+
+	// Add the time a frame took & return how many steps to simulate for it, which may be none
+	int AdvanceFixedTimestep(FixedTimestep &timestep, float frameSeconds);
+
+	// How far the clock is from the last step to the next, from 0 to 1, for the render to interpolate by
+	float GetFixedTimestepAlpha(const FixedTimestep &timestep);
+
+	// The input for every step of a frame after the first. Buttons are still held, but a release only gets seen once
+	Input MakeRepeatedStepInput(const Input &input);
+}
+
+#endif
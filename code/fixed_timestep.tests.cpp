@@ -0,0 +1,50 @@
+#include "fixed_timestep.hpp"
+#include <assert.h>
+#include <math.h>
+
+void RunFixedTimestepTests()
+{
+	// Frames of exactly two steps always take two, however float rounds 1/30 & 1/60
+	gentle::FixedTimestep timestep = gentle::MakeFixedTimestep(1.0f / 60.0f, 5);
+	assert(gentle::AdvanceFixedTimestep(timestep, 0.0f) == 1);
+	for (int frame = 0; frame < 1000; frame += 1)
+	{
+		assert(gentle::AdvanceFixedTimestep(timestep, 1.0f / 30.0f) == 2);
+	}
+	assert(timestep.stepCount == 2001);
+	assert(gentle::GetFixedTimestepAlpha(timestep) < 0.01f);
+
+	// Frames shorter than a step take one now & then, & the alpha tracks the time left over
+	timestep = gentle::MakeFixedTimestep(1.0f / 60.0f, 5);
+	gentle::AdvanceFixedTimestep(timestep, 0.0f);
+	int steps = 0;
+	for (int frame = 0; frame < 150; frame += 1)
+	{
+		int frameSteps = gentle::AdvanceFixedTimestep(timestep, 1.0f / 150.0f);
+		assert((frameSteps == 0) || (frameSteps == 1));
+		steps += frameSteps;
+
+		float alpha = gentle::GetFixedTimestepAlpha(timestep);
+		assert((alpha >= 0.0f) && (alpha < 1.0f));
+		assert(fabsf(alpha - (timestep.accumulatedSeconds * 60.0f)) < 0.0001f);
+	}
+	assert((steps >= 59) && (steps <= 60));
+
+	// A one second stall only catches up the capped number of steps, & the rest of the time is dropped
+	timestep = gentle::MakeFixedTimestep(1.0f / 60.0f, 5);
+	gentle::AdvanceFixedTimestep(timestep, 0.0f);
+	assert(gentle::AdvanceFixedTimestep(timestep, 1.0f) == 5);
+	assert(timestep.droppedStepCount == 55);
+	assert(timestep.accumulatedSeconds < timestep.stepSeconds);
+	assert(gentle::AdvanceFixedTimestep(timestep, 1.0f / 60.0f) == 1);
+
+	// Every step of a frame sees a held button, but only the first sees it let go
+	Input input = {};
+	input.buttons[KEY_A].isDown = true;
+	input.buttons[KEY_B].wasDown = true;
+	input.buttons[KEY_B].keyUp = true;
+	Input repeated = gentle::MakeRepeatedStepInput(input);
+	assert(repeated.buttons[KEY_A].isDown);
+	assert(!repeated.buttons[KEY_B].keyUp && !repeated.buttons[KEY_B].wasDown);
+	assert(input.buttons[KEY_B].keyUp);
+}
@@ -0,0 +1,98 @@
+#include <math.h>
+#include "frame_pacing.hpp"
+
+namespace gentle
+{
+	// Recent sleeps count most, so the estimate follows the machine as its load changes
+	static const int SLEEP_STEP_HISTORY = 64;
+
+	FramePacer MakeFramePacer(double targetSecondsPerFrame)
+	{
+		FramePacer pacer = {};
+		pacer.targetSecondsPerFrame = targetSecondsPerFrame;
+		pacer.sleepStepSeconds = 0.001;
+
+		// Start out expecting a 1 ms sleep to take anywhere up to 4 ms, until there are measurements to go on
+		pacer.sleepStepMean = 0.002;
+		pacer.sleepStepVariance = 0.001 * 0.001;
+		pacer.sleepStepCount = 1;
+		return pacer;
+	}
+
+	static void MeasureSleepStep(FramePacer &pacer, double seconds)
+	{
+		if (pacer.sleepStepCount < SLEEP_STEP_HISTORY)
+		{
+			pacer.sleepStepCount += 1;
+		}
+		double weight = 1.0 / (double)pacer.sleepStepCount;
+		double difference = seconds - pacer.sleepStepMean;
+		pacer.sleepStepMean += weight * difference;
+		pacer.sleepStepVariance = (1.0 - weight) * (pacer.sleepStepVariance + (weight * difference * difference));
+	}
+
+	static void MissFrame(FramePacer &pacer, double secondsLate)
+	{
+		pacer.stats.missedFrameCount += 1;
+		pacer.stats.worstMissSeconds = (secondsLate > pacer.stats.worstMissSeconds) ? secondsLate : pacer.stats.worstMissSeconds;
+	}
+
+	bool WaitForFrameEnd(FramePacer &pacer, const PacingClock &clock, double frameStartSeconds)
+	{
+		pacer.stats.frameCount += 1;
+
+		double targetSeconds = frameStartSeconds + pacer.targetSecondsPerFrame;
+		double now = clock.getSeconds();
+		if (now >= targetSeconds)
+		{
+			MissFrame(pacer, now - targetSeconds);
+			return true;
+		}
+
+		if (clock.sleep)
+		{
+			// Two standard deviations covers all but the odd slow wake up, without spinning much longer than a step
+			while ((targetSeconds - now) > (pacer.sleepStepMean + (2.0 * sqrt(pacer.sleepStepVariance))))
+			{
+				clock.sleep(pacer.sleepStepSeconds);
+				double afterSleep = clock.getSeconds();
+				MeasureSleepStep(pacer, afterSleep - now);
+				pacer.stats.sleepSeconds += afterSleep - now;
+				now = afterSleep;
+			}
+
+			if (now > targetSeconds)
+			{
+				MissFrame(pacer, now - targetSeconds);
+				return true;
+			}
+		}
+
+		double spinStart = now;
+		while (now < targetSeconds)
+		{
+			now = clock.getSeconds();
+		}
+		pacer.stats.spinSeconds += now - spinStart;
+		return false;
+	}
+
+	void SleepUntilFrameEnd(FramePacer &pacer, const PacingClock &clock, double frameStartSeconds)
+	{
+		if (!clock.sleep)
+		{
+			WaitForFrameEnd(pacer, clock, frameStartSeconds);
+			return;
+		}
+
+		// Nothing is shown, so an idle frame that ends late doesn't count as missed
+		pacer.stats.frameCount += 1;
+		double now = clock.getSeconds();
+		double remainingSeconds = (frameStartSeconds + pacer.targetSecondsPerFrame) - now;
+		if (remainingSeconds > 0.0)
+		{
+			clock.sleep(remainingSeconds);
+			pacer.stats.sleepSeconds += clock.getSeconds() - now;
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef GENTLE_FRAME_PACING_H
+#define GENTLE_FRAME_PACING_H
+
+namespace gentle
+{
+	/**
+	 * The platform's clock. sleep may overshoot by any amount, & is nullptr where sleeping isn't granular enough to be used,
+	 * leaving the pacer to spin.
+	 */
+	struct PacingClock
+	{
+		double (*getSeconds)();
+		void (*sleep)(double seconds);
+	};
+
+	struct FramePacingStats
+	{
+		int frameCount;
+		int missedFrameCount;	// Frames that ended after their target time, because the work or a sleep overran
+		double worstMissSeconds;
+		double sleepSeconds;
+		double spinSeconds;
+	};
+
+	/**
+	 * Waits out the rest of each frame by sleeping in short steps while even a slow step would wake in time, then spinning
+	 * until the target. How long a step really takes gets measured every time, so the spin only has to cover the sleep's
+	 * actual overshoot on this machine rather than a guess.
+	 */
+	struct FramePacer
+	{
+		double targetSecondsPerFrame;
+		double sleepStepSeconds;
+		double sleepStepMean;	// Measured seconds a sleep step really takes
+		double sleepStepVariance;
+		int sleepStepCount;
+		FramePacingStats stats;
+	};
+
+	FramePacer MakeFramePacer(double targetSecondsPerFrame);
+
+	// Wait until targetSecondsPerFrame after frameStartSeconds. Returns true when the frame missed its target
+	bool WaitForFrameEnd(FramePacer &pacer, const PacingClock &clock, double frameStartSeconds);
+
+	// For frames that show nothing, so needn't end exactly on time. Sleeps the whole wait without the spin, & may end late
+	void SleepUntilFrameEnd(FramePacer &pacer, const PacingClock &clock, double frameStartSeconds);
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include "frame_pacing.hpp"
+#include <assert.h>
+#include <math.h>
+
+// A pretend clock that ticks a microsecond every time it's read, with sleeps that always take a set time longer than asked
+static double fakeSeconds = 0.0;
+static double fakeSleepOvershoot = 0.0;
+
+static double GetFakeSeconds()
+{
+	fakeSeconds += 0.000001;
+	return fakeSeconds;
+}
+
+static void FakeSleep(double seconds)
+{
+	fakeSeconds += seconds + fakeSleepOvershoot;
+}
+
+void RunFramePacingTests()
+{
+	const double targetSecondsPerFrame = 1.0 / 60.0;
+	gentle::PacingClock clock = { GetFakeSeconds, FakeSleep };
+
+	// Once it has measured the overshoot, frames end right on time, mostly sleeping & only spinning out the overshoot
+	fakeSeconds = 0.0;
+	fakeSleepOvershoot = 0.0009;
+	gentle::FramePacer pacer = gentle::MakeFramePacer(targetSecondsPerFrame);
+	double frameStart = GetFakeSeconds();
+	for (int frame = 0; frame < 100; frame += 1)
+	{
+		fakeSeconds += 0.005;
+		assert(!gentle::WaitForFrameEnd(pacer, clock, frameStart));
+		double frameEnd = GetFakeSeconds();
+		assert(frameEnd >= frameStart + targetSecondsPerFrame);
+		assert(frameEnd < frameStart + targetSecondsPerFrame + 0.00001);
+		frameStart = frameEnd;
+	}
+	assert(pacer.stats.frameCount == 100);
+	assert(pacer.stats.missedFrameCount == 0);
+	assert(fabs(pacer.sleepStepMean - 0.0019) < 0.00001);
+	assert(pacer.stats.spinSeconds < 100 * 0.0021);
+	assert(pacer.stats.sleepSeconds > 100 * 0.009);
+
+	// A frame whose work overruns is missed without waiting at all
+	double sleepSeconds = pacer.stats.sleepSeconds;
+	fakeSeconds += 0.020;
+	assert(gentle::WaitForFrameEnd(pacer, clock, frameStart));
+	assert(pacer.stats.missedFrameCount == 1);
+	assert(fabs(pacer.stats.worstMissSeconds - (0.020 - targetSecondsPerFrame)) < 0.00001);
+	assert(pacer.stats.sleepSeconds == sleepSeconds);
+
+	// So is one where a sleep takes far longer than it ever has before
+	frameStart = GetFakeSeconds();
+	fakeSleepOvershoot = 0.020;
+	assert(gentle::WaitForFrameEnd(pacer, clock, frameStart));
+	assert(pacer.stats.missedFrameCount == 2);
+
+	// An idle frame sleeps the whole way, ending as late as the sleep overshoots
+	fakeSeconds = 0.0;
+	fakeSleepOvershoot = 0.0009;
+	pacer = gentle::MakeFramePacer(targetSecondsPerFrame);
+	frameStart = GetFakeSeconds();
+	gentle::SleepUntilFrameEnd(pacer, clock, frameStart);
+	double idleFrameEnd = GetFakeSeconds();
+	assert((idleFrameEnd >= frameStart + targetSecondsPerFrame) && (idleFrameEnd < frameStart + targetSecondsPerFrame + 0.001));
+	assert(pacer.stats.spinSeconds == 0.0);
+	assert((pacer.stats.frameCount == 1) && (pacer.stats.missedFrameCount == 0));
+
+	// Without sleep the pacer spins the whole wait, & is just as accurate
+	fakeSeconds = 0.0;
+	pacer = gentle::MakeFramePacer(targetSecondsPerFrame);
+	gentle::PacingClock spinningClock = { GetFakeSeconds, nullptr };
+	frameStart = GetFakeSeconds();
+	assert(!gentle::WaitForFrameEnd(pacer, spinningClock, frameStart));
+	double frameEnd = GetFakeSeconds();
+	assert((frameEnd >= frameStart + targetSecondsPerFrame) && (frameEnd < frameStart + targetSecondsPerFrame + 0.00001));
+	assert(pacer.stats.sleepSeconds == 0.0);
+}
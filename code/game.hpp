@@ -4,7 +4,18 @@
 namespace gentle
 {
 	void Initialize(const GameMemory &gameMemory, const RenderBuffer &renderBuffer);
-	void UpdateAndRender(const GameMemory &gameMemory, const Input &input, const RenderBuffer &renderBuffer, float dt);
+
+	// Advance the game by dt & write everything Render needs into snapshot, which is GameMemory.SnapshotStorageSpace bytes.
+	// Returns whether the snapshot would draw any differently than the last one did, at any alpha. When it wouldn't, the
+	// platform can skip rendering & presenting the frame altogether
+	bool Update(const GameMemory &gameMemory, const Input &input, float dt, void* snapshot);
+
+	// Draw a snapshot Update wrote, without changing any game state. The platform may call this on its own thread, at the
+	// same time as the next Update, so it gets transient storage to itself & Update must not touch it.
+	// With fixed timesteps, alpha is how far the clock has got from the last Update towards the next one, for drawing moving
+	// things part way along. It's 1 when every frame gets exactly one Update.
+	// When renderBuffer has a dirtyRegion, only the pixels in it need redrawing, see present_queue.hpp. Without one, draw everything
+	void Render(const GameMemory &gameMemory, const void* snapshot, float alpha, const RenderBuffer &renderBuffer);
 }
 
 #endif
\ No newline at end of file
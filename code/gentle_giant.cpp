@@ -1,4 +1,12 @@
+#include "dirty_region.cpp"
 #include "file.cpp"
+#include "fixed_timestep.cpp"
+#include "frame_pacing.cpp"
 #include "geometry.cpp"
+#include "input_recording.cpp"
 #include "math.cpp"
-#include "software_rendering.cpp"
\ No newline at end of file
+#include "memory.cpp"
+#include "present_queue.cpp"
+#include "snapshot_queue.cpp"
+#include "software_rendering.cpp"
+#include "thread_pool.cpp"
\ No newline at end of file
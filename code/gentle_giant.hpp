@@ -1,12 +1,20 @@
 #ifndef GENTLE_GIANT_H
 #define GENTLE_GIANT_H
 
+#include "dirty_region.hpp"
 #include "file.hpp"
+#include "fixed_timestep.hpp"
+#include "frame_pacing.hpp"
 #include "geometry.hpp"
+#include "input_recording.hpp"
 #include "math.hpp"
+#include "memory.hpp"
 #include "collision.hpp"
 #include "platform.hpp"
+#include "present_queue.hpp"
+#include "snapshot_queue.hpp"
 #include "software_rendering.hpp"
+#include "thread_pool.hpp"
 #include "game.hpp"
 
 #endif
\ No newline at end of file
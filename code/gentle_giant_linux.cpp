@@ -0,0 +1,494 @@
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+
+#include "gentle_giant_linux.hpp"
+#include "platform.hpp"
+#include "memory.hpp"
+#include "input_recording.hpp"
+#include "frame_pacing.hpp"
+#include "fixed_timestep.hpp"
+#include "present_queue.hpp"
+#include "snapshot_queue.hpp"
+#include "software_rendering.hpp"
+#include "game.hpp"
+
+namespace gentle
+{
+
+#define Kilobytes(value) ((value) * 1024LL)
+#define Megabytes(value) (Kilobytes(value) * 1024LL)
+#define Gigabytes(value) (Megabytes(value) * 1024LL)
+#define Terabytes(value) (Gigabytes(value) * 1024LL)
+
+static volatile sig_atomic_t IsRunning = false;
+
+static void* Linux_AllocatePages(size_t size)
+{
+	// Anonymous pages come zeroed, like VirtualAlloc's
+	void* memory = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	return (memory == MAP_FAILED) ? nullptr : memory;
+}
+
+static bool Linux_AllocateRenderBuffer(RenderBuffer &renderBuffer, int width, int height)
+{
+	renderBuffer.width = width;
+	renderBuffer.height = height;
+	renderBuffer.bytesPerPixel = sizeof(uint32_t);
+	renderBuffer.pitch = renderBuffer.width * renderBuffer.bytesPerPixel;
+
+	int pixelCount = renderBuffer.width * renderBuffer.height;
+	renderBuffer.pixels = (uint32_t *)Linux_AllocatePages(pixelCount * renderBuffer.bytesPerPixel);
+	renderBuffer.depth = (float *)Linux_AllocatePages(pixelCount * sizeof(float));
+
+	int tileCount = ((renderBuffer.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE) * ((renderBuffer.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE);
+	renderBuffer.tiles = (RenderTile *)Linux_AllocatePages(tileCount * sizeof(RenderTile));
+
+	return renderBuffer.pixels && renderBuffer.depth && renderBuffer.tiles;
+}
+
+static void Linux_FreeRenderBuffer(RenderBuffer &renderBuffer)
+{
+	int pixelCount = renderBuffer.width * renderBuffer.height;
+	int tileCount = ((renderBuffer.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE) * ((renderBuffer.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE);
+	if (renderBuffer.pixels)
+	{
+		munmap(renderBuffer.pixels, pixelCount * renderBuffer.bytesPerPixel);
+	}
+	if (renderBuffer.depth)
+	{
+		munmap(renderBuffer.depth, pixelCount * sizeof(float));
+	}
+	if (renderBuffer.tiles)
+	{
+		munmap(renderBuffer.tiles, tileCount * sizeof(RenderTile));
+	}
+	renderBuffer = {0};
+}
+
+// Binary PPM, flipped so the bottom row of the render buffer ends up at the bottom of the image as it does in the Win32 window
+static bool Linux_WriteRenderBufferToPPM(const RenderBuffer &renderBuffer, uint8_t* rowBytes, const char* filename)
+{
+	FILE* file = fopen(filename, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	bool successfulWrite = (fprintf(file, "P6\n%d %d\n255\n", renderBuffer.width, renderBuffer.height) > 0);
+	for (int y = renderBuffer.height - 1; (y >= 0) && successfulWrite; y -= 1)
+	{
+		const uint32_t* row = renderBuffer.pixels + (y * renderBuffer.width);
+		for (int x = 0; x < renderBuffer.width; x += 1)
+		{
+			rowBytes[(3 * x) + 0] = (uint8_t)(row[x] >> 16);
+			rowBytes[(3 * x) + 1] = (uint8_t)(row[x] >> 8);
+			rowBytes[(3 * x) + 2] = (uint8_t)row[x];
+		}
+		successfulWrite = (fwrite(rowBytes, 3, renderBuffer.width, file) == (size_t)renderBuffer.width);
+	}
+
+	return (fclose(file) == 0) && successfulWrite;
+}
+
+/**
+ * Whether pattern is safe to hand snprintf along with a single int: exactly one %d or %i, with any flags, width & precision
+ * but no * or length modifier, & otherwise only %% escapes. Anything else would have snprintf read arguments that aren't there
+ */
+static bool Linux_IsFrameOutputPathValid(const char* pattern)
+{
+	int conversionCount = 0;
+	for (const char* c = pattern; *c; c += 1)
+	{
+		if (*c != '%')
+		{
+			continue;
+		}
+		c += 1;
+		if (*c == '%')
+		{
+			continue;
+		}
+		while (*c && strchr("-+ #0", *c))
+		{
+			c += 1;
+		}
+		while (*c >= '0' && *c <= '9')
+		{
+			c += 1;
+		}
+		if (*c == '.')
+		{
+			c += 1;
+			while (*c >= '0' && *c <= '9')
+			{
+				c += 1;
+			}
+		}
+		if (*c != 'd' && *c != 'i')
+		{
+			return false;
+		}
+		conversionCount += 1;
+	}
+	return conversionCount == 1;
+}
+
+static void Linux_HandleStopSignal(int)
+{
+	IsRunning = false;
+}
+
+inline timespec Linux_GetWallClock()
+{
+	timespec Result;
+	clock_gettime(CLOCK_MONOTONIC, &Result);
+	return Result;
+}
+
+inline float Linux_GetSecondsElapsed(timespec Start, timespec End)
+{
+	return (float)(End.tv_sec - Start.tv_sec) + ((float)(End.tv_nsec - Start.tv_nsec) / 1000000000.0f);
+}
+
+inline double Linux_GetSeconds(timespec Counter)
+{
+	return (double)Counter.tv_sec + ((double)Counter.tv_nsec / 1000000000.0);
+}
+
+static double Linux_GetPacingSeconds()
+{
+	return Linux_GetSeconds(Linux_GetWallClock());
+}
+
+// Waking early to a signal is fine, the pacer measures how long it really slept
+static void Linux_PacingSleep(double seconds)
+{
+	timespec duration;
+	duration.tv_sec = (time_t)seconds;
+	duration.tv_nsec = (long)((seconds - (double)duration.tv_sec) * 1000000000.0);
+	nanosleep(&duration, 0);
+}
+
+int HeadlessMain(const HeadlessSettings &settings)
+{
+	signal(SIGINT, Linux_HandleStopSignal);
+	signal(SIGTERM, Linux_HandleStopSignal);
+
+	float targetSecondsPerFrame = (settings.targetFPS > 0) ? (1.0f / (float)settings.targetFPS) : 0.0f;
+
+	if (settings.frameOutputPath && !Linux_IsFrameOutputPathValid(settings.frameOutputPath))
+	{
+		fprintf(stderr, "Frame output path %s needs exactly one %%d for the frame number, & any other %% written as %%%%\n", settings.frameOutputPath);
+		return 1;
+	}
+
+	// Recordings are read & written whole, so replaying doesn't touch the disk mid frame
+	InputRecording recording;
+	InputRecording replay;
+	if (settings.replayInputPath && !ReadInputRecording(settings.replayInputPath, replay))
+	{
+		fprintf(stderr, "Unable to read input recording %s\n", settings.replayInputPath);
+		return 1;
+	}
+
+	// Initialize Visual. Without frames to write out there's nothing to overlap rendering with, so one buffer does
+	int renderBufferCount = (settings.renderBufferCount > 0) ? settings.renderBufferCount : 2;
+	renderBufferCount = (renderBufferCount < MAX_PRESENT_BUFFERS) ? renderBufferCount : MAX_PRESENT_BUFFERS;
+	renderBufferCount = settings.frameOutputPath ? renderBufferCount : 1;
+	RenderBuffer renderBuffers[MAX_PRESENT_BUFFERS] = {};
+	bool successfulRenderBufferAllocation = true;
+	for (int i = 0; i < renderBufferCount; i += 1)
+	{
+		successfulRenderBufferAllocation = Linux_AllocateRenderBuffer(renderBuffers[i], settings.width, settings.height) && successfulRenderBufferAllocation;
+	}
+	if (!successfulRenderBufferAllocation)
+	{
+		fprintf(stderr, "Unable to allocate a %dx%d render buffer\n", settings.width, settings.height);
+		for (int i = 0; i < renderBufferCount; i += 1)
+		{
+			Linux_FreeRenderBuffer(renderBuffers[i]);
+		}
+		return 1;
+	}
+
+	// Initialize general use memory
+	GameMemory GameMemory;
+	GameMemory.PermanentStorageSpace = Megabytes(1);
+	GameMemory.TransientStorageSpace = Megabytes((uint64_t)1);
+	GameMemory.SnapshotStorageSpace = Kilobytes(64);
+
+	uint64_t totalStorageSpace = GameMemory.PermanentStorageSpace + GameMemory.TransientStorageSpace + (2 * GameMemory.SnapshotStorageSpace);
+	GameMemory.PermanentStorage = Linux_AllocatePages((size_t)totalStorageSpace);
+	uint8_t* rowBytes = (uint8_t *)Linux_AllocatePages(3 * settings.width);
+	if (!GameMemory.PermanentStorage || !rowBytes)
+	{
+		fprintf(stderr, "Unable to allocate game memory\n");
+		if (GameMemory.PermanentStorage)
+		{
+			munmap(GameMemory.PermanentStorage, (size_t)totalStorageSpace);
+		}
+		if (rowBytes)
+		{
+			munmap(rowBytes, 3 * settings.width);
+		}
+		for (int i = 0; i < renderBufferCount; i += 1)
+		{
+			Linux_FreeRenderBuffer(renderBuffers[i]);
+		}
+		return 1;
+	}
+
+	GameMemory.TransientStorage = (uint8_t*)GameMemory.PermanentStorage + GameMemory.PermanentStorageSpace;
+	GameMemory.SnapshotStorage[0] = (uint8_t*)GameMemory.TransientStorage + GameMemory.TransientStorageSpace;
+	GameMemory.SnapshotStorage[1] = (uint8_t*)GameMemory.SnapshotStorage[0] + GameMemory.SnapshotStorageSpace;
+
+	// Frames past the end of the script get no buttons down
+	Input gameInput = {0};
+	const Input noInput = {0};
+
+	// Initialize timers
+	float lastDt = (targetSecondsPerFrame > 0.0f) ? targetSecondsPerFrame : (1.0f / 30.0f);
+	timespec StartCounter = Linux_GetWallClock();
+	timespec LastCounter = StartCounter;
+	float minWorkTime = 0.0f;
+	float maxWorkTime = 0.0f;
+	int frameIndex = 0;
+	FramePacer framePacer = MakeFramePacer(targetSecondsPerFrame);
+	PacingClock pacingClock = { Linux_GetPacingSeconds, Linux_PacingSleep };
+
+	// Fixed steps carry the time they don't use over to the next frame, & the render blends between the last two
+	bool isFixedTimestep = (settings.fixedUpdateDt > 0.0f);
+	int maxUpdatesPerFrame = (settings.maxUpdatesPerFrame > 0) ? settings.maxUpdatesPerFrame : 5;
+	FixedTimestep timestep = MakeFixedTimestep(isFixedTimestep ? settings.fixedUpdateDt : 1.0f, maxUpdatesPerFrame);
+	float snapshotAlphas[2] = { 1.0f, 1.0f };
+	const void* lastSnapshot = GameMemory.SnapshotStorage[0];
+	bool isLastUpdateChanged = true;
+	int skippedFrameCount = 0;
+
+	Initialize(GameMemory, renderBuffers[0]);
+
+	// Frames are written out in order on their own thread, while the game renders the ones after them
+	PresentQueue presentQueue;
+	InitializePresentQueue(presentQueue, renderBuffers, renderBufferCount, PRESENT_MODE_FIFO);
+	int bufferFrameIndices[MAX_PRESENT_BUFFERS] = {};
+	std::atomic<bool> isFrameOutputFailed(false);
+	std::thread presenter;
+	if (settings.frameOutputPath)
+	{
+		presenter = std::thread([&]
+		{
+			while (RenderBuffer* renderBuffer = BeginPresentFrame(presentQueue))
+			{
+				int outputFrameIndex = bufferFrameIndices[renderBuffer - renderBuffers];
+
+				// Tiles the game never drew to after a deferred clear still need clearing before they're written out
+				ResolveDeferredClear(*renderBuffer);
+
+				char filename[4096];
+				snprintf(filename, sizeof(filename), settings.frameOutputPath, outputFrameIndex);
+				if (!isFrameOutputFailed && !Linux_WriteRenderBufferToPPM(*renderBuffer, rowBytes, filename))
+				{
+					fprintf(stderr, "Unable to write frame %d to %s\n", outputFrameIndex, filename);
+					isFrameOutputFailed = true;
+				}
+				EndPresentFrame(presentQueue, renderBuffer);
+			}
+		});
+	}
+
+	// Render a snapshot & hand it to the writer, on whichever thread is rendering
+	auto renderSnapshot = [&](const void* snapshot, int renderFrameIndex)
+	{
+		bool isAllocationForbidden = (settings.allocationFreeFromFrame > 0) && (renderFrameIndex >= settings.allocationFreeFromFrame);
+		SetHeapAllocationForbidden(isAllocationForbidden);
+		RenderBuffer* renderBuffer = settings.frameOutputPath ? BeginRenderFrame(presentQueue) : &renderBuffers[0];
+		Render(GameMemory, snapshot, snapshotAlphas[snapshot == GameMemory.SnapshotStorage[1]], *renderBuffer);
+		SetHeapAllocationForbidden(false);
+
+		if (settings.frameOutputPath)
+		{
+			bufferFrameIndices[renderBuffer - renderBuffers] = renderFrameIndex;
+			SubmitRenderFrame(presentQueue, renderBuffer);
+		}
+	};
+
+	// With a render thread, the main thread only runs Update & renders nothing itself
+	SnapshotQueue snapshotQueue;
+	InitializeSnapshotQueue(snapshotQueue, GameMemory.SnapshotStorage[0], GameMemory.SnapshotStorage[1]);
+	std::thread renderer;
+	if (settings.isRenderThreaded)
+	{
+		renderer = std::thread([&]
+		{
+			int renderFrameIndex = 0;
+			while (const void* snapshot = BeginReadSnapshot(snapshotQueue))
+			{
+				renderSnapshot(snapshot, renderFrameIndex);
+				EndReadSnapshot(snapshotQueue);
+				renderFrameIndex += 1;
+			}
+		});
+	}
+
+	// Main loop
+	int result = 0;
+	IsRunning = true;
+	while (IsRunning && !isFrameOutputFailed && ((settings.frameCount <= 0) || (frameIndex < settings.frameCount)))
+	{
+		gameInput = (frameIndex < settings.inputCount) ? settings.inputs[frameIndex] : noInput;
+		float frameDt = (settings.fixedDt > 0.0f) ? settings.fixedDt : lastDt;
+		if (settings.replayInputPath)
+		{
+			if (frameIndex >= (int)replay.frames.size())
+			{
+				break;
+			}
+			gameInput = replay.frames[frameIndex].input;
+			frameDt = replay.frames[frameIndex].dt;
+		}
+		if (settings.recordInputPath)
+		{
+			RecordFrame(recording, gameInput, frameDt);
+		}
+
+		// Once the game has had time to warm up its buffers, any heap allocation in a frame is a bug
+		BeginAllocationFrame();
+		bool isAllocationForbidden = (settings.allocationFreeFromFrame > 0) && (frameIndex >= settings.allocationFreeFromFrame);
+		SetHeapAllocationForbidden(isAllocationForbidden);
+		void* snapshot = settings.isRenderThreaded ? BeginWriteSnapshot(snapshotQueue) : GameMemory.SnapshotStorage[0];
+		int updateCount = isFixedTimestep ? AdvanceFixedTimestep(timestep, frameDt) : 1;
+		if ((updateCount == 0) && (snapshot != lastSnapshot))
+		{
+			// Nothing new to simulate, so draw the last steps again, just further along
+			memcpy(snapshot, lastSnapshot, GameMemory.SnapshotStorageSpace);
+		}
+		bool isSnapshotChanged = false;
+		for (int update = 0; update < updateCount; update += 1)
+		{
+			isLastUpdateChanged = Update(GameMemory, (update == 0) ? gameInput : MakeRepeatedStepInput(gameInput), isFixedTimestep ? timestep.stepSeconds : frameDt, snapshot);
+			isSnapshotChanged = isSnapshotChanged || isLastUpdateChanged;
+		}
+
+		// Between steps the render still moves along, if the last step changed anything.
+		// Every frame gets written out, but without frames to write, unchanged ones needn't be drawn at all
+		isSnapshotChanged = isSnapshotChanged || ((updateCount == 0) && isLastUpdateChanged);
+		bool isFrameSkipped = !isSnapshotChanged && !settings.frameOutputPath && (frameIndex > 0);
+		snapshotAlphas[snapshot == GameMemory.SnapshotStorage[1]] = isFixedTimestep ? GetFixedTimestepAlpha(timestep) : 1.0f;
+		lastSnapshot = snapshot;
+		SetHeapAllocationForbidden(false);
+
+		if (isFrameSkipped)
+		{
+			skippedFrameCount += 1;
+		}
+		else if (settings.isRenderThreaded)
+		{
+			PublishSnapshot(snapshotQueue);
+		}
+		else
+		{
+			renderSnapshot(snapshot, frameIndex);
+		}
+
+		// wait before starting next frame. A skipped frame shows nothing, so there's no need to spin to end it on time
+		float workTime = 1000.0f * Linux_GetSecondsElapsed(LastCounter, Linux_GetWallClock());
+		if ((targetSecondsPerFrame > 0.0f) && isFrameSkipped)
+		{
+			SleepUntilFrameEnd(framePacer, pacingClock, Linux_GetSeconds(LastCounter));
+		}
+		else if (targetSecondsPerFrame > 0.0f)
+		{
+			WaitForFrameEnd(framePacer, pacingClock, Linux_GetSeconds(LastCounter));
+		}
+
+		// Work out elapsed time for current frame
+		timespec EndCounter = Linux_GetWallClock();
+		lastDt = Linux_GetSecondsElapsed(LastCounter, EndCounter);
+		minWorkTime = (frameIndex == 0) ? workTime : ((workTime < minWorkTime) ? workTime : minWorkTime);
+		maxWorkTime = (workTime > maxWorkTime) ? workTime : maxWorkTime;
+
+		if (IsTrackingAllocations())
+		{
+			AllocationStats allocationStats = GetFrameAllocationStats();
+			if (GetTotalAllocationCount(allocationStats) > 0)
+			{
+				printf("Frame %d: %d allocs (%d render, %d clip, %d file, %d collision), %zu KB in use, %zu KB peak\n", frameIndex,
+					GetTotalAllocationCount(allocationStats), allocationStats.allocationCount[ALLOCATION_TAG_RENDER],
+					allocationStats.allocationCount[ALLOCATION_TAG_CLIP], allocationStats.allocationCount[ALLOCATION_TAG_FILE],
+					allocationStats.allocationCount[ALLOCATION_TAG_COLLISION], allocationStats.bytesInUse / 1024,
+					allocationStats.peakBytesInUse / 1024);
+			}
+		}
+
+		// Reset measurements for next frame
+		LastCounter = EndCounter;
+		frameIndex += 1;
+	}
+
+	// Every frame updated gets rendered & written out before we report on the run
+	if (settings.isRenderThreaded)
+	{
+		CloseSnapshotQueue(snapshotQueue);
+		renderer.join();
+	}
+	if (settings.frameOutputPath)
+	{
+		ClosePresentQueue(presentQueue);
+		presenter.join();
+		result = isFrameOutputFailed ? 1 : result;
+	}
+
+	if (settings.recordInputPath && !WriteInputRecording(settings.recordInputPath, recording))
+	{
+		fprintf(stderr, "Unable to write input recording %s\n", settings.recordInputPath);
+		result = 1;
+	}
+
+	// Output frame time information for the whole run
+	float totalSeconds = Linux_GetSecondsElapsed(StartCounter, LastCounter);
+	if (frameIndex > 0)
+	{
+		printf("%d frames in %.02f s, %.02f ms/f, %.02f f/s, %.02f ms min work, %.02f ms max work\n", frameIndex, totalSeconds,
+			1000.0f * totalSeconds / (float)frameIndex, (float)frameIndex / totalSeconds, minWorkTime, maxWorkTime);
+	}
+	if (framePacer.stats.frameCount > 0)
+	{
+		printf("%d of %d frames missed, worst by %.02f ms. Waited %.02f s asleep & %.02f s spinning\n", framePacer.stats.missedFrameCount,
+			framePacer.stats.frameCount, 1000.0 * framePacer.stats.worstMissSeconds, framePacer.stats.sleepSeconds,
+			framePacer.stats.spinSeconds);
+	}
+	if (skippedFrameCount > 0)
+	{
+		printf("%d frames skipped with nothing changed\n", skippedFrameCount);
+	}
+	if (isFixedTimestep)
+	{
+		printf("%d updates of %.02f ms, %d dropped catching up\n", timestep.stepCount, 1000.0f * timestep.stepSeconds, timestep.droppedStepCount);
+	}
+	if (settings.isRenderThreaded)
+	{
+		printf("Update waited on Render %d times, Render waited on Update %d times\n", snapshotQueue.writeWaits, snapshotQueue.readWaits);
+	}
+	if (settings.frameOutputPath)
+	{
+		PresentQueueStats presentStats = GetPresentQueueStats(presentQueue);
+		printf("%d frames handed to the writer with %d render buffers, the game waited on it %d times\n", presentStats.framesPresented,
+			renderBufferCount, presentStats.renderWaits);
+	}
+
+	munmap(rowBytes, 3 * settings.width);
+	munmap(GameMemory.PermanentStorage, (size_t)totalStorageSpace);
+	for (int i = 0; i < renderBufferCount; i += 1)
+	{
+		Linux_FreeRenderBuffer(renderBuffers[i]);
+	}
+	return result;
+}
+
+}
@@ -0,0 +1,31 @@
+#ifndef GENTLE_GIANT_LINUX_H
+#define GENTLE_GIANT_LINUX_H
+
+#include "platform.hpp"
+
+namespace gentle
+{
+	struct HeadlessSettings
+	{
+		int width;
+		int height;
+		int frameCount;	// Frames to run before returning. 0 runs until interrupted, or to the end of a replay
+		int targetFPS;	// Sleep to hold this frame rate. 0 runs uncapped, as fast as frames can be made
+		float fixedDt;	// Seconds every frame is taken to last. 0 uses the measured time of the last frame
+		float fixedUpdateDt;	// Run as many Updates of exactly this many seconds as each frame's time adds up to, & interpolate the render between them. 0 runs one Update a frame, of the frame's time
+		int maxUpdatesPerFrame;	// With fixedUpdateDt, the most Updates a frame runs to catch up after slow ones. 0 uses 5
+		const Input* inputs;	// Scripted input, one per frame. Frames past inputCount get no buttons down
+		int inputCount;
+		const char* frameOutputPath;	// printf pattern with exactly one %d for the frame number, e.g. "frames/%05d.ppm". nullptr writes no frames
+		int renderBufferCount;	// Buffers the game renders into while earlier frames are written, up to MAX_PRESENT_BUFFERS. 0 uses 2
+		bool isRenderThreaded;	// Render each frame on a thread of its own while the main thread runs the next Update
+		int allocationFreeFromFrame;	// With allocation tracking built in, assert Update & Render don't allocate from this frame on. 0 never checks
+		const char* recordInputPath;	// Save every frame's input & dt here on exit, see input_recording.hpp. nullptr records nothing
+		const char* replayInputPath;	// Play back a recorded session in place of the scripted input & dt, stopping at its end
+	};
+
+	// Run the game without a window, e.g. on a render farm or faster than real time. Returns non-zero on failure
+	int HeadlessMain(const HeadlessSettings &settings);
+}
+
+#endif
@@ -1,9 +1,19 @@
 #include <windows.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
 
 #include "gentle_giant_win32.hpp"
 #include "platform.hpp"
+#include "memory.hpp"
+#include "input_recording.hpp"
+#include "frame_pacing.hpp"
+#include "fixed_timestep.hpp"
+#include "present_queue.hpp"
+#include "snapshot_queue.hpp"
+#include "software_rendering.hpp"
 #include "game.hpp"
 
 namespace gentle
@@ -17,50 +27,155 @@ namespace gentle
 #define Terabytes(value) (Gigabytes(value) * 1024LL)
 
 static bool IsRunning = false;
-static RenderBuffer globalRenderBuffer = {0};
+static RenderBuffer globalRenderBuffers[MAX_PRESENT_BUFFERS] = {0};
+static int globalRenderBufferCount = 0;
+static PresentQueue globalPresentQueue;
+static RenderBuffer* globalLastPresentedBuffer = nullptr;	// Repainted on WM_PAINT
+static DirtyRegion globalDirtyRegions[MAX_PRESENT_BUFFERS];	// What each render buffer has that the window doesn't show yet
+static std::atomic<bool> globalIsRepaintPending(false);	// With a render thread, the whole of the next frame needs showing & not just what changed
+static SnapshotQueue globalSnapshotQueue;
+static float globalSnapshotAlphas[2] = { 1.0f, 1.0f };	// What to pass Render with each of GameMemory.SnapshotStorage
+static bool globalIsRenderThreaded = false;	// Only touched on the window's thread
+static bool globalIsRedrawNeeded = true;	// The window needs a frame even if the game has nothing new to draw. Only touched on the window's thread
+static std::atomic<bool> globalIsResizePending(false);	// With a render thread, the window changed size & it hasn't caught up yet
 static BITMAPINFO bitmapInfo = {0};	// platform dependent
 static int64_t GlobalPerfCountFrequency;
 
-static void Win32_SizeglobalRenderBufferToCurrentWindow(HWND window)
+static void Win32_ResizeRenderBuffer(RenderBuffer &renderBuffer, int width, int height)
 {
-	RECT clientRect = {0};
-	GetClientRect(window, &clientRect);
+	renderBuffer.width = width;
+	renderBuffer.height = height;
+	renderBuffer.bytesPerPixel = sizeof(uint32_t);
 
-	globalRenderBuffer.width = clientRect.right - clientRect.left;
-	globalRenderBuffer.height = clientRect.bottom - clientRect.top;
-	globalRenderBuffer.bytesPerPixel = sizeof(uint32_t);
-
-	if (globalRenderBuffer.pixels)
+	if (renderBuffer.pixels)
 	{
-		VirtualFree(globalRenderBuffer.pixels, 0, MEM_RELEASE);
+		VirtualFree(renderBuffer.pixels, 0, MEM_RELEASE);
 	}
-	if (globalRenderBuffer.depth)
+	if (renderBuffer.depth)
 	{
-		VirtualFree(globalRenderBuffer.depth, 0, MEM_RELEASE);
+		VirtualFree(renderBuffer.depth, 0, MEM_RELEASE);
 	}
+	if (renderBuffer.tiles)
+	{
+		VirtualFree(renderBuffer.tiles, 0, MEM_RELEASE);
+	}
+
+	int bitmapPixelCount = renderBuffer.width * renderBuffer.height;
+	int bitmapMemorySize = bitmapPixelCount * renderBuffer.bytesPerPixel;
+	renderBuffer.pitch = renderBuffer.width * renderBuffer.bytesPerPixel;
+	renderBuffer.pixels = (uint32_t *)VirtualAlloc(0, bitmapMemorySize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+
+	int depthBufferMemorySize = bitmapPixelCount * sizeof(float);
+	renderBuffer.depth = (float *)VirtualAlloc(0, depthBufferMemorySize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+
+	int tileCount = ((renderBuffer.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE) * ((renderBuffer.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE);
+	int tileMemorySize = tileCount * sizeof(RenderTile);
+	renderBuffer.tiles = (RenderTile *)VirtualAlloc(0, tileMemorySize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+
+	// Nothing in the new buffer is worth showing until the game has drawn the lot
+	MarkAllDirty(*renderBuffer.dirtyRegion, width, height);
+}
+
+static void Win32_SizeglobalRenderBuffersToCurrentWindow(HWND window)
+{
+	RECT clientRect = {0};
+	GetClientRect(window, &clientRect);
+	int width = clientRect.right - clientRect.left;
+	int height = clientRect.bottom - clientRect.top;
+
+	// The presenting thread may still be showing a frame from a buffer we're about to free
+	WaitForPresentQueueIdle(globalPresentQueue);
+	globalLastPresentedBuffer = nullptr;
 
 	bitmapInfo.bmiHeader.biSize = sizeof(bitmapInfo.bmiHeader);
-	bitmapInfo.bmiHeader.biWidth = globalRenderBuffer.width;
-	bitmapInfo.bmiHeader.biHeight = globalRenderBuffer.height;
+	bitmapInfo.bmiHeader.biWidth = width;
+	bitmapInfo.bmiHeader.biHeight = height;
 	bitmapInfo.bmiHeader.biPlanes = 1;
 	bitmapInfo.bmiHeader.biBitCount = 32;
 	bitmapInfo.bmiHeader.biCompression = BI_RGB;
 
-	int bitmapPixelCount = globalRenderBuffer.width * globalRenderBuffer.height;
-	int bitmapMemorySize = bitmapPixelCount * globalRenderBuffer.bytesPerPixel;
-	globalRenderBuffer.pitch = globalRenderBuffer.width * globalRenderBuffer.bytesPerPixel;
-	globalRenderBuffer.pixels = (uint32_t *)VirtualAlloc(0, bitmapMemorySize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-
-	int depthBufferMemorySize = bitmapPixelCount * sizeof(float);
-	globalRenderBuffer.depth = (float *)VirtualAlloc(0, depthBufferMemorySize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+	for (int i = 0; i < globalRenderBufferCount; i += 1)
+	{
+		Win32_ResizeRenderBuffer(globalRenderBuffers[i], width, height);
+	}
 }
 
-static void Win32_DisplayglobalRenderBufferInWindow(HDC deviceContext)
+static void Win32_DisplayRenderBufferInWindow(HDC deviceContext, RenderBuffer &renderBuffer)
 {
+	// Tiles the game never drew to after a deferred clear still need clearing before they're shown
+	ResolveDeferredClear(renderBuffer);
+
 	StretchDIBits(deviceContext,
-		0, 0, globalRenderBuffer.width, globalRenderBuffer.height,
-		0, 0, globalRenderBuffer.width, globalRenderBuffer.height,
-		globalRenderBuffer.pixels, &bitmapInfo, DIB_RGB_COLORS, SRCCOPY);
+		0, 0, renderBuffer.width, renderBuffer.height,
+		0, 0, renderBuffer.width, renderBuffer.height,
+		renderBuffer.pixels, &bitmapInfo, DIB_RGB_COLORS, SRCCOPY);
+}
+
+// Only copy the parts of the frame that changed, the rest of the window already shows the same pixels
+static void Win32_DisplayDirtyRectsInWindow(HDC deviceContext, RenderBuffer &renderBuffer)
+{
+	ResolveDeferredClear(renderBuffer);
+
+	const DirtyRegion &region = *renderBuffer.dirtyRegion;
+	for (int i = 0; i < region.rectCount; i += 1)
+	{
+		// The bitmap is bottom up, so source rows count up from the bottom while the window's count down from the top
+		const PixelRect &rect = region.rects[i];
+		int width = rect.x1 - rect.x0;
+		int height = rect.y1 - rect.y0;
+		StretchDIBits(deviceContext,
+			rect.x0, renderBuffer.height - rect.y1, width, height,
+			rect.x0, rect.y0, width, height,
+			renderBuffer.pixels, &bitmapInfo, DIB_RGB_COLORS, SRCCOPY);
+	}
+}
+
+// Shows each frame the game submits while the game gets on with rendering the next one
+static void Win32_PresentFrames(HWND window)
+{
+	while (RenderBuffer* renderBuffer = BeginPresentFrame(globalPresentQueue))
+	{
+		HDC deviceContext = GetDC(window);
+		if (globalIsRepaintPending.exchange(false))
+		{
+			Win32_DisplayRenderBufferInWindow(deviceContext, *renderBuffer);
+		}
+		else
+		{
+			Win32_DisplayDirtyRectsInWindow(deviceContext, *renderBuffer);
+		}
+		ReleaseDC(window, deviceContext);
+
+		globalLastPresentedBuffer = renderBuffer;
+		EndPresentFrame(globalPresentQueue, renderBuffer);
+	}
+}
+
+// Render a snapshot into a free buffer & queue it to be shown
+static void Win32_RenderSnapshot(const GameMemory &gameMemory, const void* snapshot, bool isAllocationForbidden)
+{
+	SetHeapAllocationForbidden(isAllocationForbidden);
+	RenderBuffer* renderBuffer = BeginRenderFrame(globalPresentQueue);
+	Render(gameMemory, snapshot, globalSnapshotAlphas[snapshot == gameMemory.SnapshotStorage[1]], *renderBuffer);
+	SetHeapAllocationForbidden(false);
+	SubmitRenderFrame(globalPresentQueue, renderBuffer);
+}
+
+// Renders each snapshot the game publishes while the window's thread runs the next Update
+static void Win32_RenderFrames(HWND window, const GameMemory* gameMemory, int allocationFreeFromFrame)
+{
+	int frameIndex = 0;
+	while (const void* snapshot = BeginReadSnapshot(globalSnapshotQueue))
+	{
+		// Only this thread renders, so it's the one that can swap the buffers for ones the new size of the window
+		if (globalIsResizePending.exchange(false))
+		{
+			Win32_SizeglobalRenderBuffersToCurrentWindow(window);
+		}
+		Win32_RenderSnapshot(*gameMemory, snapshot, (allocationFreeFromFrame > 0) && (frameIndex >= allocationFreeFromFrame));
+		EndReadSnapshot(globalSnapshotQueue);
+		frameIndex += 1;
+	}
 }
 
 LRESULT CALLBACK Win32_MainWindowCallback(HWND window, UINT Message, WPARAM wParam, LPARAM lParam)
@@ -71,7 +186,15 @@ LRESULT CALLBACK Win32_MainWindowCallback(HWND window, UINT Message, WPARAM wPar
 	{
 		case WM_SIZE:
 		{
-			Win32_SizeglobalRenderBufferToCurrentWindow(window);
+			globalIsRedrawNeeded = true;
+			if (globalIsRenderThreaded)
+			{
+				globalIsResizePending = true;
+			}
+			else
+			{
+				Win32_SizeglobalRenderBuffersToCurrentWindow(window);
+			}
 		} break;
 		case WM_DESTROY:
 		{
@@ -92,7 +215,17 @@ LRESULT CALLBACK Win32_MainWindowCallback(HWND window, UINT Message, WPARAM wPar
 		{
 			PAINTSTRUCT paint = {0};
 			HDC deviceContext = BeginPaint(window, &paint);
-			Win32_DisplayglobalRenderBufferInWindow(deviceContext);
+			// A render thread could be resizing the buffers, so leave the repaint to the next frame it presents
+			WaitForPresentQueueIdle(globalPresentQueue);
+			if (globalLastPresentedBuffer && !globalIsRenderThreaded)
+			{
+				Win32_DisplayRenderBufferInWindow(deviceContext, *globalLastPresentedBuffer);
+			}
+			else
+			{
+				globalIsRedrawNeeded = true;
+				globalIsRepaintPending = true;
+			}
 			EndPaint(window, &paint);
 		} break;
 		default:
@@ -232,6 +365,21 @@ inline float Win32_GetSecondsElapsed(LARGE_INTEGER Start, LARGE_INTEGER End)
 	return SecondsElapsedForWork;
 }
 
+inline double Win32_GetSeconds(LARGE_INTEGER Counter)
+{
+	return (double)Counter.QuadPart / (double)GlobalPerfCountFrequency;
+}
+
+static double Win32_GetPacingSeconds()
+{
+	return Win32_GetSeconds(Win32_GetWallClock());
+}
+
+static void Win32_PacingSleep(double seconds)
+{
+	Sleep((DWORD)(1000.0 * seconds));
+}
+
 
 int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSettings())
 {
@@ -239,6 +387,16 @@ int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSetting
 	QueryPerformanceFrequency(&PerfCounterFrequencyResult);
 	GlobalPerfCountFrequency = PerfCounterFrequencyResult.QuadPart;
 
+	// Recordings are read & written whole, so replaying doesn't touch the disk mid frame. A replay that can't be read ends
+	// the session before there's a window, a thread or a game to tear down
+	InputRecording recording;
+	InputRecording replay;
+	if (settings.replayInputPath && !ReadInputRecording(settings.replayInputPath, replay))
+	{
+		OutputDebugStringA("Unable to read input recording\n");
+		return 1;
+	}
+
 	// Set the Windows schedular granularity to 1ms to help our Sleep() function call be granular
 	UINT DesiredSchedulerMS = 1;
 	MMRESULT setSchedularGranularityResult = timeBeginPeriod(DesiredSchedulerMS);
@@ -253,6 +411,15 @@ int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSetting
 	int gameUpdateHz = (settings.targetFPS >= 10) ? settings.targetFPS : 30;
 	float targetSecondsPerFrame = 1.0f / (float)gameUpdateHz;
 
+	// Mailbox, so a slow present never holds the game back, it just shows the newest frame it can
+	globalRenderBufferCount = (settings.renderBufferCount > 0) ? settings.renderBufferCount : 2;
+	globalRenderBufferCount = (globalRenderBufferCount < MAX_PRESENT_BUFFERS) ? globalRenderBufferCount : MAX_PRESENT_BUFFERS;
+	for (int i = 0; i < globalRenderBufferCount; i += 1)
+	{
+		globalRenderBuffers[i].dirtyRegion = &globalDirtyRegions[i];
+	}
+	InitializePresentQueue(globalPresentQueue, globalRenderBuffers, globalRenderBufferCount, PRESENT_MODE_MAILBOX);
+
 	if(RegisterClassA(&windowClass))
 	{
 		HWND window = CreateWindowExA(
@@ -272,14 +439,16 @@ int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSetting
 			IsRunning = true;
 
 			// Initialize Visual
-			Win32_SizeglobalRenderBufferToCurrentWindow(window);
+			Win32_SizeglobalRenderBuffersToCurrentWindow(window);
+			std::thread presenter(Win32_PresentFrames, window);
 
 			// Initialize general use memory
 			GameMemory GameMemory;
 			GameMemory.PermanentStorageSpace = Megabytes(1);
 			GameMemory.TransientStorageSpace = Megabytes((uint64_t)1);
+			GameMemory.SnapshotStorageSpace = Kilobytes(64);
 
-			uint64_t totalStorageSpace = GameMemory.PermanentStorageSpace + GameMemory.TransientStorageSpace;
+			uint64_t totalStorageSpace = GameMemory.PermanentStorageSpace + GameMemory.TransientStorageSpace + (2 * GameMemory.SnapshotStorageSpace);
 			bool successfulMemoryAllocation = true;
 			GameMemory.PermanentStorage = VirtualAlloc(0, (size_t)totalStorageSpace, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
 			if(GameMemory.PermanentStorage == NULL)
@@ -289,6 +458,8 @@ int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSetting
 			}
 
 			GameMemory.TransientStorage = (uint8_t*)GameMemory.PermanentStorage + GameMemory.PermanentStorageSpace;
+			GameMemory.SnapshotStorage[0] = (uint8_t*)GameMemory.TransientStorage + GameMemory.TransientStorageSpace;
+			GameMemory.SnapshotStorage[1] = (uint8_t*)GameMemory.SnapshotStorage[0] + GameMemory.SnapshotStorageSpace;
 
 			// Initialize input state
 			Input gameInput = {0};
@@ -297,8 +468,29 @@ int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSetting
 			float lastDt = targetSecondsPerFrame;
 			LARGE_INTEGER LastCounter = Win32_GetWallClock();
 			int64_t LastCycleCount = __rdtsc();
+			int frameIndex = 0;
+
+			// Only sleep between frames when the scheduler will wake us within about a millisecond
+			FramePacer framePacer = MakeFramePacer(targetSecondsPerFrame);
+			PacingClock pacingClock = { Win32_GetPacingSeconds, SleepIsGranular ? Win32_PacingSleep : nullptr };
+
+			// Fixed steps carry the time they don't use over to the next frame, & the render blends between the last two
+			bool isFixedTimestep = (settings.fixedUpdateDt > 0.0f);
+			int maxUpdatesPerFrame = (settings.maxUpdatesPerFrame > 0) ? settings.maxUpdatesPerFrame : 5;
+			FixedTimestep timestep = MakeFixedTimestep(isFixedTimestep ? settings.fixedUpdateDt : 1.0f, maxUpdatesPerFrame);
+			const void* lastSnapshot = GameMemory.SnapshotStorage[0];
+			bool isLastUpdateChanged = true;
 
-			Initialize(GameMemory, globalRenderBuffer);
+			Initialize(GameMemory, globalRenderBuffers[0]);
+
+			// With a render thread, this thread only handles the window & runs Update
+			InitializeSnapshotQueue(globalSnapshotQueue, GameMemory.SnapshotStorage[0], GameMemory.SnapshotStorage[1]);
+			std::thread renderer;
+			if (successfulMemoryAllocation && settings.isRenderThreaded)
+			{
+				globalIsRenderThreaded = true;
+				renderer = std::thread(Win32_RenderFrames, window, &GameMemory, settings.allocationFreeFromFrame);
+			}
 
 			// Main loop
 			while (successfulMemoryAllocation && IsRunning)
@@ -309,41 +501,83 @@ int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSetting
 				POINT mousePointer;
 				GetCursorPos(&mousePointer);	// mousePointer in screen coord
 				ScreenToClient(window, &mousePointer);	// convert screen coord to window coord
+				RECT clientRect = {0};
+				GetClientRect(window, &clientRect);
 				gameInput.mouse.x = mousePointer.x;
-				gameInput.mouse.y = globalRenderBuffer.height - mousePointer.y;
+				gameInput.mouse.y = (clientRect.bottom - clientRect.top) - mousePointer.y;
 
+				// A replay stands in for the live input & frame time, & ends the session when it runs out
+				const Input* frameInput = &gameInput;
+				float frameDt = lastDt;
+				if (settings.replayInputPath)
+				{
+					if (frameIndex >= (int)replay.frames.size())
+					{
+						break;
+					}
+					frameInput = &replay.frames[frameIndex].input;
+					frameDt = replay.frames[frameIndex].dt;
+				}
+				if (settings.recordInputPath)
+				{
+					RecordFrame(recording, *frameInput, frameDt);
+				}
 
-				UpdateAndRender(GameMemory, gameInput, globalRenderBuffer, lastDt);
-
+				// Once the game has had time to warm up its buffers, any heap allocation in a frame is a bug
+				BeginAllocationFrame();
+				bool isAllocationForbidden = (settings.allocationFreeFromFrame > 0) && (frameIndex >= settings.allocationFreeFromFrame);
+				SetHeapAllocationForbidden(isAllocationForbidden);
+				void* snapshot = globalIsRenderThreaded ? BeginWriteSnapshot(globalSnapshotQueue) : GameMemory.SnapshotStorage[0];
+				int updateCount = isFixedTimestep ? AdvanceFixedTimestep(timestep, frameDt) : 1;
+				if ((updateCount == 0) && (snapshot != lastSnapshot))
+				{
+					// Nothing new to simulate, so draw the last steps again, just further along
+					memcpy(snapshot, lastSnapshot, GameMemory.SnapshotStorageSpace);
+				}
+				bool isSnapshotChanged = false;
+				for (int update = 0; update < updateCount; update += 1)
+				{
+					isLastUpdateChanged = Update(GameMemory, (update == 0) ? *frameInput : MakeRepeatedStepInput(*frameInput), isFixedTimestep ? timestep.stepSeconds : frameDt, snapshot);
+					isSnapshotChanged = isSnapshotChanged || isLastUpdateChanged;
+				}
 
-				ResetButtons(&gameInput);
+				// Between steps the render still moves along, if the last step changed anything. Otherwise an unchanged frame
+				// would only draw & show the same picture again, so skip both & just keep pumping input
+				isSnapshotChanged = isSnapshotChanged || ((updateCount == 0) && isLastUpdateChanged);
+				bool isFrameSkipped = !isSnapshotChanged && !globalIsRedrawNeeded;
+				globalIsRedrawNeeded = false;
+				globalSnapshotAlphas[snapshot == GameMemory.SnapshotStorage[1]] = isFixedTimestep ? GetFixedTimestepAlpha(timestep) : 1.0f;
+				lastSnapshot = snapshot;
+				SetHeapAllocationForbidden(false);
 
 				// render visual
-				HDC deviceContext = GetDC(window);
-				Win32_DisplayglobalRenderBufferInWindow(deviceContext);
-				ReleaseDC(window, deviceContext);
+				if (!isFrameSkipped && globalIsRenderThreaded)
+				{
+					PublishSnapshot(globalSnapshotQueue);
+				}
+				else if (!isFrameSkipped)
+				{
+					Win32_RenderSnapshot(GameMemory, snapshot, isAllocationForbidden);
+				}
+				AllocationStats allocationStats = GetFrameAllocationStats();
+
+				// A release only counts as seen once an Update has run to see it
+				if (updateCount > 0)
+				{
+					ResetButtons(&gameInput);
+				}
 
 				// wait before starting next frame
-				float secondsElapsedForFrame = Win32_GetSecondsElapsed(LastCounter, Win32_GetWallClock());
-				float workTime = 1000.0f * secondsElapsedForFrame;
-				if (secondsElapsedForFrame < targetSecondsPerFrame)
+				float workTime = 1000.0f * Win32_GetSecondsElapsed(LastCounter, Win32_GetWallClock());
+				// A skipped frame shows nothing, so there's no need to spin to end it on time
+				bool isFrameMissed = false;
+				if (isFrameSkipped)
 				{
-					if (SleepIsGranular)
-					{
-						DWORD SleepMS = (DWORD)(1000.0f * (targetSecondsPerFrame - secondsElapsedForFrame));
-						if (SleepMS > 0)
-						{
-							Sleep(SleepMS);
-						}
-					}
-					while(secondsElapsedForFrame < targetSecondsPerFrame)
-					{
-						secondsElapsedForFrame = Win32_GetSecondsElapsed(LastCounter, Win32_GetWallClock());
-					}
+					SleepUntilFrameEnd(framePacer, pacingClock, Win32_GetSeconds(LastCounter));
 				}
 				else
 				{
-					// TODO MISSED FRAME RATE
+					isFrameMissed = WaitForFrameEnd(framePacer, pacingClock, Win32_GetSeconds(LastCounter));
 				}
 
 				// Take end of frame measurements
@@ -364,9 +598,41 @@ int Win32Main(HINSTANCE instance, const WindowSettings &settings = WindowSetting
 				sprintf_s(buffer, DEBUG_BUFFER_SIZE, "%.02f ms, %.02f ms/f,  %.02f f/s,  %.02f MC/f\n", workTime, msPerFrame, FPS, MCPF);
 				OutputDebugStringA(buffer);
 
+				if (isFrameMissed)
+				{
+					sprintf_s(buffer, DEBUG_BUFFER_SIZE, "Missed frame, %d of %d missed, worst by %.02f ms\n", framePacer.stats.missedFrameCount,
+						framePacer.stats.frameCount, 1000.0 * framePacer.stats.worstMissSeconds);
+					OutputDebugStringA(buffer);
+				}
+
+				if (IsTrackingAllocations())
+				{
+					sprintf_s(buffer, DEBUG_BUFFER_SIZE, "%d allocs (%d render, %d clip, %d file, %d collision), %zu KB in use, %zu KB peak\n",
+						GetTotalAllocationCount(allocationStats), allocationStats.allocationCount[ALLOCATION_TAG_RENDER],
+						allocationStats.allocationCount[ALLOCATION_TAG_CLIP], allocationStats.allocationCount[ALLOCATION_TAG_FILE],
+						allocationStats.allocationCount[ALLOCATION_TAG_COLLISION], allocationStats.bytesInUse / 1024,
+						allocationStats.peakBytesInUse / 1024);
+					OutputDebugStringA(buffer);
+				}
+
 				// Reset measurementsfor next frame
 				LastCounter = EndCounter;
 				LastCycleCount = EndCycleCount;
+				frameIndex += 1;
+			}
+
+			if (globalIsRenderThreaded)
+			{
+				CloseSnapshotQueue(globalSnapshotQueue);
+				renderer.join();
+				globalIsRenderThreaded = false;
+			}
+			ClosePresentQueue(globalPresentQueue);
+			presenter.join();
+
+			if (settings.recordInputPath && !WriteInputRecording(settings.recordInputPath, recording))
+			{
+				OutputDebugStringA("Unable to write input recording\n");
 			}
 		}
 		else
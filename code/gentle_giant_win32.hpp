@@ -11,6 +11,13 @@ namespace gentle
 		int height;
 		char* title;
 		int targetFPS;
+		float fixedUpdateDt;	// Run as many Updates of exactly this many seconds as each frame's time adds up to, & interpolate the render between them. 0 runs one Update a frame, of the frame's time
+		int maxUpdatesPerFrame;	// With fixedUpdateDt, the most Updates a frame runs to catch up after slow ones. 0 uses 5
+		int renderBufferCount;	// Buffers the game renders into while an earlier frame is shown, up to MAX_PRESENT_BUFFERS. 0 uses 2
+		bool isRenderThreaded;	// Render each frame on a thread of its own while the window's thread runs the next Update
+		int allocationFreeFromFrame;	// With allocation tracking built in, assert Update & Render don't allocate from this frame on. 0 never checks
+		const char* recordInputPath;	// Save every frame's input & dt here on exit, see input_recording.hpp. nullptr records nothing
+		const char* replayInputPath;	// Play back a recorded session in place of live input & frame times, then exit
 	};
 
 	int Win32Main(HINSTANCE instance);
@@ -1,12 +1,16 @@
 #include "math.hpp"
 #include <math.h>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <tuple>
 #include "geometry.hpp"
 
 namespace gentle
 {
 	Matrix4x4<float> MakeProjectionMatrix(float fieldOfVewDeg, float aspectRatio, float nearPlane, float farPlane)
 	{
-		float inverseTangent = 1.0f / std::tanf(fieldOfVewDeg * 0.5f * 3.14159f / 180.0f);
+		float inverseTangent = 1.0f / tanf(fieldOfVewDeg * 0.5f * 3.14159f / 180.0f);
 
 		Matrix4x4<float> matrix;
 		matrix.m[0][0] = aspectRatio * inverseTangent;
@@ -21,8 +25,8 @@ namespace gentle
 
 	void SetZAxisRotationMatrix(float theta, Matrix4x4<float> &matrix)
 	{
-		float cos = std::cosf(theta);
-		float sin = std::sinf(theta);
+		float cos = cosf(theta);
+		float sin = sinf(theta);
 		matrix.m[0][0] = cos;
 		matrix.m[0][1] = -sin;
 		matrix.m[1][0] = sin;
@@ -38,8 +42,8 @@ namespace gentle
 
 	void SetYAxisRotationMatrix(float theta, Matrix4x4<float> &matrix)
 	{
-		float cos = std::cosf(theta);
-		float sin = std::sinf(theta);
+		float cos = cosf(theta);
+		float sin = sinf(theta);
 		matrix.m[0][0] = cos;
 		matrix.m[0][2] = sin;
 		matrix.m[2][0] = -sin;
@@ -55,8 +59,8 @@ namespace gentle
 
 	void SetXAxisRotationMatrix(float theta, Matrix4x4<float> &matrix)
 	{
-		float cos = std::cosf(theta);
-		float sin = std::sinf(theta);
+		float cos = cosf(theta);
+		float sin = sinf(theta);
 		matrix.m[1][1] = cos;
 		matrix.m[1][2] = -sin;
 		matrix.m[2][1] = sin;
@@ -247,4 +251,480 @@ namespace gentle
 		return 0;
 	}
 	template int ClipTriangleAgainstPlane(const Plane<float> &plane, Triangle4d<float> &inputTriangle, Triangle4d<float> &outputTriangle1, Triangle4d<float> &outputTriangle2);
+
+	template<typename T>
+	static T DistanceFromHomogeneousPlane(const Vec4<T> &plane, const Vec4<T> &point)
+	{
+		return (plane.x * point.x) + (plane.y * point.y) + (plane.z * point.z) + (plane.w * point.w);
+	}
+
+	template<typename T>
+	int ClipPolygonAgainstPlane(const Vec4<T> &plane, const Vec4<T>* inputPoints, int inputCount, Vec4<T>* outputPoints)
+	{
+		int outputCount = 0;
+		if (inputCount == 0)
+		{
+			return 0;
+		}
+
+		// Walk each edge of the polygon from the previous point to the current one
+		const Vec4<T>* previous = &inputPoints[inputCount - 1];
+		T previousDistance = DistanceFromHomogeneousPlane(plane, *previous);
+		for (int i = 0; i < inputCount; i += 1)
+		{
+			const Vec4<T>* current = &inputPoints[i];
+			T currentDistance = DistanceFromHomogeneousPlane(plane, *current);
+
+			// The edge crosses the plane, so add the point where it does
+			if ((previousDistance >= (T)0) != (currentDistance >= (T)0))
+			{
+				T t = previousDistance / (previousDistance - currentDistance);
+				Vec4<T> &intersection = outputPoints[outputCount];
+				intersection.x = previous->x + ((current->x - previous->x) * t);
+				intersection.y = previous->y + ((current->y - previous->y) * t);
+				intersection.z = previous->z + ((current->z - previous->z) * t);
+				intersection.w = previous->w + ((current->w - previous->w) * t);
+				outputCount += 1;
+			}
+
+			if (currentDistance >= (T)0)
+			{
+				outputPoints[outputCount] = *current;
+				outputCount += 1;
+			}
+
+			previous = current;
+			previousDistance = currentDistance;
+		}
+
+		return outputCount;
+	}
+	template int ClipPolygonAgainstPlane(const Vec4<float> &plane, const Vec4<float>* inputPoints, int inputCount, Vec4<float>* outputPoints);
+
+	template<typename T>
+	Vec4<T> MakePlaneBeforeTransform(const Vec4<T> &plane, const Matrix4x4<T> &matrix)
+	{
+		// A point p ends up on the plane when (p * matrix) . plane == 0, which is p . (matrix * plane)
+		const T (&m)[4][4] = matrix.m;
+		Vec4<T> result;
+		result.x = (m[0][0] * plane.x) + (m[0][1] * plane.y) + (m[0][2] * plane.z) + (m[0][3] * plane.w);
+		result.y = (m[1][0] * plane.x) + (m[1][1] * plane.y) + (m[1][2] * plane.z) + (m[1][3] * plane.w);
+		result.z = (m[2][0] * plane.x) + (m[2][1] * plane.y) + (m[2][2] * plane.z) + (m[2][3] * plane.w);
+		result.w = (m[3][0] * plane.x) + (m[3][1] * plane.y) + (m[3][2] * plane.z) + (m[3][3] * plane.w);
+		return result;
+	}
+	template Vec4<float> MakePlaneBeforeTransform(const Vec4<float> &plane, const Matrix4x4<float> &matrix);
+
+	template<typename T>
+	bool IsSphereOutsidePlane(const Sphere<T> &sphere, const Vec4<T> &plane)
+	{
+		// Compare squares rather than normalizing the plane. The centre has to be on the outside for the sphere to be
+		T distance = (plane.x * sphere.centre.x) + (plane.y * sphere.centre.y) + (plane.z * sphere.centre.z) + plane.w;
+		T normalLengthSquared = (plane.x * plane.x) + (plane.y * plane.y) + (plane.z * plane.z);
+		return (distance < (T)0) && ((distance * distance) > (sphere.radius * sphere.radius * normalLengthSquared));
+	}
+	template bool IsSphereOutsidePlane(const Sphere<float> &sphere, const Vec4<float> &plane);
+
+	template<typename T>
+	bool IsBoxOutsidePlane(const AxisAlignedBox<T> &box, const Vec4<T> &plane)
+	{
+		// Only the corner furthest along the plane normal needs testing
+		T x = (plane.x >= (T)0) ? box.max.x : box.min.x;
+		T y = (plane.y >= (T)0) ? box.max.y : box.min.y;
+		T z = (plane.z >= (T)0) ? box.max.z : box.min.z;
+		return ((plane.x * x) + (plane.y * y) + (plane.z * z) + plane.w) < (T)0;
+	}
+	template bool IsBoxOutsidePlane(const AxisAlignedBox<float> &box, const Vec4<float> &plane);
+
+	/**
+	 * getPoint(i) returns vertex i as a Vec4. Vertices get divided by w, so bounds are left invalid when a w isn't positive,
+	 * as the vertex is then at infinity or its side of a plane flips.
+	 */
+	template<typename T, typename GetPoint>
+	static void ComputeBoundsOfPoints(size_t count, GetPoint getPoint, Bounds<T> &bounds)
+	{
+		bounds.isValid = false;
+		if (count == 0)
+		{
+			return;
+		}
+
+		AxisAlignedBox<T> &box = bounds.box;
+		for (size_t i = 0; i < count; i += 1)
+		{
+			Vec4<T> p = getPoint(i);
+			if (!(p.w > (T)0))
+			{
+				return;
+			}
+			Vec3<T> point = { p.x / p.w, p.y / p.w, p.z / p.w };
+			if (i == 0)
+			{
+				box.min = point;
+				box.max = point;
+			}
+			box.min = { std::min(box.min.x, point.x), std::min(box.min.y, point.y), std::min(box.min.z, point.z) };
+			box.max = { std::max(box.max.x, point.x), std::max(box.max.y, point.y), std::max(box.max.z, point.z) };
+		}
+
+		// Centre the sphere on the box, then take the furthest vertex from it. Tighter than the half diagonal of the box
+		Sphere<T> &sphere = bounds.sphere;
+		sphere.centre = { (box.min.x + box.max.x) * (T)0.5, (box.min.y + box.max.y) * (T)0.5, (box.min.z + box.max.z) * (T)0.5 };
+		T radiusSquared = (T)0;
+		for (size_t i = 0; i < count; i += 1)
+		{
+			Vec4<T> p = getPoint(i);
+			Vec3<T> offset = { (p.x / p.w) - sphere.centre.x, (p.y / p.w) - sphere.centre.y, (p.z / p.w) - sphere.centre.z };
+			radiusSquared = std::max(radiusSquared, DotProduct(offset, offset));
+		}
+		sphere.radius = sqrtf(radiusSquared);
+		bounds.isValid = true;
+	}
+
+	template<typename T>
+	void ComputeBounds(Mesh<T> &mesh)
+	{
+		ComputeBoundsOfPoints(mesh.triangles.size() * 3, [&](size_t i) { return mesh.triangles[i / 3].p[i % 3]; }, mesh.bounds);
+	}
+	template void ComputeBounds(Mesh<float> &mesh);
+
+	template<typename T>
+	void ComputeBounds(IndexedMesh<T> &mesh)
+	{
+		const VertexStream<T> &vertices = mesh.vertices;
+		bool hasW = !vertices.w.empty();
+		ComputeBoundsOfPoints(vertices.x.size(), [&](size_t i) { return Vec4<T>{ vertices.x[i], vertices.y[i], vertices.z[i], hasW ? vertices.w[i] : (T)1 }; }, mesh.bounds);
+	}
+	template void ComputeBounds(IndexedMesh<float> &mesh);
+
+	template<typename T>
+	void FillVertexStream(const Mesh<T> &mesh, VertexStream<T> &stream)
+	{
+		stream.x.clear();
+		stream.y.clear();
+		stream.z.clear();
+		stream.w.clear();
+
+		size_t count = mesh.triangles.size() * 3;
+		stream.x.reserve(count);
+		stream.y.reserve(count);
+		stream.z.reserve(count);
+
+		bool isEveryWOne = true;
+		for (const Triangle4d<T> &tri : mesh.triangles)
+		{
+			for (int i = 0; i < 3; i += 1)
+			{
+				stream.x.push_back(tri.p[i].x);
+				stream.y.push_back(tri.p[i].y);
+				stream.z.push_back(tri.p[i].z);
+				isEveryWOne = isEveryWOne && (tri.p[i].w == (T)1);
+			}
+		}
+
+		if (!isEveryWOne)
+		{
+			stream.w.reserve(count);
+			for (const Triangle4d<T> &tri : mesh.triangles)
+			{
+				for (int i = 0; i < 3; i += 1)
+				{
+					stream.w.push_back(tri.p[i].w);
+				}
+			}
+		}
+	}
+	template void FillVertexStream(const Mesh<float> &mesh, VertexStream<float> &stream);
+
+	template<typename T>
+	VertexStream<T> MakeVertexStream(const Mesh<T> &mesh)
+	{
+		VertexStream<T> stream;
+		FillVertexStream(mesh, stream);
+		return stream;
+	}
+	template VertexStream<float> MakeVertexStream(const Mesh<float> &mesh);
+
+	template<typename T>
+	Matrix4x4<T> MakeNormalMatrix(const Matrix4x4<T> &transformMatrix)
+	{
+		// Vectors are rows multiplied on the left, so the cross product of two transformed edges is the cross product of the
+		// original edges multiplied with the cofactor matrix
+		const T (&m)[4][4] = transformMatrix.m;
+		Matrix4x4<T> matrix;
+		for (int row = 0; row < 3; row += 1)
+		{
+			int row1 = (row + 1) % 3;
+			int row2 = (row + 2) % 3;
+			for (int col = 0; col < 3; col += 1)
+			{
+				int col1 = (col + 1) % 3;
+				int col2 = (col + 2) % 3;
+				matrix.m[row][col] = (m[row1][col1] * m[row2][col2]) - (m[row1][col2] * m[row2][col1]);
+			}
+		}
+		matrix.m[3][3] = (T)1;
+		return matrix;
+	}
+	template Matrix4x4<float> MakeNormalMatrix(const Matrix4x4<float> &transformMatrix);
+
+	template<typename T>
+	void ComputeFaceNormals(IndexedMesh<T> &mesh)
+	{
+		size_t triangleCount = mesh.indices.size() / 3;
+		mesh.faceNormals.x.resize(triangleCount);
+		mesh.faceNormals.y.resize(triangleCount);
+		mesh.faceNormals.z.resize(triangleCount);
+		mesh.faceNormals.w.clear();
+
+		const VertexStream<T> &vertices = mesh.vertices;
+		for (size_t triangle = 0; triangle < triangleCount; triangle += 1)
+		{
+			Vec4<T> p[3];
+			for (int i = 0; i < 3; i += 1)
+			{
+				uint32_t vertex = mesh.indices[(triangle * 3) + i];
+				p[i] = { vertices.x[vertex], vertices.y[vertex], vertices.z[vertex], (T)1 };
+			}
+
+			Vec4<T> line1 = SubtractVectors(p[1], p[0]);
+			Vec4<T> line2 = SubtractVectors(p[2], p[0]);
+			Vec4<T> normal = UnitVector(CrossProduct(line1, line2));
+			mesh.faceNormals.x[triangle] = normal.x;
+			mesh.faceNormals.y[triangle] = normal.y;
+			mesh.faceNormals.z[triangle] = normal.z;
+		}
+
+		mesh.faceNormalsVersion += 1;
+	}
+	template void ComputeFaceNormals(IndexedMesh<float> &mesh);
+
+	template<typename T>
+	IndexedMesh<T> MakeIndexedMesh(const Mesh<T> &mesh)
+	{
+		IndexedMesh<T> indexedMesh;
+		indexedMesh.indices.reserve(mesh.triangles.size() * 3);
+
+		bool isEveryWOne = true;
+		std::map<std::tuple<T, T, T, T>, uint32_t> vertexIndices;
+		for (const Triangle4d<T> &tri : mesh.triangles)
+		{
+			for (int i = 0; i < 3; i += 1)
+			{
+				const Vec4<T> &p = tri.p[i];
+				auto inserted = vertexIndices.insert({ std::make_tuple(p.x, p.y, p.z, p.w), (uint32_t)indexedMesh.vertices.x.size() });
+				if (inserted.second)
+				{
+					indexedMesh.vertices.x.push_back(p.x);
+					indexedMesh.vertices.y.push_back(p.y);
+					indexedMesh.vertices.z.push_back(p.z);
+					indexedMesh.vertices.w.push_back(p.w);
+					isEveryWOne = isEveryWOne && (p.w == (T)1);
+				}
+				indexedMesh.indices.push_back(inserted.first->second);
+			}
+		}
+
+		if (isEveryWOne)
+		{
+			indexedMesh.vertices.w.clear();
+		}
+		ComputeFaceNormals(indexedMesh);
+		ComputeBounds(indexedMesh);
+		return indexedMesh;
+	}
+	template IndexedMesh<float> MakeIndexedMesh(const Mesh<float> &mesh);
+	template<typename T>
+	void BuildClusters(IndexedMesh<T> &mesh, int maxTrianglesPerCluster)
+	{
+		const VertexStream<T> &vertices = mesh.vertices;
+		const std::vector<uint32_t> &indices = mesh.indices;
+		size_t vertexCount = vertices.x.size();
+		size_t triangleCount = indices.size() / 3;
+		bool hasW = !vertices.w.empty();
+
+		// Unit normal of every triangle, left at zero for triangles without any area
+		std::vector<Vec3<T>> normals(triangleCount, Vec3<T>{ (T)0, (T)0, (T)0 });
+		for (size_t triangle = 0; triangle < triangleCount; triangle += 1)
+		{
+			Vec4<T> p[3];
+			for (int i = 0; i < 3; i += 1)
+			{
+				uint32_t vertex = indices[(triangle * 3) + i];
+				p[i] = { vertices.x[vertex], vertices.y[vertex], vertices.z[vertex], (T)1 };
+			}
+			Vec4<T> normal = CrossProduct(SubtractVectors(p[1], p[0]), SubtractVectors(p[2], p[0]));
+			T length = sqrtf((normal.x * normal.x) + (normal.y * normal.y) + (normal.z * normal.z));
+			if (length > (T)0)
+			{
+				normals[triangle] = { normal.x / length, normal.y / length, normal.z / length };
+			}
+		}
+
+		// The triangles using each vertex are vertexTriangles[vertexTriangleStarts[vertex]] up to vertexTriangleStarts[vertex + 1]
+		std::vector<uint32_t> vertexTriangleStarts(vertexCount + 1, 0);
+		for (uint32_t vertex : indices)
+		{
+			vertexTriangleStarts[vertex + 1] += 1;
+		}
+		for (size_t vertex = 0; vertex < vertexCount; vertex += 1)
+		{
+			vertexTriangleStarts[vertex + 1] += vertexTriangleStarts[vertex];
+		}
+		std::vector<uint32_t> vertexTriangles(indices.size());
+		std::vector<uint32_t> vertexTriangleEnds(vertexTriangleStarts.begin(), vertexTriangleStarts.end() - 1);
+		for (size_t i = 0; i < indices.size(); i += 1)
+		{
+			vertexTriangles[vertexTriangleEnds[indices[i]]] = (uint32_t)(i / 3);
+			vertexTriangleEnds[indices[i]] += 1;
+		}
+
+		// Stamps hold the cluster a triangle was last put on the frontier of, or a vertex was last copied into
+		const uint32_t NO_CLUSTER = 0xFFFFFFFF;
+		std::vector<bool> isClustered(triangleCount, false);
+		std::vector<uint32_t> frontierStamps(triangleCount, NO_CLUSTER);
+		std::vector<uint32_t> vertexStamps(vertexCount, NO_CLUSTER);
+		std::vector<uint32_t> clusterVertices(vertexCount);
+
+		VertexStream<T> clusteredVertices;
+		std::vector<uint32_t> clusteredIndices;
+		clusteredIndices.reserve(indices.size());
+		std::vector<Cluster<T>> clusters;
+		std::vector<uint32_t> frontier;
+		std::vector<uint32_t> trianglesInCluster;
+
+		size_t seed = 0;
+		while (true)
+		{
+			while ((seed < triangleCount) && isClustered[seed])
+			{
+				seed += 1;
+			}
+			if (seed == triangleCount)
+			{
+				break;
+			}
+
+			uint32_t clusterId = (uint32_t)clusters.size();
+			Cluster<T> cluster;
+			cluster.firstTriangle = (uint32_t)(clusteredIndices.size() / 3);
+			cluster.firstVertex = (uint32_t)clusteredVertices.x.size();
+			Vec3<T> normalSum = { (T)0, (T)0, (T)0 };
+			frontier.clear();
+			trianglesInCluster.clear();
+
+			// Grow the cluster from the seed one neighbouring triangle at a time
+			uint32_t next = (uint32_t)seed;
+			while (true)
+			{
+				isClustered[next] = true;
+				trianglesInCluster.push_back(next);
+				normalSum = { normalSum.x + normals[next].x, normalSum.y + normals[next].y, normalSum.z + normals[next].z };
+				for (int i = 0; i < 3; i += 1)
+				{
+					uint32_t vertex = indices[(next * 3) + i];
+					if (vertexStamps[vertex] != clusterId)
+					{
+						vertexStamps[vertex] = clusterId;
+						clusterVertices[vertex] = (uint32_t)clusteredVertices.x.size();
+						clusteredVertices.x.push_back(vertices.x[vertex]);
+						clusteredVertices.y.push_back(vertices.y[vertex]);
+						clusteredVertices.z.push_back(vertices.z[vertex]);
+						if (hasW)
+						{
+							clusteredVertices.w.push_back(vertices.w[vertex]);
+						}
+					}
+					clusteredIndices.push_back(clusterVertices[vertex]);
+
+					for (uint32_t j = vertexTriangleStarts[vertex]; j < vertexTriangleStarts[vertex + 1]; j += 1)
+					{
+						uint32_t neighbour = vertexTriangles[j];
+						if (!isClustered[neighbour] && (frontierStamps[neighbour] != clusterId))
+						{
+							frontierStamps[neighbour] = clusterId;
+							frontier.push_back(neighbour);
+						}
+					}
+				}
+
+				if ((int)trianglesInCluster.size() >= maxTrianglesPerCluster)
+				{
+					break;
+				}
+
+				// Take the neighbour facing closest to the cluster so far, preferring ones that share an edge & so add fewer vertices
+				size_t best = frontier.size();
+				T bestScore = (T)0;
+				for (size_t i = 0; i < frontier.size(); i += 1)
+				{
+					uint32_t candidate = frontier[i];
+					int sharedVertexCount = 0;
+					for (int j = 0; j < 3; j += 1)
+					{
+						sharedVertexCount += (vertexStamps[indices[(candidate * 3) + j]] == clusterId) ? 1 : 0;
+					}
+					T score = DotProduct(normals[candidate], normalSum) / (T)trianglesInCluster.size() + ((T)0.5 * (T)sharedVertexCount);
+					if ((best == frontier.size()) || (score > bestScore))
+					{
+						best = i;
+						bestScore = score;
+					}
+				}
+				if (best == frontier.size())
+				{
+					break;
+				}
+				next = frontier[best];
+				frontier[best] = frontier.back();
+				frontier.pop_back();
+			}
+
+			cluster.triangleCount = (uint32_t)trianglesInCluster.size();
+			cluster.vertexCount = (uint32_t)clusteredVertices.x.size() - cluster.firstVertex;
+
+			// Narrowest cone around the face normals that's centred on their average
+			T axisLength = sqrtf(DotProduct(normalSum, normalSum));
+			cluster.coneCutoff = (T)1;
+			cluster.coneAxis = { (T)0, (T)0, (T)0 };
+			if (axisLength > (T)0)
+			{
+				cluster.coneAxis = { normalSum.x / axisLength, normalSum.y / axisLength, normalSum.z / axisLength };
+				T minimumDot = (T)1;
+				for (uint32_t triangle : trianglesInCluster)
+				{
+					const Vec3<T> &normal = normals[triangle];
+					if ((normal.x != (T)0) || (normal.y != (T)0) || (normal.z != (T)0))
+					{
+						minimumDot = std::min(minimumDot, DotProduct(normal, cluster.coneAxis));
+					}
+				}
+				if (minimumDot > (T)0)
+				{
+					cluster.coneCutoff = sqrtf((T)1 - (minimumDot * minimumDot));
+				}
+			}
+
+			// A sphere that can't be worked out gets an infinite radius, so the cluster never gets culled
+			Bounds<T> bounds;
+			ComputeBoundsOfPoints(cluster.vertexCount, [&](size_t i)
+			{
+				size_t vertex = cluster.firstVertex + i;
+				return Vec4<T>{ clusteredVertices.x[vertex], clusteredVertices.y[vertex], clusteredVertices.z[vertex], hasW ? clusteredVertices.w[vertex] : (T)1 };
+			}, bounds);
+			cluster.sphere = bounds.sphere;
+			if (!bounds.isValid)
+			{
+				cluster.sphere = { { (T)0, (T)0, (T)0 }, std::numeric_limits<T>::infinity() };
+			}
+			clusters.push_back(cluster);
+		}
+
+		mesh.vertices = std::move(clusteredVertices);
+		mesh.indices = std::move(clusteredIndices);
+		mesh.clusters = std::move(clusters);
+		ComputeFaceNormals(mesh);
+		ComputeBounds(mesh);
+	}
+	template void BuildClusters(IndexedMesh<float> &mesh, int maxTrianglesPerCluster);
 }
\ No newline at end of file
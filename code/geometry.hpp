@@ -2,6 +2,7 @@
 #define GEOMETRY_H
 
 #include "math.hpp"
+#include <stdint.h>
 #include <vector>
 
 namespace gentle
@@ -34,10 +35,87 @@ namespace gentle
 		Vec3<T> normal;
 	};
 
+	template<typename T>
+	struct Sphere
+	{
+		Vec3<T> centre;
+		T radius;
+	};
+
+	template<typename T>
+	struct AxisAlignedBox
+	{
+		Vec3<T> min;
+		Vec3<T> max;
+	};
+
+	/**
+	 * Volumes that contain every vertex of a mesh, in model space. Worked out by ComputeBounds, which has to be called again
+	 * after the vertices change. Meshes without valid bounds never get culled as a whole.
+	 */
+	template<typename T>
+	struct Bounds
+	{
+		bool isValid = false;
+		Sphere<T> sphere;
+		AxisAlignedBox<T> box;
+	};
+
 	template<typename T>
 	struct Mesh
 	{
 		std::vector<Triangle4d<T>> triangles;
+		Bounds<T> bounds;	// Call ComputeBounds again after editing triangles, or the mesh can get culled while part of it is in view
+	};
+
+	/**
+	 * Lighting worked out for one placement of an IndexedMesh the last time it was rendered. Only depends on the face normals,
+	 * the model transform & the light, so it can be reused for as long as none of them changes. Rendering writes to it, so
+	 * keep one for each instance of a mesh that gets drawn & don't render with the same one on two threads at once.
+	 */
+	template<typename T>
+	struct ShadingCache
+	{
+		bool isValid = false;
+		const VertexStream<T>* faceNormals = nullptr;	// Face normals the colours were worked out from
+		uint32_t faceNormalsVersion = 0;				// IndexedMesh::faceNormalsVersion of those normals at the time
+		Matrix4x4<T> transformMatrix;
+		Vec3<T> lightDirection;
+		VertexStream<T> worldNormals;		// faceNormals multiplied with MakeNormalMatrix(transformMatrix). Not unit length
+		std::vector<unsigned int> colors;	// One per triangle
+	};
+
+	/**
+	 * A run of triangles in an IndexedMesh whose indices only point at its own run of vertices, so the whole cluster can be
+	 * thrown away before any of its vertices get transformed. Built by BuildClusters.
+	 */
+	template<typename T>
+	struct Cluster
+	{
+		uint32_t firstTriangle;
+		uint32_t triangleCount;
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		Sphere<T> sphere;	// Around the vertices of the cluster, in model space
+		Vec3<T> coneAxis;	// Unit average of the face normals
+		T coneCutoff;		// Sine of the angle from coneAxis to the furthest face normal. 1 when they're too spread out to face away together
+	};
+
+	/**
+	 * Each unique vertex is stored once & triangles refer to them by index, three indices per triangle. Vertices shared by
+	 * several triangles then only get transformed once.
+	 * Call ComputeFaceNormals after changing the vertices or indices, which also makes any shading caches of the mesh start
+	 * again, & ComputeBounds after changing the vertices.
+	 */
+	template<typename T>
+	struct IndexedMesh
+	{
+		VertexStream<T> vertices;
+		std::vector<uint32_t> indices;
+		Bounds<T> bounds;
+		VertexStream<T> faceNormals;	// Unit normal of each triangle in model space. Worked out while rendering when empty
+		uint32_t faceNormalsVersion = 0;	// Bumped by ComputeFaceNormals, so shading caches know their colours are out of date
+		std::vector<Cluster<T>> clusters;		// Empty until BuildClusters is called, & out of date once the vertices or indices change
 	};
 
 	template<typename T>
@@ -83,6 +161,79 @@ namespace gentle
 	template<typename T>
 	int ClipTriangleAgainstPlane(const Plane<T> &plane, Triangle4d<T> &inputTriangle, Triangle4d<T> &outputTriangle1, Triangle4d<T> &outputTriangle2);
 
+	/**
+	 * Sutherland-Hodgman clip of the convex polygon inputPoints against the plane (a, b, c, d) given as plane.x, plane.y, plane.z & plane.w.
+	 * Keeps the part of the polygon where (a * x) + (b * y) + (c * z) + (d * w) >= 0. The points are homogeneous so this works in
+	 * clip space before the perspective divide.
+	 * outputPoints needs room for inputCount + 1 points. Returns the number of points written, which is less than 3 if nothing is left.
+	 */
+	template<typename T>
+	int ClipPolygonAgainstPlane(const Vec4<T> &plane, const Vec4<T>* inputPoints, int inputCount, Vec4<T>* outputPoints);
+
+	/**
+	 * Plane (a, b, c, d) holding the points that matrix moves onto plane, i.e. with matrix a model view projection matrix,
+	 * the model space plane matching a clip space one. Which side is inside is kept & the result isn't normalized.
+	 */
+	template<typename T>
+	Vec4<T> MakePlaneBeforeTransform(const Vec4<T> &plane, const Matrix4x4<T> &matrix);
+
+	// True when the whole of sphere is on the outside of the plane (a, b, c, d), i.e. where (a * x) + (b * y) + (c * z) + d < 0
+	template<typename T>
+	bool IsSphereOutsidePlane(const Sphere<T> &sphere, const Vec4<T> &plane);
+
+	// True when the whole of box is on the outside of the plane (a, b, c, d), i.e. where (a * x) + (b * y) + (c * z) + d < 0
+	template<typename T>
+	bool IsBoxOutsidePlane(const AxisAlignedBox<T> &box, const Vec4<T> &plane);
+
+	/**
+	 * Work out the box around every vertex of mesh & a sphere around the box. Leaves bounds invalid for a mesh without
+	 * any vertices.
+	 */
+	template<typename T>
+	void ComputeBounds(Mesh<T> &mesh);
+
+	template<typename T>
+	void ComputeBounds(IndexedMesh<T> &mesh);
+
+	/**
+	 * Copy the vertices of mesh into a structure of arrays, three per triangle in the same order as mesh.triangles.
+	 * w is left empty when every vertex has a w of 1.
+	 */
+	template<typename T>
+	VertexStream<T> MakeVertexStream(const Mesh<T> &mesh);
+
+	// Same as MakeVertexStream, but refills stream in place so its arrays get reused rather than allocated again
+	template<typename T>
+	void FillVertexStream(const Mesh<T> &mesh, VertexStream<T> &stream);
+
+	/**
+	 * Matrix that transforms normals the same way transformMatrix transforms the surfaces they belong to, i.e. the cofactor
+	 * matrix of its upper 3x3. Normals keep their direction relative to the surface, even with non-uniform scaling or
+	 * mirroring, but not their length.
+	 */
+	template<typename T>
+	Matrix4x4<T> MakeNormalMatrix(const Matrix4x4<T> &transformMatrix);
+
+	// Work out the unit normal of every triangle in mesh & throw away its shading cache
+	template<typename T>
+	void ComputeFaceNormals(IndexedMesh<T> &mesh);
+
+	/**
+	 * Build an indexed mesh from mesh, merging vertices with exactly the same position into one.
+	 * Face normals & bounds get worked out too.
+	 */
+	template<typename T>
+	IndexedMesh<T> MakeIndexedMesh(const Mesh<T> &mesh);
+
+	/**
+	 * Split mesh into clusters of up to maxTrianglesPerCluster neighbouring triangles, grown so their face normals point
+	 * roughly the same way. Triangles & vertices get reordered so each cluster's are contiguous, with vertices on the border
+	 * between clusters copied into each of them. Face normals & bounds get worked out again.
+	 * Worth doing once at load time for big meshes, where whole clusters facing away or off screen can be skipped.
+	 */
+	template<typename T>
+	void BuildClusters(IndexedMesh<T> &mesh, int maxTrianglesPerCluster = 64);
+
 	Matrix4x4<float> MakeProjectionMatrix(float fieldOfVewDeg, float aspectRatio, float nearPlane, float farPlane);
 
 	void SetZAxisRotationMatrix(float theta, Matrix4x4<float> &matrix);
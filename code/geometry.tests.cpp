@@ -1,4 +1,7 @@
 #include "geometry.hpp"
+#include "file.hpp"
+#include <math.h>
+#include <stdio.h>
 
 void RunGeometryTests()
 {
@@ -36,4 +39,167 @@ void RunGeometryTests()
 	assert(result.y == 1.0f);
 	assert(result.z == 0.0f);
 
+
+	// ClipPolygonAgainstPlane test
+	// Keeping x <= 1 cuts the corner off the triangle, leaving a quad
+	gentle::Vec4<float> triangle[3] = {
+		{ 0.0f, 0.0f, 0.0f, 1.0f },
+		{ 2.0f, 0.0f, 0.0f, 1.0f },
+		{ 0.0f, 2.0f, 0.0f, 1.0f }
+	};
+	gentle::Vec4<float> clipped[4];
+	gentle::Vec4<float> keepXLessThanOne = { -1.0f, 0.0f, 0.0f, 1.0f };
+	int clippedCount = gentle::ClipPolygonAgainstPlane(keepXLessThanOne, triangle, 3, clipped);
+
+	assert(clippedCount == 4);
+	assert(clipped[0].x == 0.0f && clipped[0].y == 0.0f);
+	assert(clipped[1].x == 1.0f && clipped[1].y == 0.0f);
+	assert(clipped[2].x == 1.0f && clipped[2].y == 1.0f);
+	assert(clipped[3].x == 0.0f && clipped[3].y == 2.0f);
+
+	// Entirely outside the plane leaves nothing
+	gentle::Vec4<float> keepXMoreThanFive = { 1.0f, 0.0f, 0.0f, -5.0f };
+	clippedCount = gentle::ClipPolygonAgainstPlane(keepXMoreThanFive, triangle, 3, clipped);
+
+	assert(clippedCount == 0);
+
+	// MakeNormalMatrix keeps normals perpendicular through non-uniform scaling & mirroring. The cross product of the edges
+	// of a transformed triangle is the cross product of the original edges multiplied with the normal matrix
+	gentle::Matrix4x4<float> transform = gentle::MultiplyMatrixWithMatrix(gentle::MakeYAxisRotationMatrix(0.7f), gentle::MakeXAxisRotationMatrix(-0.3f));
+	gentle::Matrix4x4<float> scale = gentle::MakeIdentityMatrix<float>();
+	scale.m[0][0] = 2.0f;
+	scale.m[1][1] = -0.5f;
+	scale.m[2][2] = 3.0f;
+	transform = gentle::MultiplyMatrixWithMatrix(scale, transform);
+	transform = gentle::MultiplyMatrixWithMatrix(transform, gentle::MakeTranslationMatrix(5.0f, -1.0f, 2.0f));
+
+	gentle::Vec4<float> corners[3] = { { 1.0f, 0.0f, 0.5f, 1.0f }, { 0.0f, 2.0f, -1.0f, 1.0f }, { -1.0f, 0.5f, 1.0f, 1.0f } };
+	gentle::Vec4<float> transformedCorners[3];
+	for (int i = 0; i < 3; i += 1)
+	{
+		gentle::MultiplyVectorWithMatrix(corners[i], transformedCorners[i], transform);
+	}
+	gentle::Vec4<float> faceNormal = gentle::CrossProduct(gentle::SubtractVectors(corners[1], corners[0]), gentle::SubtractVectors(corners[2], corners[0]));
+	gentle::Vec4<float> expectedNormal = gentle::CrossProduct(gentle::SubtractVectors(transformedCorners[1], transformedCorners[0]), gentle::SubtractVectors(transformedCorners[2], transformedCorners[0]));
+	faceNormal.w = 0.0f;
+	gentle::Vec4<float> transformedNormal;
+	gentle::MultiplyVectorWithMatrix(faceNormal, transformedNormal, gentle::MakeNormalMatrix(transform));
+	assert(fabsf(transformedNormal.x - expectedNormal.x) < 0.001f);
+	assert(fabsf(transformedNormal.y - expectedNormal.y) < 0.001f);
+	assert(fabsf(transformedNormal.z - expectedNormal.z) < 0.001f);
+
+	// ComputeBounds puts a box around every vertex & a sphere around the box
+	gentle::Mesh<float> mesh;
+	mesh.triangles = {
+		{ 0.0f, 0.0f, 0.0f, 1.0f,	2.0f, 0.0f, 0.0f, 1.0f,		0.0f, 4.0f, 0.0f, 1.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f,	0.0f, 4.0f, 0.0f, 1.0f,		0.0f, 2.0f, -2.0f, 2.0f }
+	};
+	assert(!mesh.bounds.isValid);
+	gentle::ComputeBounds(mesh);
+	assert(mesh.bounds.isValid);
+	assert(mesh.bounds.box.min.x == 0.0f && mesh.bounds.box.min.y == 0.0f && mesh.bounds.box.min.z == -1.0f);
+	assert(mesh.bounds.box.max.x == 2.0f && mesh.bounds.box.max.y == 4.0f && mesh.bounds.box.max.z == 0.0f);
+	assert(mesh.bounds.sphere.centre.x == 1.0f && mesh.bounds.sphere.centre.y == 2.0f && mesh.bounds.sphere.centre.z == -0.5f);
+	assert(fabsf(mesh.bounds.sphere.radius - sqrtf(5.25f)) < 0.0001f);
+
+	gentle::IndexedMesh<float> indexedMesh = gentle::MakeIndexedMesh(mesh);
+	assert(indexedMesh.bounds.isValid);
+	assert(indexedMesh.bounds.sphere.radius == mesh.bounds.sphere.radius);
+
+	// Meshes read from OBJ files come with bounds too
+	const char* objFilename = "bounds_test.obj";
+	FILE* objFile = fopen(objFilename, "w");
+	assert(objFile);
+	fputs("v 0 0 0\nv 2 0 0\nv 0 4 -1\nf 1 2 3\n", objFile);
+	fclose(objFile);
+	gentle::Mesh<float> objMesh;
+	assert(gentle::ReadObjFileToVec4(objFilename, objMesh));
+	remove(objFilename);
+	assert(objMesh.triangles.size() == 1);
+	assert(objMesh.bounds.isValid);
+	assert(objMesh.bounds.box.min.z == -1.0f && objMesh.bounds.box.max.x == 2.0f && objMesh.bounds.box.max.y == 4.0f);
+
+	// Vertex normals aren't vertices, & faces that aren't three vertices of the file fail the read rather than indexing past them
+	const char* objFiles[5] = {
+		"v 0 0 0\nvn 0 0 1\nv 2 0 0\nvt 0 1\nv 0 4 -1\nf 1 2 3\n",
+		"v 0 0 0\nv 2 0 0\nv 0 4 -1\nf 1/1/1 2/2/2 3/3/3\n",
+		"v 0 0 0\nv 2 0 0\nv 0 4 -1\nf 1 2 4\n",
+		"v 0 0 0\nv 2 0 0\nv 0 4 -1\nf 0 1 2\n",
+		"v 0 0 0\nv 2 0 0\nf 1 2 3\nv 0 4 -1\n"
+	};
+	for (int i = 0; i < 5; i += 1)
+	{
+		objFile = fopen(objFilename, "w");
+		assert(objFile);
+		fputs(objFiles[i], objFile);
+		fclose(objFile);
+		gentle::Mesh<float> triangleMesh;
+		gentle::IndexedMesh<float> objIndexedMesh;
+		bool isTriangleMeshRead = gentle::ReadObjFileToVec4(objFilename, triangleMesh);
+		bool isIndexedMeshRead = gentle::ReadObjFileToIndexedMesh(objFilename, objIndexedMesh);
+		remove(objFilename);
+		assert(isTriangleMeshRead == (i == 0));
+		assert(isIndexedMeshRead == (i == 0));
+		if (i == 0)
+		{
+			assert(triangleMesh.triangles.size() == 1);
+			assert(triangleMesh.triangles[0].p[1].x == 2.0f && triangleMesh.triangles[0].p[2].z == -1.0f);
+			assert(objIndexedMesh.vertices.x.size() == 3);
+			assert(objIndexedMesh.indices[0] == 0 && objIndexedMesh.indices[1] == 1 && objIndexedMesh.indices[2] == 2);
+		}
+	}
+
+	// Plane tests. Only volumes entirely outside a plane count as outside it
+	gentle::Vec4<float> keepXMoreThanThree = { 1.0f, 0.0f, 0.0f, -3.0f };
+	gentle::Vec4<float> keepXMoreThanOne = { 2.0f, 0.0f, 0.0f, -2.0f };
+	assert(gentle::IsBoxOutsidePlane(mesh.bounds.box, keepXMoreThanThree));
+	assert(!gentle::IsBoxOutsidePlane(mesh.bounds.box, keepXMoreThanOne));
+	gentle::Sphere<float> sphere = { { 0.0f, 0.0f, 0.0f }, 1.0f };
+	assert(!gentle::IsSphereOutsidePlane(sphere, keepXMoreThanOne));
+	sphere.centre.x = 0.1f;
+	assert(!gentle::IsSphereOutsidePlane(sphere, keepXMoreThanOne));
+	sphere.centre.x = -0.1f;
+	assert(gentle::IsSphereOutsidePlane(sphere, keepXMoreThanOne));
+
+	// Translating by 5 along x moves the plane x >= 0 back to x >= -5
+	gentle::Vec4<float> keepXPositive = { 1.0f, 0.0f, 0.0f, 0.0f };
+	gentle::Vec4<float> movedPlane = gentle::MakePlaneBeforeTransform(keepXPositive, gentle::MakeTranslationMatrix(5.0f, 0.0f, 0.0f));
+	assert(movedPlane.x == 1.0f && movedPlane.y == 0.0f && movedPlane.z == 0.0f && movedPlane.w == 5.0f);
+
+	// BuildClusters on a flat 4 x 4 grid of quads. Every cluster only uses its own vertices & has all its normals in line
+	gentle::Mesh<float> grid;
+	for (int y = 0; y < 4; y += 1)
+	{
+		for (int x = 0; x < 4; x += 1)
+		{
+			gentle::Vec4<float> p00 = { (float)x, (float)y, 0.0f, 1.0f };
+			gentle::Vec4<float> p10 = { (float)(x + 1), (float)y, 0.0f, 1.0f };
+			gentle::Vec4<float> p01 = { (float)x, (float)(y + 1), 0.0f, 1.0f };
+			gentle::Vec4<float> p11 = { (float)(x + 1), (float)(y + 1), 0.0f, 1.0f };
+			grid.triangles.push_back({ { p00, p10, p11 } });
+			grid.triangles.push_back({ { p00, p11, p01 } });
+		}
+	}
+	gentle::IndexedMesh<float> clusteredGrid = gentle::MakeIndexedMesh(grid);
+	gentle::BuildClusters(clusteredGrid, 8);
+	assert(clusteredGrid.clusters.size() >= 4);
+	assert(clusteredGrid.indices.size() == 32 * 3);
+	assert(clusteredGrid.faceNormals.x.size() == 32);
+	uint32_t nextTriangle = 0;
+	uint32_t nextVertex = 0;
+	for (const gentle::Cluster<float> &cluster : clusteredGrid.clusters)
+	{
+		assert(cluster.firstTriangle == nextTriangle && cluster.firstVertex == nextVertex);
+		assert(cluster.triangleCount > 0 && cluster.triangleCount <= 8);
+		for (uint32_t i = cluster.firstTriangle * 3; i < (cluster.firstTriangle + cluster.triangleCount) * 3; i += 1)
+		{
+			assert(clusteredGrid.indices[i] >= cluster.firstVertex && clusteredGrid.indices[i] < cluster.firstVertex + cluster.vertexCount);
+		}
+		assert(cluster.coneAxis.z == 1.0f && cluster.coneCutoff == 0.0f);
+		assert(cluster.sphere.radius > 0.0f && cluster.sphere.radius < 2.0f);
+		nextTriangle += cluster.triangleCount;
+		nextVertex += cluster.vertexCount;
+	}
+	assert(nextTriangle == 32);
+	assert(nextVertex == clusteredGrid.vertices.x.size());
 }
\ No newline at end of file
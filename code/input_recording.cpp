@@ -0,0 +1,114 @@
+#include <fstream>
+#include <stdint.h>
+#include <string.h>
+#include "input_recording.hpp"
+
+namespace gentle
+{
+	static_assert(BUTTON_COUNT <= 64, "Recorded buttons are packed into 64 bit masks");
+
+	static const char INPUT_RECORDING_MAGIC[4] = { 'G', 'G', 'I', 'R' };
+	static const uint32_t INPUT_RECORDING_VERSION = 1;
+
+	struct InputRecordingHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t buttonCount;
+		uint32_t frameCount;
+	};
+
+	struct InputRecordingEntry
+	{
+		float dt;
+		int32_t mouseX;
+		int32_t mouseY;
+		uint32_t padding;
+		uint64_t isDown;
+		uint64_t wasDown;
+		uint64_t keyUp;
+	};
+
+	void RecordFrame(InputRecording &recording, const Input &input, float dt)
+	{
+		recording.frames.push_back({ input, dt });
+	}
+
+	bool WriteInputRecording(std::string const &filename, const InputRecording &recording)
+	{
+		std::ofstream recordingFile(filename, std::ios::binary);
+		if (!recordingFile.is_open())
+		{
+			return false;
+		}
+
+		InputRecordingHeader header;
+		memcpy(header.magic, INPUT_RECORDING_MAGIC, sizeof(header.magic));
+		header.version = INPUT_RECORDING_VERSION;
+		header.buttonCount = BUTTON_COUNT;
+		header.frameCount = (uint32_t)recording.frames.size();
+		recordingFile.write((const char*)&header, sizeof(header));
+
+		for (const RecordedFrame &frame : recording.frames)
+		{
+			InputRecordingEntry entry = {};
+			entry.dt = frame.dt;
+			entry.mouseX = frame.input.mouse.x;
+			entry.mouseY = frame.input.mouse.y;
+			for (int i = 0; i < BUTTON_COUNT; i += 1)
+			{
+				const Button &button = frame.input.buttons[i];
+				entry.isDown |= (uint64_t)button.isDown << i;
+				entry.wasDown |= (uint64_t)button.wasDown << i;
+				entry.keyUp |= (uint64_t)button.keyUp << i;
+			}
+			recordingFile.write((const char*)&entry, sizeof(entry));
+		}
+
+		recordingFile.close();
+		return !recordingFile.fail();
+	}
+
+	bool ReadInputRecording(std::string const &filename, InputRecording &recording)
+	{
+		recording.frames.clear();
+
+		std::ifstream recordingFile(filename, std::ios::binary);
+		if (!recordingFile.is_open())
+		{
+			return false;
+		}
+
+		InputRecordingHeader header;
+		if (!recordingFile.read((char*)&header, sizeof(header)) ||
+			(memcmp(header.magic, INPUT_RECORDING_MAGIC, sizeof(header.magic)) != 0) ||
+			(header.version != INPUT_RECORDING_VERSION) ||
+			(header.buttonCount != BUTTON_COUNT))
+		{
+			return false;
+		}
+
+		for (uint32_t frame = 0; frame < header.frameCount; frame += 1)
+		{
+			InputRecordingEntry entry;
+			if (!recordingFile.read((char*)&entry, sizeof(entry)))
+			{
+				recording.frames.clear();
+				return false;
+			}
+
+			RecordedFrame recordedFrame = {};
+			recordedFrame.dt = entry.dt;
+			recordedFrame.input.mouse = { entry.mouseX, entry.mouseY };
+			for (int i = 0; i < BUTTON_COUNT; i += 1)
+			{
+				Button &button = recordedFrame.input.buttons[i];
+				button.isDown = ((entry.isDown >> i) & 1) != 0;
+				button.wasDown = ((entry.wasDown >> i) & 1) != 0;
+				button.keyUp = ((entry.keyUp >> i) & 1) != 0;
+			}
+			recording.frames.push_back(recordedFrame);
+		}
+		return true;
+	}
+}
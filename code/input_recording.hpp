@@ -0,0 +1,37 @@
+#ifndef GENTLE_INPUT_RECORDING_H
+#define GENTLE_INPUT_RECORDING_H
+
+#include <string>
+#include <vector>
+#include "platform.hpp"
+
+namespace gentle
+{
+	struct RecordedFrame
+	{
+		Input input;
+		float dt;
+	};
+
+	/**
+	 * Everything a frame of Update depends on from outside the game, so a recorded session can be replayed frame for
+	 * frame. Kept in memory while recording & replaying, so file access never lands in the middle of a profiled frame.
+	 */
+	struct InputRecording
+	{
+		std::vector<RecordedFrame> frames;
+	};
+
+	void RecordFrame(InputRecording &recording, const Input &input, float dt);
+
+	/**
+	 * Binary log of a header followed by a fixed size entry per frame: dt, the mouse position & a bit per button for each of
+	 * isDown, wasDown & keyUp. Written in the machine's own byte order.
+	 */
+	bool WriteInputRecording(std::string const &filename, const InputRecording &recording);
+
+	// Fails on a missing or truncated file, or one recorded with a different set of buttons
+	bool ReadInputRecording(std::string const &filename, InputRecording &recording);
+}
+
+#endif
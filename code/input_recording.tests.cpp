@@ -0,0 +1,72 @@
+#include "input_recording.hpp"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static bool AreRecordedFramesEqual(const gentle::RecordedFrame &a, const gentle::RecordedFrame &b)
+{
+	if ((a.dt != b.dt) || (a.input.mouse.x != b.input.mouse.x) || (a.input.mouse.y != b.input.mouse.y))
+	{
+		return false;
+	}
+	for (int i = 0; i < BUTTON_COUNT; i += 1)
+	{
+		const Button &buttonA = a.input.buttons[i];
+		const Button &buttonB = b.input.buttons[i];
+		if ((buttonA.isDown != buttonB.isDown) || (buttonA.wasDown != buttonB.wasDown) || (buttonA.keyUp != buttonB.keyUp))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void RunInputRecordingTests()
+{
+	const char* filename = "input_recording_test.bin";
+
+	// A session round trips through the log exactly, including the first & last buttons
+	gentle::InputRecording recording;
+	for (int frame = 0; frame < 100; frame += 1)
+	{
+		Input input = {};
+		input.mouse = { frame * 3, -frame };
+		input.buttons[frame % BUTTON_COUNT].isDown = true;
+		input.buttons[(frame + 7) % BUTTON_COUNT].wasDown = true;
+		input.buttons[(frame + 7) % BUTTON_COUNT].keyUp = ((frame % 2) == 0);
+		input.buttons[BUTTON_COUNT - 1].isDown = ((frame % 3) == 0);
+		gentle::RecordFrame(recording, input, 0.016f + (0.0001f * frame));
+	}
+	assert(gentle::WriteInputRecording(filename, recording));
+
+	gentle::InputRecording replay;
+	replay.frames.resize(3);
+	assert(gentle::ReadInputRecording(filename, replay));
+	assert(replay.frames.size() == recording.frames.size());
+	for (size_t i = 0; i < recording.frames.size(); i += 1)
+	{
+		assert(AreRecordedFramesEqual(recording.frames[i], replay.frames[i]));
+	}
+
+	// A log cut short doesn't replay part of a session
+	FILE* file = fopen(filename, "rb");
+	char bytes[8192];
+	size_t byteCount = fread(bytes, 1, sizeof(bytes), file);
+	fclose(file);
+	file = fopen(filename, "wb");
+	fwrite(bytes, 1, byteCount - 1, file);
+	fclose(file);
+	assert(!gentle::ReadInputRecording(filename, replay));
+	assert(replay.frames.empty());
+
+	// Nor does a file that isn't a recording at all
+	file = fopen(filename, "wb");
+	fputs("v 1.0 2.0 3.0\n", file);
+	fclose(file);
+	replay.frames.resize(3);
+	assert(!gentle::ReadInputRecording(filename, replay));
+	assert(replay.frames.empty());
+
+	remove(filename);
+	assert(!gentle::ReadInputRecording(filename, replay));
+}
@@ -1,4 +1,5 @@
 #include "math.hpp"
+#include "simd.hpp"
 #include <math.h>
 
 namespace gentle
@@ -120,4 +121,96 @@ namespace gentle
 	template int DotProduct(const Vec3<int> &v1, const Vec3<int> &v2);
 	template float DotProduct(const Vec3<float> &v1, const Vec3<float> &v2);
 	template double DotProduct(const Vec3<double> &v1, const Vec3<double> &v2);
+
+	void TransformVertexStream(const VertexStream<float> &input, const Matrix4x4<float> &matrix, VertexStream<float> &output)
+	{
+		TransformVertexStream(input, 0, input.x.size(), matrix, output);
+	}
+
+	void TransformVertexStream(const VertexStream<float> &input, size_t first, size_t count, const Matrix4x4<float> &matrix, VertexStream<float> &output)
+	{
+		size_t size = input.x.size();
+		bool hasW = !input.w.empty();
+		output.x.resize(size);
+		output.y.resize(size);
+		output.z.resize(size);
+		output.w.resize(size);
+		size_t end = first + count;
+
+		const float* inX = input.x.data();
+		const float* inY = input.y.data();
+		const float* inZ = input.z.data();
+		const float* inW = hasW ? input.w.data() : nullptr;
+		float* outX = output.x.data();
+		float* outY = output.y.data();
+		float* outZ = output.z.data();
+		float* outW = output.w.data();
+
+		size_t i = first;
+#if defined(GENTLE_AVX2)
+		// Each output component is a column of the matrix dotted with the input, so broadcast each matrix entry once up front
+		__m256 m[4][4];
+		for (int row = 0; row < 4; row += 1)
+		{
+			for (int col = 0; col < 4; col += 1)
+			{
+				m[row][col] = _mm256_set1_ps(matrix.m[row][col]);
+			}
+		}
+		const __m256 one = _mm256_set1_ps(1.0f);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(inX + i);
+			__m256 y = _mm256_loadu_ps(inY + i);
+			__m256 z = _mm256_loadu_ps(inZ + i);
+			__m256 w = hasW ? _mm256_loadu_ps(inW + i) : one;
+			__m256 results[4];
+			for (int col = 0; col < 4; col += 1)
+			{
+				results[col] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m[0][col]), _mm256_mul_ps(y, m[1][col])), _mm256_mul_ps(z, m[2][col])), _mm256_mul_ps(w, m[3][col]));
+			}
+			_mm256_storeu_ps(outX + i, results[0]);
+			_mm256_storeu_ps(outY + i, results[1]);
+			_mm256_storeu_ps(outZ + i, results[2]);
+			_mm256_storeu_ps(outW + i, results[3]);
+		}
+#elif defined(GENTLE_SSE2)
+		// Each output component is a column of the matrix dotted with the input, so broadcast each matrix entry once up front
+		__m128 m[4][4];
+		for (int row = 0; row < 4; row += 1)
+		{
+			for (int col = 0; col < 4; col += 1)
+			{
+				m[row][col] = _mm_set1_ps(matrix.m[row][col]);
+			}
+		}
+		const __m128 one = _mm_set1_ps(1.0f);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(inX + i);
+			__m128 y = _mm_loadu_ps(inY + i);
+			__m128 z = _mm_loadu_ps(inZ + i);
+			__m128 w = hasW ? _mm_loadu_ps(inW + i) : one;
+			__m128 results[4];
+			for (int col = 0; col < 4; col += 1)
+			{
+				results[col] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][col]), _mm_mul_ps(y, m[1][col])), _mm_mul_ps(z, m[2][col])), _mm_mul_ps(w, m[3][col]));
+			}
+			_mm_storeu_ps(outX + i, results[0]);
+			_mm_storeu_ps(outY + i, results[1]);
+			_mm_storeu_ps(outZ + i, results[2]);
+			_mm_storeu_ps(outW + i, results[3]);
+		}
+#endif
+		for (; i < end; i += 1)
+		{
+			Vec4<float> in = { inX[i], inY[i], inZ[i], hasW ? inW[i] : 1.0f };
+			Vec4<float> out;
+			MultiplyVectorWithMatrix(in, out, matrix);
+			outX[i] = out.x;
+			outY[i] = out.y;
+			outZ[i] = out.z;
+			outW[i] = out.w;
+		}
+	}
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef GENTLE_MATH_H
 #define GENTLE_MATH_H
 
+#include <math.h>
+#include <vector>
+
 namespace gentle
 {
 	template<typename T>
@@ -151,6 +154,28 @@ namespace gentle
 		}
 		return matrix;
 	}
+
+	/**
+	 * Vertex positions stored as a structure of arrays, so a batch of consecutive vertices can be loaded straight into SIMD
+	 * registers. x, y & z are always the same size. w is either the same size or empty, in which case every w is 1.
+	 */
+	template<typename T>
+	struct VertexStream
+	{
+		std::vector<T> x;
+		std::vector<T> y;
+		std::vector<T> z;
+		std::vector<T> w;
+	};
+
+	/**
+	 * Multiply every vertex of input with matrix, giving the same results as MultiplyVectorWithMatrix. output is resized to
+	 * match input and always gets w filled in. Uses AVX or SSE when available to transform 8 or 4 vertices at a time.
+	 */
+	void TransformVertexStream(const VertexStream<float> &input, const Matrix4x4<float> &matrix, VertexStream<float> &output);
+
+	// Only transform vertices first to first + count - 1. output is still resized to match input, the rest of it is left alone
+	void TransformVertexStream(const VertexStream<float> &input, size_t first, size_t count, const Matrix4x4<float> &matrix, VertexStream<float> &output);
 }
 
 #endif
\ No newline at end of file
@@ -6,4 +6,56 @@ void run_Vec4_tests()
 	// dot_product
 	float dot = gentle::DotProduct(gentle::Vec4<float>{ 1.0f, 2.0f, 3.0f }, gentle::Vec4<float>{ 4.0f, 5.0f, 6.0f });
 	assert(dot == (float)32);
+
+	// TransformVertexStream matches MultiplyVectorWithMatrix, with & without w, for counts that don't fill a whole SIMD batch
+	gentle::Matrix4x4<float> matrix;
+	for (int row = 0; row < 4; row += 1)
+	{
+		for (int col = 0; col < 4; col += 1)
+		{
+			matrix.m[row][col] = (float)((row * 4) + col) * 0.25f - 1.5f;
+		}
+	}
+	for (int count = 0; count < 20; count += 1)
+	{
+		for (int hasW = 0; hasW < 2; hasW += 1)
+		{
+			gentle::VertexStream<float> input;
+			for (int i = 0; i < count; i += 1)
+			{
+				input.x.push_back((float)i * 1.5f);
+				input.y.push_back((float)i * -0.75f + 2.0f);
+				input.z.push_back((float)(i % 3) + 0.125f);
+				if (hasW)
+				{
+					input.w.push_back((float)(i % 4) * 0.5f);
+				}
+			}
+
+			gentle::VertexStream<float> output;
+			gentle::TransformVertexStream(input, matrix, output);
+			assert((int)output.x.size() == count && (int)output.y.size() == count && (int)output.z.size() == count && (int)output.w.size() == count);
+			for (int i = 0; i < count; i += 1)
+			{
+				gentle::Vec4<float> in = { input.x[i], input.y[i], input.z[i], hasW ? input.w[i] : 1.0f };
+				gentle::Vec4<float> expected;
+				gentle::MultiplyVectorWithMatrix(in, expected, matrix);
+				assert(output.x[i] == expected.x && output.y[i] == expected.y && output.z[i] == expected.z && output.w[i] == expected.w);
+			}
+
+			// Transforming a range leaves the vertices either side of it alone
+			if (count >= 2)
+			{
+				gentle::VertexStream<float> rangeOutput;
+				rangeOutput.x.assign(count, -7.0f);
+				gentle::TransformVertexStream(input, 1, count - 2, matrix, rangeOutput);
+				assert((int)rangeOutput.w.size() == count);
+				assert(rangeOutput.x[0] == -7.0f && rangeOutput.x[count - 1] == -7.0f);
+				for (int i = 1; i < count - 1; i += 1)
+				{
+					assert(rangeOutput.x[i] == output.x[i] && rangeOutput.y[i] == output.y[i] && rangeOutput.z[i] == output.z[i] && rangeOutput.w[i] == output.w[i]);
+				}
+			}
+		}
+	}
 }
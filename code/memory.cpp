@@ -0,0 +1,256 @@
+#include "memory.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+
+namespace gentle
+{
+	MemoryArena MakeMemoryArena(void* base, size_t size)
+	{
+		MemoryArena arena;
+		arena.base = (uint8_t*)base;
+		arena.size = size;
+		arena.used = 0;
+		arena.peakUsed = 0;
+		return arena;
+	}
+
+	void* PushSize(MemoryArena &arena, size_t size, size_t alignment)
+	{
+		uintptr_t top = (uintptr_t)(arena.base + arena.used);
+		size_t padding = (size_t)((alignment - (top & (alignment - 1))) & (alignment - 1));
+		if (padding + size > arena.size - arena.used)
+		{
+			return nullptr;
+		}
+
+		void* memory = arena.base + arena.used + padding;
+		arena.used += padding + size;
+		arena.peakUsed = std::max(arena.peakUsed, arena.used);
+		return memory;
+	}
+
+	void PopSize(MemoryArena &arena, void* memory, size_t size)
+	{
+		if ((uint8_t*)memory + size == arena.base + arena.used)
+		{
+			arena.used = (size_t)((uint8_t*)memory - arena.base);
+		}
+	}
+
+	bool IsInMemoryArena(const MemoryArena &arena, const void* memory)
+	{
+		return (memory >= arena.base) && (memory < arena.base + arena.size);
+	}
+
+	void ResetMemoryArena(MemoryArena &arena)
+	{
+		arena.used = 0;
+	}
+
+	ArenaMark GetArenaMark(const MemoryArena &arena)
+	{
+		return ArenaMark { arena.used };
+	}
+
+	void ResetToArenaMark(MemoryArena &arena, const ArenaMark &mark)
+	{
+		arena.used = mark.used;
+	}
+
+	ScopedArenaMark::ScopedArenaMark(MemoryArena* arenaToMark) : arena(arenaToMark), mark(ArenaMark { 0 })
+	{
+		if (arena)
+		{
+			mark = GetArenaMark(*arena);
+		}
+	}
+
+	ScopedArenaMark::~ScopedArenaMark()
+	{
+		if (arena)
+		{
+			ResetToArenaMark(*arena, mark);
+		}
+	}
+
+#if defined(GENTLE_TRACK_ALLOCATIONS)
+	// Each tracked allocation starts with a header recording what it was for. It takes up ALLOCATION_HEADER_SIZE bytes however
+	// big the struct is, so the memory after it stays 16 byte aligned without alignas padding the struct
+	struct AllocationHeader
+	{
+		size_t size;
+		AllocationTag tag;
+	};
+
+	static const size_t ALLOCATION_HEADER_SIZE = 16;
+	static_assert(sizeof(AllocationHeader) <= ALLOCATION_HEADER_SIZE, "The allocation header must fit before the memory it tracks");
+
+	static std::atomic<int> frameAllocationCounts[ALLOCATION_TAG_COUNT];
+	static std::atomic<size_t> frameBytesAllocated[ALLOCATION_TAG_COUNT];
+	static std::atomic<size_t> bytesInUse(0);
+	static std::atomic<size_t> peakBytesInUse(0);
+	static thread_local bool isHeapAllocationForbidden = false;
+	static thread_local AllocationTag currentAllocationTag = ALLOCATION_TAG_OTHER;
+
+	static void* TrackedAllocate(size_t size)
+	{
+		// Forbidding allocations is opted into explicitly, so trap in release builds too rather than only through assert
+		if (isHeapAllocationForbidden)
+		{
+			fputs("Heap allocation while allocations are forbidden\n", stderr);
+			abort();
+		}
+
+		AllocationHeader* header = (AllocationHeader*)malloc(ALLOCATION_HEADER_SIZE + size);
+		if (!header)
+		{
+			throw std::bad_alloc();
+		}
+		header->size = size;
+		header->tag = currentAllocationTag;
+
+		frameAllocationCounts[header->tag] += 1;
+		frameBytesAllocated[header->tag] += size;
+		size_t inUse = (bytesInUse += size);
+		size_t peak = peakBytesInUse;
+		while (inUse > peak && !peakBytesInUse.compare_exchange_weak(peak, inUse))
+		{
+		}
+		return (uint8_t*)header + ALLOCATION_HEADER_SIZE;
+	}
+
+	static void TrackedFree(void* memory)
+	{
+		if (memory)
+		{
+			AllocationHeader* header = (AllocationHeader*)((uint8_t*)memory - ALLOCATION_HEADER_SIZE);
+			bytesInUse -= header->size;
+			free(header);
+		}
+	}
+
+	bool IsTrackingAllocations()
+	{
+		return true;
+	}
+
+	void BeginAllocationFrame()
+	{
+		for (int tag = 0; tag < ALLOCATION_TAG_COUNT; tag += 1)
+		{
+			frameAllocationCounts[tag] = 0;
+			frameBytesAllocated[tag] = 0;
+		}
+		peakBytesInUse = bytesInUse.load();
+	}
+
+	AllocationStats GetFrameAllocationStats()
+	{
+		AllocationStats stats;
+		for (int tag = 0; tag < ALLOCATION_TAG_COUNT; tag += 1)
+		{
+			stats.allocationCount[tag] = frameAllocationCounts[tag];
+			stats.bytesAllocated[tag] = frameBytesAllocated[tag];
+		}
+		stats.bytesInUse = bytesInUse;
+		stats.peakBytesInUse = peakBytesInUse;
+		return stats;
+	}
+
+	void SetHeapAllocationForbidden(bool isForbidden)
+	{
+		isHeapAllocationForbidden = isForbidden;
+	}
+
+	bool IsHeapAllocationForbidden()
+	{
+		return isHeapAllocationForbidden;
+	}
+
+	AllocationTagScope::AllocationTagScope(AllocationTag tag) : previousTag(currentAllocationTag)
+	{
+		currentAllocationTag = tag;
+	}
+
+	AllocationTagScope::~AllocationTagScope()
+	{
+		currentAllocationTag = previousTag;
+	}
+#else
+	bool IsTrackingAllocations()
+	{
+		return false;
+	}
+
+	void BeginAllocationFrame()
+	{
+	}
+
+	AllocationStats GetFrameAllocationStats()
+	{
+		AllocationStats stats = {};
+		return stats;
+	}
+
+	void SetHeapAllocationForbidden(bool)
+	{
+	}
+
+	bool IsHeapAllocationForbidden()
+	{
+		return false;
+	}
+
+	AllocationTagScope::AllocationTagScope(AllocationTag) : previousTag(ALLOCATION_TAG_OTHER)
+	{
+	}
+
+	AllocationTagScope::~AllocationTagScope()
+	{
+	}
+#endif
+
+	int GetTotalAllocationCount(const AllocationStats &stats)
+	{
+		int count = 0;
+		for (int tag = 0; tag < ALLOCATION_TAG_COUNT; tag += 1)
+		{
+			count += stats.allocationCount[tag];
+		}
+		return count;
+	}
+}
+
+#if defined(GENTLE_TRACK_ALLOCATIONS)
+void* operator new(size_t size)
+{
+	return gentle::TrackedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return gentle::TrackedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	gentle::TrackedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	gentle::TrackedFree(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	gentle::TrackedFree(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	gentle::TrackedFree(memory);
+}
+#endif
@@ -0,0 +1,176 @@
+#ifndef GENTLE_MEMORY_H
+#define GENTLE_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+namespace gentle
+{
+	/**
+	 * Linear allocator over a block of memory it doesn't own, such as GameMemory.TransientStorage. Pushing just bumps an offset,
+	 * & everything pushed gets freed at once by resetting the arena, e.g. at the start of each frame, or by going back to a mark.
+	 */
+	struct MemoryArena
+	{
+		uint8_t* base;
+		size_t size;
+		size_t used;
+		size_t peakUsed;	// Most the arena has ever had in use, for sizing the block it sits on
+	};
+
+	MemoryArena MakeMemoryArena(void* base, size_t size);
+
+	// Returns nullptr when the arena doesn't have size bytes left. alignment must be a power of 2. The default suits any SIMD load
+	void* PushSize(MemoryArena &arena, size_t size, size_t alignment = 16);
+
+	template<typename T>
+	T* PushArray(MemoryArena &arena, size_t count)
+	{
+		return (T*)PushSize(arena, count * sizeof(T), alignof(T));
+	}
+
+	// Give back the size bytes at memory, but only when they were the last thing pushed. Anything else waits for a reset
+	void PopSize(MemoryArena &arena, void* memory, size_t size);
+
+	bool IsInMemoryArena(const MemoryArena &arena, const void* memory);
+
+	// Free everything in the arena at once
+	void ResetMemoryArena(MemoryArena &arena);
+
+	struct ArenaMark
+	{
+		size_t used;
+	};
+
+	ArenaMark GetArenaMark(const MemoryArena &arena);
+
+	// Free everything pushed since mark was taken
+	void ResetToArenaMark(MemoryArena &arena, const ArenaMark &mark);
+
+	/**
+	 * Frees everything pushed onto the arena during its lifetime when it goes out of scope. Does nothing without an arena,
+	 * so code with an optional arena can use it either way.
+	 */
+	struct ScopedArenaMark
+	{
+		MemoryArena* arena;
+		ArenaMark mark;
+
+		explicit ScopedArenaMark(MemoryArena* arenaToMark);
+		~ScopedArenaMark();
+		ScopedArenaMark(const ScopedArenaMark&) = delete;
+		ScopedArenaMark& operator=(const ScopedArenaMark&) = delete;
+	};
+
+	/**
+	 * Standard library allocator that pushes onto an arena, so containers such as std::vector can live in it. Falls back to the
+	 * heap when there's no arena or it's full, so running out costs speed rather than correctness. Freeing only gives memory
+	 * back to the arena when it was the last thing pushed, so a vector that grows leaves its old blocks behind until the arena
+	 * gets reset. Reserve up front where the size is known. Containers must be gone before the arena gets reset past them.
+	 */
+	template<typename T>
+	struct ArenaAllocator
+	{
+		typedef T value_type;
+
+		MemoryArena* arena;
+
+		ArenaAllocator(MemoryArena* allocatorArena) : arena(allocatorArena) {}
+
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+		T* allocate(size_t count)
+		{
+			void* memory = (arena) ? PushSize(*arena, count * sizeof(T), alignof(T)) : nullptr;
+			return (T*)((memory) ? memory : ::operator new(count * sizeof(T)));
+		}
+
+		void deallocate(T* memory, size_t count)
+		{
+			if (arena && IsInMemoryArena(*arena, memory))
+			{
+				PopSize(*arena, memory, count * sizeof(T));
+			}
+			else
+			{
+				::operator delete(memory);
+			}
+		}
+	};
+
+	template<typename T, typename U>
+	bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+	{
+		return a.arena == b.arena;
+	}
+
+	template<typename T, typename U>
+	bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+	{
+		return a.arena != b.arena;
+	}
+
+	/**
+	 * Allocation tracking
+	 *
+	 * Building the library with GENTLE_TRACK_ALLOCATIONS defined replaces the global operator new & delete with versions that
+	 * count every heap allocation, its size & the subsystem it was made for. Allocations get attributed to the tag of the
+	 * innermost AllocationTagScope on the calling thread. Without GENTLE_TRACK_ALLOCATIONS the functions below still exist but
+	 * report nothing, & the tag scopes the library puts around its own code compile away.
+	 */
+	enum AllocationTag
+	{
+		ALLOCATION_TAG_OTHER,
+		ALLOCATION_TAG_RENDER,
+		ALLOCATION_TAG_CLIP,
+		ALLOCATION_TAG_FILE,
+		ALLOCATION_TAG_COLLISION,
+
+		ALLOCATION_TAG_COUNT
+	};
+
+	struct AllocationStats
+	{
+		int allocationCount[ALLOCATION_TAG_COUNT];
+		size_t bytesAllocated[ALLOCATION_TAG_COUNT];
+		size_t bytesInUse;
+		size_t peakBytesInUse;
+	};
+
+	bool IsTrackingAllocations();
+
+	// Start counting a new frame. The peak starts again from whatever is in use now
+	void BeginAllocationFrame();
+
+	// Everything allocated since BeginAllocationFrame
+	AllocationStats GetFrameAllocationStats();
+
+	int GetTotalAllocationCount(const AllocationStats &stats);
+
+	// While forbidden, any heap allocation on the calling thread aborts, with or without NDEBUG, so a debugger stops right where it
+	// happened. Per thread, so a render thread can be checked while the game thread allocates freely between updates. The workers
+	// of a ThreadPool take it on from the thread that runs a job on them, for as long as they run it
+	void SetHeapAllocationForbidden(bool isForbidden);
+
+	bool IsHeapAllocationForbidden();
+
+	struct AllocationTagScope
+	{
+		AllocationTag previousTag;
+
+		explicit AllocationTagScope(AllocationTag tag);
+		~AllocationTagScope();
+		AllocationTagScope(const AllocationTagScope&) = delete;
+		AllocationTagScope& operator=(const AllocationTagScope&) = delete;
+	};
+
+#if defined(GENTLE_TRACK_ALLOCATIONS)
+#define GENTLE_ALLOCATION_TAG(tag) gentle::AllocationTagScope allocationTagScope(tag)
+#else
+#define GENTLE_ALLOCATION_TAG(tag)
+#endif
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "memory.hpp"
+#include <assert.h>
+#include <vector>
+
+void RunMemoryTests()
+{
+	alignas(16) uint8_t block[256];
+	gentle::MemoryArena arena = gentle::MakeMemoryArena(block, sizeof(block));
+
+	// Pushes get aligned, & a push that doesn't fit fails without using anything up
+	uint8_t* byte = gentle::PushArray<uint8_t>(arena, 1);
+	float* floats = gentle::PushArray<float>(arena, 4);
+	void* wide = gentle::PushSize(arena, 16);
+	assert(byte == block);
+	assert(((uintptr_t)floats % alignof(float)) == 0);
+	assert(((uintptr_t)wide % 16) == 0);
+	assert(arena.used == 48);
+	assert(gentle::PushSize(arena, 256) == nullptr);
+	assert(arena.used == 48);
+
+	// Only the last push can be popped
+	gentle::PopSize(arena, floats, 4 * sizeof(float));
+	assert(arena.used == 48);
+	gentle::PopSize(arena, wide, 16);
+	assert(arena.used == 32);
+
+	// Marks free everything pushed after them, scoped ones when they go out of scope
+	gentle::ArenaMark mark = gentle::GetArenaMark(arena);
+	gentle::PushSize(arena, 64);
+	gentle::ResetToArenaMark(arena, mark);
+	assert(arena.used == 32);
+	{
+		gentle::ScopedArenaMark scratch(&arena);
+		gentle::PushSize(arena, 100);
+		assert(arena.used == 132);
+	}
+	assert(arena.used == 32);
+	assert(arena.peakUsed == 132);
+	gentle::ResetMemoryArena(arena);
+	assert(arena.used == 0);
+	assert(arena.peakUsed == 132);
+
+	// A growing vector spills onto the heap once the arena is full
+	{
+		gentle::ScopedArenaMark scratch(&arena);
+		gentle::ArenaAllocator<int> allocator(&arena);
+		std::vector<int, gentle::ArenaAllocator<int>> numbers(allocator);
+		for (int i = 0; i < 16; i += 1)
+		{
+			numbers.push_back(i);
+		}
+		assert(gentle::IsInMemoryArena(arena, numbers.data()));
+
+		for (int i = 16; i < 1000; i += 1)
+		{
+			numbers.push_back(i);
+		}
+		assert(!gentle::IsInMemoryArena(arena, numbers.data()));
+		for (int i = 0; i < 1000; i += 1)
+		{
+			assert(numbers[i] == i);
+		}
+	}
+	assert(arena.used == 0);
+
+	// A vector that doesn't grow gives its memory straight back
+	{
+		gentle::ArenaAllocator<int> allocator(&arena);
+		std::vector<int, gentle::ArenaAllocator<int>> numbers(10, 3, allocator);
+		assert(arena.used == 10 * sizeof(int));
+	}
+	assert(arena.used == 0);
+
+	// Without an arena the allocator is just the heap
+	std::vector<int, gentle::ArenaAllocator<int>> heapNumbers(100, 7, gentle::ArenaAllocator<int>(nullptr));
+	assert(heapNumbers[99] == 7);
+
+	// Heap allocations get counted against the innermost tag, & only when the library tracks them
+	if (gentle::IsTrackingAllocations())
+	{
+		gentle::BeginAllocationFrame();
+		size_t bytesInUse = gentle::GetFrameAllocationStats().bytesInUse;
+		{
+			gentle::AllocationTagScope fileScope(gentle::ALLOCATION_TAG_FILE);
+			std::vector<int> numbers(100);
+			{
+				gentle::AllocationTagScope clipScope(gentle::ALLOCATION_TAG_CLIP);
+				std::vector<int> moreNumbers(10);
+			}
+			std::vector<int> evenMoreNumbers(5);
+		}
+		gentle::AllocationStats stats = gentle::GetFrameAllocationStats();
+		assert(stats.allocationCount[gentle::ALLOCATION_TAG_FILE] == 2);
+		assert(stats.bytesAllocated[gentle::ALLOCATION_TAG_FILE] == 105 * sizeof(int));
+		assert(stats.allocationCount[gentle::ALLOCATION_TAG_CLIP] == 1);
+		assert(stats.allocationCount[gentle::ALLOCATION_TAG_OTHER] == 0);
+		assert(gentle::GetTotalAllocationCount(stats) == 3);
+		assert(stats.bytesInUse == bytesInUse);
+		assert(stats.peakBytesInUse == bytesInUse + (110 * sizeof(int)));
+
+		gentle::BeginAllocationFrame();
+		assert(gentle::GetTotalAllocationCount(gentle::GetFrameAllocationStats()) == 0);
+	}
+	else
+	{
+		assert(gentle::GetTotalAllocationCount(gentle::GetFrameAllocationStats()) == 0);
+	}
+}
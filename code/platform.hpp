@@ -2,6 +2,7 @@
 #define PLATFORM_H
 
 #include "math.hpp"
+#include "dirty_region.hpp"
 
 enum KEY
 {
@@ -21,14 +22,32 @@ enum KEY
 	BUTTON_COUNT
 };
 
+const int RENDER_TILE_SIZE = 8;
+
+// State for a RENDER_TILE_SIZE x RENDER_TILE_SIZE block of the render buffer.
+// Coarse depth is used to reject hidden triangles before filling any pixels. minDepth only ever grows as pixels get drawn,
+// so it is allowed to fall behind the depth buffer and gets recalculated when it is stale.
+// A pending clear means the block hasn't been written since a deferred clear. Its pixels are logically clearColor & its depth 0.
+struct RenderTile
+{
+	float minDepth;
+	float maxDepth;
+	bool isMinDepthStale;
+	bool isClearPending;
+	unsigned int clearColor;
+};
+
 struct RenderBuffer
 {
-	unsigned int* pixels;
+	unsigned int* pixels;	// nullptr for a depth only buffer, which only ClearScreen & the triangle fills support
 	int width;
 	int height;
 	int pitch;
 	int bytesPerPixel; // = 4;
 	float* depth;
+	RenderTile* tiles = nullptr;	// Optional. One per RENDER_TILE_SIZE block of pixels, row by row. The last row & column may be partial.
+	const gentle::PixelRect* scissor = nullptr;	// Optional. Drawing & clearing only write the pixels inside it
+	gentle::DirtyRegion* dirtyRegion = nullptr;	// Optional. Drawing & clearing add the pixels they write to it, see present_queue.hpp
 };
 
 struct Button
@@ -51,6 +70,8 @@ struct GameMemory
 	unsigned long TransientStorageSpace;
 	void* PermanentStorage;
 	void* TransientStorage;
+	unsigned long SnapshotStorageSpace;	// Size of each snapshot
+	void* SnapshotStorage[2];	// What Update leaves for Render to draw, see snapshot_queue.hpp
 };
 
 #endif
\ No newline at end of file
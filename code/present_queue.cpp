@@ -0,0 +1,201 @@
+#include <assert.h>
+#include "present_queue.hpp"
+
+namespace gentle
+{
+	void InitializePresentQueue(PresentQueue &queue, RenderBuffer* buffers, int bufferCount, PresentMode mode)
+	{
+		assert((bufferCount >= 1) && (bufferCount <= MAX_PRESENT_BUFFERS));
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		for (int i = 0; i < MAX_PRESENT_BUFFERS; i += 1)
+		{
+			queue.buffers[i] = (i < bufferCount) ? &buffers[i] : nullptr;
+			queue.states[i] = PRESENT_BUFFER_FREE;
+			queue.submitOrder[i] = 0;
+			ResetDirtyRegion(queue.staleRegions[i]);
+		}
+		queue.bufferCount = bufferCount;
+		queue.mode = mode;
+		queue.isClosed = false;
+		queue.stats = {};
+	}
+
+	static int FindBuffer(const PresentQueue &queue, const RenderBuffer* buffer)
+	{
+		for (int i = 0; i < queue.bufferCount; i += 1)
+		{
+			if (queue.buffers[i] == buffer)
+			{
+				return i;
+			}
+		}
+		assert(!"Buffer doesn't belong to this present queue");
+		return 0;
+	}
+
+	// The queued buffer submitted first, or -1 when nothing is queued
+	static int FindOldestQueued(const PresentQueue &queue)
+	{
+		int oldest = -1;
+		for (int i = 0; i < queue.bufferCount; i += 1)
+		{
+			if ((queue.states[i] == PRESENT_BUFFER_QUEUED) && ((oldest < 0) || (queue.submitOrder[i] < queue.submitOrder[oldest])))
+			{
+				oldest = i;
+			}
+		}
+		return oldest;
+	}
+
+	static int FindFree(const PresentQueue &queue)
+	{
+		for (int i = 0; i < queue.bufferCount; i += 1)
+		{
+			if (queue.states[i] == PRESENT_BUFFER_FREE)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	RenderBuffer* BeginRenderFrame(PresentQueue &queue)
+	{
+		std::unique_lock<std::mutex> lock(queue.mutex);
+		int buffer = FindFree(queue);
+		if ((buffer < 0) && (queue.mode == PRESENT_MODE_MAILBOX))
+		{
+			buffer = FindOldestQueued(queue);
+			if (buffer >= 0)
+			{
+				queue.stats.framesDropped += 1;
+			}
+		}
+		if (buffer < 0)
+		{
+			queue.stats.renderWaits += 1;
+			queue.stateChanged.wait(lock, [&] { return FindFree(queue) >= 0; });
+			buffer = FindFree(queue);
+		}
+
+		queue.states[buffer] = PRESENT_BUFFER_RENDERING;
+		RenderBuffer* renderBuffer = queue.buffers[buffer];
+		if (renderBuffer->dirtyRegion)
+		{
+			// The buffer may have been resized since the other frames were drawn
+			PixelRect wholeBuffer = { 0, 0, renderBuffer->width, renderBuffer->height };
+			DirtyRegion &staleRegion = queue.staleRegions[buffer];
+			for (int i = 0; i < staleRegion.rectCount; i += 1)
+			{
+				AddDirtyRect(*renderBuffer->dirtyRegion, IntersectPixelRects(staleRegion.rects[i], wholeBuffer));
+			}
+			ResetDirtyRegion(staleRegion);
+		}
+		return renderBuffer;
+	}
+
+	void SubmitRenderFrame(PresentQueue &queue, RenderBuffer* buffer)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			int index = FindBuffer(queue, buffer);
+			assert(queue.states[index] == PRESENT_BUFFER_RENDERING);
+
+			// A newer frame makes any mailbox frame still waiting pointless to present
+			if (queue.mode == PRESENT_MODE_MAILBOX)
+			{
+				for (int i = 0; i < queue.bufferCount; i += 1)
+				{
+					if (queue.states[i] == PRESENT_BUFFER_QUEUED)
+					{
+						queue.states[i] = PRESENT_BUFFER_FREE;
+						queue.stats.framesDropped += 1;
+					}
+				}
+			}
+
+			// Every other buffer is now behind by what this frame drew
+			if (buffer->dirtyRegion)
+			{
+				for (int i = 0; i < queue.bufferCount; i += 1)
+				{
+					if (i == index)
+					{
+						continue;
+					}
+					for (int rect = 0; rect < buffer->dirtyRegion->rectCount; rect += 1)
+					{
+						AddDirtyRect(queue.staleRegions[i], buffer->dirtyRegion->rects[rect]);
+					}
+				}
+			}
+
+			queue.stats.framesSubmitted += 1;
+			queue.states[index] = PRESENT_BUFFER_QUEUED;
+			queue.submitOrder[index] = (uint64_t)queue.stats.framesSubmitted;
+		}
+		queue.stateChanged.notify_all();
+	}
+
+	RenderBuffer* BeginPresentFrame(PresentQueue &queue)
+	{
+		std::unique_lock<std::mutex> lock(queue.mutex);
+		queue.stateChanged.wait(lock, [&] { return (FindOldestQueued(queue) >= 0) || queue.isClosed; });
+
+		int buffer = FindOldestQueued(queue);
+		if (buffer < 0)
+		{
+			return nullptr;
+		}
+		queue.states[buffer] = PRESENT_BUFFER_PRESENTING;
+		return queue.buffers[buffer];
+	}
+
+	void EndPresentFrame(PresentQueue &queue, RenderBuffer* buffer)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			int index = FindBuffer(queue, buffer);
+			assert(queue.states[index] == PRESENT_BUFFER_PRESENTING);
+			if (buffer->dirtyRegion)
+			{
+				ResetDirtyRegion(*buffer->dirtyRegion);
+			}
+			queue.states[index] = PRESENT_BUFFER_FREE;
+			queue.stats.framesPresented += 1;
+		}
+		queue.stateChanged.notify_all();
+	}
+
+	void WaitForPresentQueueIdle(PresentQueue &queue)
+	{
+		std::unique_lock<std::mutex> lock(queue.mutex);
+		queue.stateChanged.wait(lock, [&]
+		{
+			for (int i = 0; i < queue.bufferCount; i += 1)
+			{
+				if ((queue.states[i] == PRESENT_BUFFER_QUEUED) || (queue.states[i] == PRESENT_BUFFER_PRESENTING))
+				{
+					return false;
+				}
+			}
+			return true;
+		});
+	}
+
+	void ClosePresentQueue(PresentQueue &queue)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.isClosed = true;
+		}
+		queue.stateChanged.notify_all();
+	}
+
+	PresentQueueStats GetPresentQueueStats(PresentQueue &queue)
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		return queue.stats;
+	}
+}
@@ -0,0 +1,86 @@
+#ifndef GENTLE_PRESENT_QUEUE_H
+#define GENTLE_PRESENT_QUEUE_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+#include "platform.hpp"
+#include "dirty_region.hpp"
+
+namespace gentle
+{
+	const int MAX_PRESENT_BUFFERS = 3;
+
+	enum PresentMode
+	{
+		PRESENT_MODE_FIFO,	// Every frame gets presented in order. The game waits for a free buffer when it gets too far ahead
+		PRESENT_MODE_MAILBOX,	// Only the newest frame gets presented. The game takes back a frame still waiting rather than wait
+	};
+
+	enum PresentBufferState
+	{
+		PRESENT_BUFFER_FREE,
+		PRESENT_BUFFER_RENDERING,
+		PRESENT_BUFFER_QUEUED,
+		PRESENT_BUFFER_PRESENTING,
+	};
+
+	struct PresentQueueStats
+	{
+		int framesSubmitted;
+		int framesPresented;
+		int framesDropped;	// Mailbox frames replaced by a newer one before they got presented
+		int renderWaits;	// Times the game had to wait for a buffer
+	};
+
+	/**
+	 * Hands render buffers between the game thread, which renders frame N + 1, & a presenting thread that shows or encodes
+	 * frame N at the same time. A buffer belongs to exactly one side at a time, between Begin & the matching End or Submit.
+	 * With one buffer it degrades to rendering & presenting in turn.
+	 *
+	 * Buffers with a dirtyRegion let the game redraw & the presenter show only what changed. Mark each region all dirty to
+	 * start with, & whenever its buffer gets reallocated, see MarkAllDirty. BeginRenderFrame adds what frames in the other
+	 * buffers drew since this one was last rendered to, so the buffer is up to date once the game redraws its dirty region.
+	 * What the game draws gets added too, & the region is reset once the frame's been presented. The region of each frame
+	 * presented then covers everything that changed since the one presented before it, even if frames got dropped in between.
+	 */
+	struct PresentQueue
+	{
+		RenderBuffer* buffers[MAX_PRESENT_BUFFERS];
+		PresentBufferState states[MAX_PRESENT_BUFFERS];
+		uint64_t submitOrder[MAX_PRESENT_BUFFERS];
+		DirtyRegion staleRegions[MAX_PRESENT_BUFFERS];	// Drawn in other buffers since each buffer was last rendered to
+		int bufferCount;
+		PresentMode mode;
+		bool isClosed;
+		PresentQueueStats stats;
+
+		std::mutex mutex;
+		std::condition_variable stateChanged;
+	};
+
+	void InitializePresentQueue(PresentQueue &queue, RenderBuffer* buffers, int bufferCount, PresentMode mode);
+
+	// Game thread. Blocks when every buffer is taken, until the presenting thread gives one back. The dirty region of the
+	// buffer, when it has one, is what needs redrawing for it to be up to date
+	RenderBuffer* BeginRenderFrame(PresentQueue &queue);
+
+	// Game thread. Queue a buffer from BeginRenderFrame for presenting
+	void SubmitRenderFrame(PresentQueue &queue, RenderBuffer* buffer);
+
+	// Presenting thread. Blocks until a frame is queued. Returns nullptr once the queue is closed & every frame presented
+	RenderBuffer* BeginPresentFrame(PresentQueue &queue);
+
+	// Presenting thread. Resets the dirty region of the buffer, when it has one
+	void EndPresentFrame(PresentQueue &queue, RenderBuffer* buffer);
+
+	// Wait until every submitted frame has been presented, e.g. before the buffers get resized
+	void WaitForPresentQueueIdle(PresentQueue &queue);
+
+	// Let the presenting thread finish the frames already queued & then stop
+	void ClosePresentQueue(PresentQueue &queue);
+
+	PresentQueueStats GetPresentQueueStats(PresentQueue &queue);
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "present_queue.hpp"
+#include <assert.h>
+#include <thread>
+#include <vector>
+
+static void RunFifoPresentQueueTest(int bufferCount)
+{
+	// Every frame gets presented once & in order, with the presenter seeing exactly what the game wrote
+	const int frameCount = 200;
+	uint32_t pixels[gentle::MAX_PRESENT_BUFFERS] = {};
+	RenderBuffer buffers[gentle::MAX_PRESENT_BUFFERS] = {};
+	for (int i = 0; i < bufferCount; i += 1)
+	{
+		buffers[i].pixels = &pixels[i];
+		buffers[i].width = 1;
+		buffers[i].height = 1;
+	}
+
+	gentle::PresentQueue queue;
+	gentle::InitializePresentQueue(queue, buffers, bufferCount, gentle::PRESENT_MODE_FIFO);
+
+	std::vector<uint32_t> presentedFrames;
+	std::thread presenter([&]
+	{
+		while (RenderBuffer* buffer = gentle::BeginPresentFrame(queue))
+		{
+			presentedFrames.push_back(buffer->pixels[0]);
+			gentle::EndPresentFrame(queue, buffer);
+		}
+	});
+
+	for (uint32_t frame = 0; frame < frameCount; frame += 1)
+	{
+		RenderBuffer* buffer = gentle::BeginRenderFrame(queue);
+		buffer->pixels[0] = frame;
+		gentle::SubmitRenderFrame(queue, buffer);
+	}
+	gentle::ClosePresentQueue(queue);
+	presenter.join();
+
+	assert(presentedFrames.size() == frameCount);
+	for (uint32_t frame = 0; frame < frameCount; frame += 1)
+	{
+		assert(presentedFrames[frame] == frame);
+	}
+	gentle::PresentQueueStats stats = gentle::GetPresentQueueStats(queue);
+	assert(stats.framesSubmitted == frameCount);
+	assert(stats.framesPresented == frameCount);
+	assert(stats.framesDropped == 0);
+}
+
+static bool HasDirtyPixel(const gentle::DirtyRegion &region, int x, int y)
+{
+	for (int i = 0; i < region.rectCount; i += 1)
+	{
+		const gentle::PixelRect &rect = region.rects[i];
+		if ((x >= rect.x0) && (x < rect.x1) && (y >= rect.y0) && (y < rect.y1))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void RunDirtyRegionPresentQueueTest()
+{
+	gentle::DirtyRegion regions[2];
+	RenderBuffer buffers[2] = {};
+	for (int i = 0; i < 2; i += 1)
+	{
+		buffers[i].width = 4;
+		buffers[i].height = 4;
+		buffers[i].dirtyRegion = &regions[i];
+		gentle::ResetDirtyRegion(regions[i]);
+	}
+
+	// Each buffer has to catch up on what the other one drew, & what gets presented is everything since the last present
+	gentle::PresentQueue queue;
+	gentle::InitializePresentQueue(queue, buffers, 2, gentle::PRESENT_MODE_FIFO);
+	RenderBuffer* first = gentle::BeginRenderFrame(queue);
+	gentle::AddDirtyRect(*first->dirtyRegion, gentle::PixelRect { 0, 0, 1, 1 });
+	gentle::SubmitRenderFrame(queue, first);
+	RenderBuffer* second = gentle::BeginRenderFrame(queue);
+	assert((second->dirtyRegion->rectCount == 1) && HasDirtyPixel(*second->dirtyRegion, 0, 0));
+	gentle::AddDirtyRect(*second->dirtyRegion, gentle::PixelRect { 2, 2, 3, 3 });
+	gentle::SubmitRenderFrame(queue, second);
+
+	RenderBuffer* presented = gentle::BeginPresentFrame(queue);
+	assert((presented == first) && (presented->dirtyRegion->rectCount == 1));
+	gentle::EndPresentFrame(queue, presented);
+	assert(first->dirtyRegion->rectCount == 0);
+	presented = gentle::BeginPresentFrame(queue);
+	assert((presented == second) && (presented->dirtyRegion->rectCount == 2));
+	gentle::EndPresentFrame(queue, presented);
+
+	RenderBuffer* third = gentle::BeginRenderFrame(queue);
+	assert(third == first);
+	assert(HasDirtyPixel(*third->dirtyRegion, 0, 0) && HasDirtyPixel(*third->dirtyRegion, 2, 2) && !HasDirtyPixel(*third->dirtyRegion, 3, 0));
+	gentle::SubmitRenderFrame(queue, third);
+	gentle::EndPresentFrame(queue, gentle::BeginPresentFrame(queue));
+
+	// A frame dropped in mailbox mode never got shown, so the frame that replaces it has to show its changes as well
+	gentle::InitializePresentQueue(queue, buffers, 2, gentle::PRESENT_MODE_MAILBOX);
+	RenderBuffer* dropped = gentle::BeginRenderFrame(queue);
+	gentle::AddDirtyRect(*dropped->dirtyRegion, gentle::PixelRect { 1, 0, 2, 1 });
+	gentle::SubmitRenderFrame(queue, dropped);
+	RenderBuffer* newest = gentle::BeginRenderFrame(queue);
+	assert(newest != dropped);
+	gentle::AddDirtyRect(*newest->dirtyRegion, gentle::PixelRect { 3, 3, 4, 4 });
+	gentle::SubmitRenderFrame(queue, newest);
+	presented = gentle::BeginPresentFrame(queue);
+	assert(presented == newest);
+	assert(HasDirtyPixel(*presented->dirtyRegion, 1, 0) && HasDirtyPixel(*presented->dirtyRegion, 3, 3));
+	gentle::EndPresentFrame(queue, presented);
+	assert(gentle::GetPresentQueueStats(queue).framesDropped == 1);
+}
+
+void RunPresentQueueTests()
+{
+	RunDirtyRegionPresentQueueTest();
+
+	for (int bufferCount = 1; bufferCount <= gentle::MAX_PRESENT_BUFFERS; bufferCount += 1)
+	{
+		RunFifoPresentQueueTest(bufferCount);
+	}
+
+	uint32_t pixels[2] = {};
+	RenderBuffer buffers[2] = {};
+	buffers[0].pixels = &pixels[0];
+	buffers[1].pixels = &pixels[1];
+
+	// In mailbox mode the game never waits on the presenter, & only the newest frame gets presented
+	gentle::PresentQueue queue;
+	gentle::InitializePresentQueue(queue, buffers, 2, gentle::PRESENT_MODE_MAILBOX);
+	for (uint32_t frame = 0; frame < 5; frame += 1)
+	{
+		RenderBuffer* buffer = gentle::BeginRenderFrame(queue);
+		buffer->pixels[0] = frame;
+		gentle::SubmitRenderFrame(queue, buffer);
+	}
+	RenderBuffer* presented = gentle::BeginPresentFrame(queue);
+	assert(presented->pixels[0] == 4);
+
+	// With the other buffer out being presented, the game takes back the frame waiting rather than block
+	RenderBuffer* rendering = gentle::BeginRenderFrame(queue);
+	assert(rendering != presented);
+	rendering->pixels[0] = 5;
+	gentle::SubmitRenderFrame(queue, rendering);
+	rendering = gentle::BeginRenderFrame(queue);
+	assert(rendering != presented);
+	rendering->pixels[0] = 6;
+	gentle::SubmitRenderFrame(queue, rendering);
+	gentle::EndPresentFrame(queue, presented);
+
+	gentle::ClosePresentQueue(queue);
+	presented = gentle::BeginPresentFrame(queue);
+	assert(presented->pixels[0] == 6);
+	gentle::EndPresentFrame(queue, presented);
+	assert(gentle::BeginPresentFrame(queue) == nullptr);
+	gentle::WaitForPresentQueueIdle(queue);
+
+	gentle::PresentQueueStats stats = gentle::GetPresentQueueStats(queue);
+	assert(stats.framesSubmitted == 7);
+	assert(stats.framesPresented == 2);
+	assert(stats.framesDropped == 5);
+	assert(stats.renderWaits == 0);
+}
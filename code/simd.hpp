@@ -0,0 +1,17 @@
+#ifndef GENTLE_SIMD_H
+#define GENTLE_SIMD_H
+
+/**
+ * Picks the widest instruction set the compiler is targeting, for the code that has SIMD paths. GENTLE_AVX2 when building
+ * with AVX2, e.g. -mavx2 or /arch:AVX2, otherwise GENTLE_SSE2 wherever SSE2 is available, which is every x64 build.
+ * Neither is defined on other targets, which take the plain C++ paths.
+ */
+#if defined(__AVX2__)
+#define GENTLE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GENTLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#endif
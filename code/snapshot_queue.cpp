@@ -0,0 +1,75 @@
+#include <assert.h>
+#include "snapshot_queue.hpp"
+
+namespace gentle
+{
+	void InitializeSnapshotQueue(SnapshotQueue &queue, void* firstSnapshot, void* secondSnapshot)
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.snapshots[0] = firstSnapshot;
+		queue.snapshots[1] = secondSnapshot;
+		queue.publishedCount = 0;
+		queue.readCount = 0;
+		queue.isClosed = false;
+		queue.writeWaits = 0;
+		queue.readWaits = 0;
+	}
+
+	void* BeginWriteSnapshot(SnapshotQueue &queue)
+	{
+		std::unique_lock<std::mutex> lock(queue.mutex);
+		assert(!queue.isClosed);
+
+		// The next snapshot to write is the one published two frames back, so it's free once that's been read
+		if ((queue.publishedCount - queue.readCount) >= 2)
+		{
+			queue.writeWaits += 1;
+			queue.stateChanged.wait(lock, [&] { return (queue.publishedCount - queue.readCount) < 2; });
+		}
+		return queue.snapshots[queue.publishedCount % 2];
+	}
+
+	void PublishSnapshot(SnapshotQueue &queue)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.publishedCount += 1;
+		}
+		queue.stateChanged.notify_all();
+	}
+
+	const void* BeginReadSnapshot(SnapshotQueue &queue)
+	{
+		std::unique_lock<std::mutex> lock(queue.mutex);
+		if ((queue.publishedCount == queue.readCount) && !queue.isClosed)
+		{
+			queue.readWaits += 1;
+			queue.stateChanged.wait(lock, [&] { return (queue.publishedCount > queue.readCount) || queue.isClosed; });
+		}
+
+		if (queue.publishedCount == queue.readCount)
+		{
+			return nullptr;
+		}
+		return queue.snapshots[queue.readCount % 2];
+	}
+
+	void EndReadSnapshot(SnapshotQueue &queue)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			assert(queue.readCount < queue.publishedCount);
+			queue.readCount += 1;
+		}
+		queue.stateChanged.notify_all();
+	}
+
+	void CloseSnapshotQueue(SnapshotQueue &queue)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.isClosed = true;
+		}
+		queue.stateChanged.notify_all();
+	}
+}
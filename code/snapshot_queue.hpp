@@ -0,0 +1,46 @@
+#ifndef GENTLE_SNAPSHOT_QUEUE_H
+#define GENTLE_SNAPSHOT_QUEUE_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+
+namespace gentle
+{
+	/**
+	 * Hands the state the renderer needs from the game's Update to a Render on another thread, through the two snapshots
+	 * in GameMemory.SnapshotStorage. Update fills one while Render reads the other, so simulating frame N + 1 overlaps with
+	 * rendering frame N. Snapshots are read in the order they were published & none get skipped, so a threaded run draws
+	 * exactly the frames a single threaded one does.
+	 */
+	struct SnapshotQueue
+	{
+		void* snapshots[2];
+		uint64_t publishedCount;
+		uint64_t readCount;	// Snapshots Render has finished with
+		bool isClosed;
+		int writeWaits;	// Times Update had to wait for Render to finish with a snapshot
+		int readWaits;	// Times Render had to wait for Update to publish one
+
+		std::mutex mutex;
+		std::condition_variable stateChanged;
+	};
+
+	void InitializeSnapshotQueue(SnapshotQueue &queue, void* firstSnapshot, void* secondSnapshot);
+
+	// Game thread. Blocks while Render is still reading the snapshot from two frames back
+	void* BeginWriteSnapshot(SnapshotQueue &queue);
+
+	// Game thread. Hand the snapshot from BeginWriteSnapshot over to Render, which must not change it
+	void PublishSnapshot(SnapshotQueue &queue);
+
+	// Render thread. Blocks until a snapshot is published. Returns nullptr once the queue is closed & every snapshot read
+	const void* BeginReadSnapshot(SnapshotQueue &queue);
+
+	void EndReadSnapshot(SnapshotQueue &queue);
+
+	// Let the render thread finish the snapshots already published & then stop
+	void CloseSnapshotQueue(SnapshotQueue &queue);
+}
+
+#endif
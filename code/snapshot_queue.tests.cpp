@@ -0,0 +1,56 @@
+#include "snapshot_queue.hpp"
+#include <assert.h>
+#include <thread>
+#include <vector>
+
+void RunSnapshotQueueTests()
+{
+	// Every snapshot gets read once, in order, & never while the game is writing the next one
+	const int frameCount = 200;
+	int snapshots[2] = {};
+	gentle::SnapshotQueue queue;
+	gentle::InitializeSnapshotQueue(queue, &snapshots[0], &snapshots[1]);
+
+	std::vector<int> renderedFrames;
+	std::thread renderer([&]
+	{
+		while (const int* snapshot = (const int*)gentle::BeginReadSnapshot(queue))
+		{
+			int frame = *snapshot;
+			std::this_thread::yield();
+			assert(*snapshot == frame);
+			renderedFrames.push_back(frame);
+			gentle::EndReadSnapshot(queue);
+		}
+	});
+
+	for (int frame = 0; frame < frameCount; frame += 1)
+	{
+		int* snapshot = (int*)gentle::BeginWriteSnapshot(queue);
+		assert(snapshot == &snapshots[frame % 2]);
+		*snapshot = frame;
+		gentle::PublishSnapshot(queue);
+	}
+	gentle::CloseSnapshotQueue(queue);
+	renderer.join();
+
+	assert((int)renderedFrames.size() == frameCount);
+	for (int frame = 0; frame < frameCount; frame += 1)
+	{
+		assert(renderedFrames[frame] == frame);
+	}
+
+	// The game can get one snapshot ahead of the renderer without waiting, & a closed queue still hands out what's left
+	gentle::InitializeSnapshotQueue(queue, &snapshots[0], &snapshots[1]);
+	*(int*)gentle::BeginWriteSnapshot(queue) = 10;
+	gentle::PublishSnapshot(queue);
+	*(int*)gentle::BeginWriteSnapshot(queue) = 11;
+	gentle::PublishSnapshot(queue);
+	assert(queue.writeWaits == 0);
+	gentle::CloseSnapshotQueue(queue);
+	assert(*(const int*)gentle::BeginReadSnapshot(queue) == 10);
+	gentle::EndReadSnapshot(queue);
+	assert(*(const int*)gentle::BeginReadSnapshot(queue) == 11);
+	gentle::EndReadSnapshot(queue);
+	assert(gentle::BeginReadSnapshot(queue) == nullptr);
+}
@@ -2,11 +2,141 @@
 #include "math.hpp"
 #include "geometry.hpp"
 #include "software_rendering.hpp"
-#include <list>
+#include "simd.hpp"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <vector>
 
 namespace gentle
 {
+	static RenderTile* GetRenderTile(const RenderBuffer &renderBuffer, int tileX, int tileY)
+	{
+		int tileCountX = (renderBuffer.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+		return renderBuffer.tiles + (tileY * tileCountX) + tileX;
+	}
+
+	// The pixels drawing may write to. The scissor when there is one, but never anything outside the buffer
+	static PixelRect GetScissor(const RenderBuffer &renderBuffer)
+	{
+		PixelRect wholeBuffer = { 0, 0, renderBuffer.width, renderBuffer.height };
+		return renderBuffer.scissor ? IntersectPixelRects(*renderBuffer.scissor, wholeBuffer) : wholeBuffer;
+	}
+
+	static bool IsWholeBuffer(const RenderBuffer &renderBuffer, const PixelRect &rect)
+	{
+		return (rect.x0 == 0) && (rect.y0 == 0) && (rect.x1 == renderBuffer.width) && (rect.y1 == renderBuffer.height);
+	}
+
+	// Record that the pixels in rect have been written, so they need presenting
+	static void MarkDirty(const RenderBuffer &renderBuffer, const PixelRect &rect)
+	{
+		if (renderBuffer.dirtyRegion)
+		{
+			AddDirtyRect(*renderBuffer.dirtyRegion, rect);
+		}
+	}
+
+	/**
+	 * Set count values starting at row to value. Streaming stores write straight to memory without reading each cache line
+	 * in first, which suits big fills that won't be read again soon. Call StoreFence once they're done.
+	 */
+	template<typename T>
+	static void FillRow(T* row, T value, int count, bool isStreaming)
+	{
+		int i = 0;
+#if defined(GENTLE_AVX2) || defined(GENTLE_SSE2)
+		static_assert(sizeof(T) == sizeof(uint32_t), "FillRow fills 32 bit values");
+
+		// SIMD stores need to start on a 16 byte boundary
+		for (; (i < count) && (((uintptr_t)(row + i) & 15) != 0); i += 1)
+		{
+			row[i] = value;
+		}
+
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		__m128i wideValue = _mm_set1_epi32((int)bits);
+		if (isStreaming)
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				_mm_stream_si128((__m128i*)(row + i), wideValue);
+			}
+		}
+		else
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				_mm_store_si128((__m128i*)(row + i), wideValue);
+			}
+		}
+#endif
+		for (; i < count; i += 1)
+		{
+			row[i] = value;
+		}
+	}
+
+	static void StoreFence()
+	{
+#if defined(GENTLE_AVX2) || defined(GENTLE_SSE2)
+		_mm_sfence();
+#endif
+	}
+
+	static void ResolvePendingClear(const RenderBuffer &renderBuffer, RenderTile* tile, int tileX, int tileY)
+	{
+		int x0 = tileX * RENDER_TILE_SIZE;
+		int y0 = tileY * RENDER_TILE_SIZE;
+		int x1 = std::min(x0 + RENDER_TILE_SIZE, renderBuffer.width);
+		int y1 = std::min(y0 + RENDER_TILE_SIZE, renderBuffer.height);
+
+		// The tile is about to be drawn to, so keep it in the cache with regular stores
+		for (int y = y0; y < y1; y += 1)
+		{
+			int positionOfX0InRow = (renderBuffer.width * y) + x0;
+			if (renderBuffer.pixels)
+			{
+				FillRow(renderBuffer.pixels + positionOfX0InRow, tile->clearColor, x1 - x0, false);
+			}
+			FillRow(renderBuffer.depth + positionOfX0InRow, 0.0f, x1 - x0, false);
+		}
+		tile->isClearPending = false;
+	}
+
+	/**
+	 * Carry out the deferred clear of any tiles overlapping the pixel ordinals x0 to x1, y0 to y1 (inclusive) before they get drawn to
+	 */
+	static void ResolvePendingClears(const RenderBuffer &renderBuffer, int x0, int y0, int x1, int y1)
+	{
+		if (!renderBuffer.tiles)
+		{
+			return;
+		}
+
+		x0 = std::max(x0, 0);
+		y0 = std::max(y0, 0);
+		x1 = std::min(x1, renderBuffer.width - 1);
+		y1 = std::min(y1, renderBuffer.height - 1);
+		for (int tileY = y0 / RENDER_TILE_SIZE; tileY <= y1 / RENDER_TILE_SIZE; tileY += 1)
+		{
+			for (int tileX = x0 / RENDER_TILE_SIZE; tileX <= x1 / RENDER_TILE_SIZE; tileX += 1)
+			{
+				RenderTile* tile = GetRenderTile(renderBuffer, tileX, tileY);
+				if (tile->isClearPending)
+				{
+					ResolvePendingClear(renderBuffer, tile, tileX, tileY);
+				}
+			}
+		}
+	}
+
 	/**
 	 *	|---|---|---|
 	 *	| 0 | 1 | 2 |	pixel ordinals
@@ -15,20 +145,29 @@ namespace gentle
 	 *
 	 * x & y parameters are the pixel and NOT the position ordinals
 	 */
-	void PlotPixel(const RenderBuffer &renderBuffer, uint32_t color, int x, int y)
+	static void PlotPixel(const RenderBuffer &renderBuffer, uint32_t color, int x, int y, const PixelRect &scissor)
 	{
-		// Make sure writing to the render buffer does not escape its bounds
-		if (x < 0 || x >(renderBuffer.width - 1) || y < 0 || y >(renderBuffer.height - 1))
+		// Make sure writing to the render buffer does not escape the scissor, which is never bigger than the buffer
+		if (x < scissor.x0 || x >= scissor.x1 || y < scissor.y0 || y >= scissor.y1)
 		{
 			return;
 		}
 
+		ResolvePendingClears(renderBuffer, x, y, x, y);
+
 		int positionStartOfRow = renderBuffer.width * y;
 		int positionStartOfX0InRow = positionStartOfRow + x;
 		uint32_t* pixel = renderBuffer.pixels + positionStartOfX0InRow;
 		*pixel = color;
 	}
 
+	void PlotPixel(const RenderBuffer &renderBuffer, uint32_t color, int x, int y)
+	{
+		PixelRect scissor = GetScissor(renderBuffer);
+		MarkDirty(renderBuffer, IntersectPixelRects(scissor, PixelRect { x, y, x + 1, y + 1 }));
+		PlotPixel(renderBuffer, color, x, y, scissor);
+	}
+
 	/**
 	 *	|---|---|---|
 	 *	| 0 | 1 | 2 |	pixel ordinals
@@ -37,25 +176,193 @@ namespace gentle
 	 *
 	 * x1, x2 & y parameters are the pixel and NOT the position ordinals
 	 */
-	static void DrawHorizontalLineInPixels(const RenderBuffer &renderBuffer, uint32_t color, int x0, int x1, int y)
+	static void DrawHorizontalLineInPixels(const RenderBuffer &renderBuffer, uint32_t color, int x0, int x1, int y, const PixelRect &scissor)
 	{
-		const int* startX = &x0;
-		const int* endX = &x1;
 		if (x1 < x0)
 		{
 			std::swap(x0, x1);
 		}
+		x0 = std::max(x0, scissor.x0);
+		x1 = std::min(x1, scissor.x1 - 1);
+		if ((x0 > x1) || (y < scissor.y0) || (y >= scissor.y1))
+		{
+			return;
+		}
+
+		ResolvePendingClears(renderBuffer, x0, y, x1, y);
 
 		int positionStartOfRow = renderBuffer.width * y;
-		int positionOfX0InRow = positionStartOfRow + *startX;
+		int positionOfX0InRow = positionStartOfRow + x0;
 		uint32_t* pixelPointer = renderBuffer.pixels + positionOfX0InRow;
-		for (int i = *startX; i <= *endX; i += 1)
+		for (int i = x0; i <= x1; i += 1)
 		{
 			*pixelPointer = color;
 			pixelPointer++;
 		}
 	}
 
+	/**
+	 * Depth across the face of a triangle as a function of the pixel position, z = z0 + (dzdx * x) + (dzdy * y).
+	 * Depth is stored reversed, 1 at the near plane falling towards 0 at infinity, so the greatest depth wins.
+	 * It is proportional to 1/w which is linear in screen space, so interpolating it across the triangle is perspective correct.
+	 */
+	struct DepthPlane
+	{
+		float z0;
+		float dzdx;
+		float dzdy;
+	};
+
+	static DepthPlane MakeConstantDepthPlane(float z)
+	{
+		return DepthPlane { z, 0.0f, 0.0f };
+	}
+
+	/**
+	 * p0, p1 & p2 are positions in pixels (NOT pixel ordinals), so the centre of pixel ordinal (0, 0) is at (0.5, 0.5)
+	 */
+	static DepthPlane MakeDepthPlane(const Vec2<float> &p0, const Vec2<float> &p1, const Vec2<float> &p2, float z0, float z1, float z2)
+	{
+		float dx1 = p1.x - p0.x;
+		float dy1 = p1.y - p0.y;
+		float dx2 = p2.x - p0.x;
+		float dy2 = p2.y - p0.y;
+		float doubleArea = (dx1 * dy2) - (dy1 * dx2);
+		if (doubleArea == 0.0f)
+		{
+			return MakeConstantDepthPlane((z0 + z1 + z2) / 3.0f);
+		}
+
+		float dz1 = z1 - z0;
+		float dz2 = z2 - z0;
+		DepthPlane plane;
+		plane.dzdx = ((dz1 * dy2) - (dz2 * dy1)) / doubleArea;
+		plane.dzdy = ((dz2 * dx1) - (dz1 * dx2)) / doubleArea;
+		plane.z0 = z0 - (plane.dzdx * p0.x) - (plane.dzdy * p0.y);
+		return plane;
+	}
+
+	/**
+	 * Depth at the centre of the pixel ordinal (0, y). Depth at the centre of pixel ordinal (x, y) is then
+	 * rowDepth + (dzdx * x). Every fill routine evaluates depth this way so the result for a pixel doesn't depend
+	 * on where a scanline or block starts.
+	 */
+	static float GetRowDepth(const DepthPlane &plane, int y)
+	{
+		return plane.z0 + (plane.dzdx * 0.5f) + (plane.dzdy * ((float)y + 0.5f));
+	}
+
+	struct DepthRange
+	{
+		float min;
+		float max;
+	};
+
+	/**
+	 * Range of depth values the plane takes over the pixel ordinals x0 to x1, y0 to y1 (inclusive). The plane is linear so the
+	 * extremes are at the corners. The range is widened by the rounding error of evaluating the plane at a single pixel so
+	 * it's safe to compare against depth values that were written pixel by pixel.
+	 * Pixel ordinals must not be negative.
+	 */
+	static DepthRange GetDepthRange(const DepthPlane &plane, int x0, int y0, int x1, int y1)
+	{
+		float rowDepth0 = GetRowDepth(plane, y0);
+		float rowDepth1 = GetRowDepth(plane, y1);
+		float z00 = rowDepth0 + (plane.dzdx * (float)x0);
+		float z10 = rowDepth0 + (plane.dzdx * (float)x1);
+		float z01 = rowDepth1 + (plane.dzdx * (float)x0);
+		float z11 = rowDepth1 + (plane.dzdx * (float)x1);
+
+		float magnitude = fabsf(plane.z0) + (fabsf(plane.dzdx) * ((float)x1 + 1.0f)) + (fabsf(plane.dzdy) * ((float)y1 + 1.0f));
+		float error = magnitude * 4.0f * FLT_EPSILON;
+
+		DepthRange range;
+		range.min = std::min(std::min(z00, z10), std::min(z01, z11)) - error;
+		range.max = std::max(std::max(z00, z10), std::max(z01, z11)) + error;
+		return range;
+	}
+
+	/**
+	 * Hierarchical depth
+	 *
+	 * Each RenderTile keeps a conservative min & max of the depth buffer over its block of pixels. Anything whose greatest
+	 * depth is no more than the min depth of every tile it touches would fail the depth test at every pixel, so it can be
+	 * skipped without touching the depth buffer. Depth values only ever increase until the next clear, so rather than
+	 * working out the new min after every write the tile is marked stale and the min is recalculated when it's next needed.
+	 */
+	static float GetDepthTileMin(const RenderBuffer &renderBuffer, int tileX, int tileY)
+	{
+		RenderTile* tile = GetRenderTile(renderBuffer, tileX, tileY);
+		if (tile->isMinDepthStale)
+		{
+			int x0 = tileX * RENDER_TILE_SIZE;
+			int y0 = tileY * RENDER_TILE_SIZE;
+			int x1 = std::min(x0 + RENDER_TILE_SIZE, renderBuffer.width);
+			int y1 = std::min(y0 + RENDER_TILE_SIZE, renderBuffer.height);
+
+			float minDepth = tile->maxDepth;
+			for (int y = y0; y < y1; y += 1)
+			{
+				const float* depthPointer = renderBuffer.depth + (renderBuffer.width * y) + x0;
+				for (int x = x0; x < x1; x += 1)
+				{
+					minDepth = std::min(minDepth, *depthPointer);
+					depthPointer++;
+				}
+			}
+			tile->minDepth = minDepth;
+			tile->isMinDepthStale = false;
+		}
+		return tile->minDepth;
+	}
+
+	/**
+	 * True when nothing with a depth of maxDepth or less can pass the depth test anywhere in the pixel ordinals x0 to x1, y0 to y1 (inclusive)
+	 * A stale min depth is still a lower bound, just a loose one. Recalculating it costs about as much as filling a block, so only
+	 * whole triangles refresh stale tiles. Spans & blocks test against whatever min depth the tile already has.
+	 */
+	static bool IsHiddenByDepthTiles(const RenderBuffer &renderBuffer, int x0, int y0, int x1, int y1, float maxDepth, bool refreshStaleTiles)
+	{
+		if (!renderBuffer.tiles)
+		{
+			return false;
+		}
+
+		for (int tileY = y0 / RENDER_TILE_SIZE; tileY <= y1 / RENDER_TILE_SIZE; tileY += 1)
+		{
+			for (int tileX = x0 / RENDER_TILE_SIZE; tileX <= x1 / RENDER_TILE_SIZE; tileX += 1)
+			{
+				float minDepth = (refreshStaleTiles) ? GetDepthTileMin(renderBuffer, tileX, tileY) : GetRenderTile(renderBuffer, tileX, tileY)->minDepth;
+				if (minDepth < maxDepth)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Record that the pixel ordinals x0 to x1, y0 to y1 (inclusive) may have been written with depth values no greater than maxDepth
+	 */
+	static void MarkDepthTilesWritten(const RenderBuffer &renderBuffer, int x0, int y0, int x1, int y1, float maxDepth)
+	{
+		if (!renderBuffer.tiles)
+		{
+			return;
+		}
+
+		for (int tileY = y0 / RENDER_TILE_SIZE; tileY <= y1 / RENDER_TILE_SIZE; tileY += 1)
+		{
+			for (int tileX = x0 / RENDER_TILE_SIZE; tileX <= x1 / RENDER_TILE_SIZE; tileX += 1)
+			{
+				RenderTile* tile = GetRenderTile(renderBuffer, tileX, tileY);
+				tile->maxDepth = std::max(tile->maxDepth, maxDepth);
+				tile->isMinDepthStale = true;
+			}
+		}
+	}
+
 	/**
 	 *	|---|---|---|
 	 *	| 0 | 1 | 2 |	pixel ordinals
@@ -63,30 +370,74 @@ namespace gentle
 	 *	0   1   2   3	position ordinals
 	 *
 	 * x1, x2 & y parameters are the pixel and NOT the position ordinals
+	 * Only pixels inside the scissor rect get written to
 	 */
-	static void DrawHorizontalLineInPixels(const RenderBuffer &renderBuffer, uint32_t color, int x0, int x1, int y, float z)
+	static void DrawHorizontalLineInPixels(const RenderBuffer &renderBuffer, uint32_t color, int x0, int x1, int y, const DepthPlane &depth, const PixelRect &scissor)
 	{
+		if (y < scissor.y0 || y >= scissor.y1)
+		{
+			return;
+		}
+
 		const int* startX = &x0;
 		const int* endX = &x1;
 		if (x1 < x0)
 		{
 			std::swap(x0, x1);
 		}
+		if (x0 < scissor.x0)
+		{
+			x0 = scissor.x0;
+		}
+		if (x1 > scissor.x1 - 1)
+		{
+			x1 = scissor.x1 - 1;
+		}
+		if (x1 < x0)
+		{
+			return;
+		}
+
+		DepthRange spanDepth = GetDepthRange(depth, x0, y, x1, y);
+		if (IsHiddenByDepthTiles(renderBuffer, x0, y, x1, y, spanDepth.max, false))
+		{
+			return;
+		}
+		ResolvePendingClears(renderBuffer, x0, y, x1, y);
 
 		int positionStartOfRow = renderBuffer.width * y;
 		int positionOfX0InRow = positionStartOfRow + *startX;
-		uint32_t* pixelPointer = renderBuffer.pixels + positionOfX0InRow;
 		float* depthPointer = renderBuffer.depth + positionOfX0InRow;
-		for (int i = *startX; i <= *endX; i += 1)
+		float rowDepth = GetRowDepth(depth, y);
+		if (renderBuffer.pixels)
+		{
+			uint32_t* pixelPointer = renderBuffer.pixels + positionOfX0InRow;
+			for (int i = *startX; i <= *endX; i += 1)
+			{
+				float z = rowDepth + (depth.dzdx * (float)i);
+				if (*depthPointer < z)
+				{
+					*depthPointer = z;
+					*pixelPointer = color;
+				}
+				pixelPointer++;
+				depthPointer++;
+			}
+		}
+		else
 		{
-			if (*depthPointer < z)
+			for (int i = *startX; i <= *endX; i += 1)
 			{
-				*depthPointer = z;
-				*pixelPointer = color;
+				float z = rowDepth + (depth.dzdx * (float)i);
+				if (*depthPointer < z)
+				{
+					*depthPointer = z;
+				}
+				depthPointer++;
 			}
-			pixelPointer++;
-			depthPointer++;
 		}
+
+		MarkDepthTilesWritten(renderBuffer, x0, y, x1, y, spanDepth.max);
 	}
 
 	/**
@@ -97,14 +448,14 @@ namespace gentle
 	 *
 	 * x, y0 & y1 parameters are the pixel and NOT the position ordinals
 	 */
-	void DrawVerticalLineInPixels(const RenderBuffer &renderBuffer, uint32_t color, int x, int y0, int y1)
+	static void DrawVerticalLineInPixels(const RenderBuffer &renderBuffer, uint32_t color, int x, int y0, int y1, const PixelRect &scissor)
 	{
 		int yDiff = y1 - y0;
 		int yDiffMod = (yDiff < 0) ? -1 * yDiff : yDiff;
 		int yIncrement = (yDiff < 0) ? -1 : 1;
 		for (int i = 0; i <= yDiffMod; i += 1)
 		{
-			PlotPixel(renderBuffer, color, x, y0);
+			PlotPixel(renderBuffer, color, x, y0, scissor);
 			y0 += yIncrement;
 		}
 	}
@@ -124,18 +475,27 @@ namespace gentle
 		int y0 = p0.y;
 		int x1 = p1.x;
 		int y1 = p1.y;
+
+		// Nothing outside the line's bounds gets written, so they're all the scissor the pixels need
+		PixelRect bounds = { std::min(x0, x1), std::min(y0, y1), std::max(x0, x1) + 1, std::max(y0, y1) + 1 };
+		PixelRect scissor = IntersectPixelRects(GetScissor(renderBuffer), bounds);
+		if (IsPixelRectEmpty(scissor))
+		{
+			return;
+		}
+		MarkDirty(renderBuffer, scissor);
 		
 		int xDiff = x1 - x0;
 		if (xDiff == 0)
 		{
-			DrawVerticalLineInPixels(renderBuffer, color, x0, y0, y1);
+			DrawVerticalLineInPixels(renderBuffer, color, x0, y0, y1, scissor);
 			return;
 		}
 
 		int yDiff = y1 - y0;
 		if (yDiff == 0)
 		{
-			DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y0);
+			DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y0, scissor);
 			return;
 		}
 		bool negativeXDiff = (xDiff < 0);
@@ -150,7 +510,7 @@ namespace gentle
 		{
 			for (int i = 0; i <= xDiffMod; ++i)
 			{
-				PlotPixel(renderBuffer, color, x0, y0);
+				PlotPixel(renderBuffer, color, x0, y0, scissor);
 				x0 += xIncrement;
 				y0 += yIncrement;
 			}
@@ -193,7 +553,7 @@ namespace gentle
 
 		for (int i = 0; i <= longDimensionDiff; i += 1)
 		{
-			PlotPixel(renderBuffer, color, x0, y0);
+			PlotPixel(renderBuffer, color, x0, y0, scissor);
 			*longDimensionVar += longDimensionIncrement;
 			if (p < 0)
 			{
@@ -226,6 +586,16 @@ namespace gentle
 		x1 = ClampInt(1, x1, renderBuffer.width);
 		y0 = ClampInt(1, y0, renderBuffer.height);
 		y1 = ClampInt(1, y1, renderBuffer.height);
+		PixelRect scissor = GetScissor(renderBuffer);
+		x0 = std::max(x0, scissor.x0);
+		x1 = std::min(x1, scissor.x1);
+		y0 = std::max(y0, scissor.y0);
+		y1 = std::min(y1, scissor.y1);
+		if (x0 < x1 && y0 < y1)
+		{
+			ResolvePendingClears(renderBuffer, x0, y0, x1 - 1, y1 - 1);
+			MarkDirty(renderBuffer, PixelRect { x0, y0, x1, y1 });
+		}
 
 		for (int y = y0; y < y1; y++)
 		{
@@ -333,7 +703,7 @@ namespace gentle
 	 *	   \ /	  +ve y (if +ve y is up, this is actually a flat bottom triangle)
 	 *	    p2
 	 */
-	void FillFlatTopTriangle(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z)
+	static void FillFlatTopTriangle(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, const DepthPlane &depth, const PixelRect &scissor)
 	{
 		// LINE 0-->2
 		bool p2IsRightOfP0 = (p0.x < p2.x);
@@ -370,7 +740,7 @@ namespace gentle
 		for (int y = p0.y; y <= p2.y; y += 1)
 		{
 			// draw scanline to fill in triangle between x0 & x1
-			DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y, z);
+			DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y, depth, scissor);
 
 			// Loop through the x0 / acc0 evaluation until acc0 is +ve.
 			// acc0 turning +ve is the indication we should plot.
@@ -439,7 +809,7 @@ namespace gentle
 	 *	 /      \	  +ve y (if +ve y is up, this is actually a flat top triangle)
 	 *	p1------p2
 	 */
-	void FillFlatBottomTriangle(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z)
+	static void FillFlatBottomTriangle(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, const DepthPlane &depth, const PixelRect &scissor)
 	{
 		// LINE 0-->1
 		bool p1IsLeftOfP0 = (p1.x < p0.x);
@@ -497,7 +867,7 @@ namespace gentle
 			}
 
 			// draw scanline to fill in triangle between x0 & x1
-			DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y, z);
+			DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y, depth, scissor);
 
 			// line p0 --> p1: decide to increment x0 or not for current y
 			if (isLongDimension0X)
@@ -539,11 +909,25 @@ namespace gentle
 		}
 
 		// draw final scanline to fill in triangle between x0 & x1
-		DrawHorizontalLineInPixels(renderBuffer, color, p1.x, p2.x, p1.y, z);
+		DrawHorizontalLineInPixels(renderBuffer, color, p1.x, p2.x, p1.y, depth, scissor);
 	}
 
-	void FillTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z)
+	static void FillTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, const DepthPlane &depth, const PixelRect &scissor)
 	{
+		// Skip the whole triangle if it's hidden behind what's already in the depth buffer
+		int minX = std::max(std::min(p0.x, std::min(p1.x, p2.x)), scissor.x0);
+		int maxX = std::min(std::max(p0.x, std::max(p1.x, p2.x)), scissor.x1 - 1);
+		int minY = std::max(std::min(p0.y, std::min(p1.y, p2.y)), scissor.y0);
+		int maxY = std::min(std::max(p0.y, std::max(p1.y, p2.y)), scissor.y1 - 1);
+		if (minX > maxX || minY > maxY)
+		{
+			return;
+		}
+		if (IsHiddenByDepthTiles(renderBuffer, minX, minY, maxX, maxY, GetDepthRange(depth, minX, minY, maxX, maxY).max, true))
+		{
+			return;
+		}
+
 		const Vec3<int>* pp0 = &p0;
 		const Vec3<int>* pp1 = &p1;
 		const Vec3<int>* pp2 = &p2;
@@ -576,7 +960,7 @@ namespace gentle
 			{
 				std::swap(pp0, pp1);
 			}
-			FillFlatTopTriangle(renderBuffer, color, *pp0, *pp1, *pp2, z);
+			FillFlatTopTriangle(renderBuffer, color, *pp0, *pp1, *pp2, depth, scissor);
 		}
 		else if (pp1->y == pp2->y) // natural flat bottom
 		{
@@ -585,7 +969,7 @@ namespace gentle
 			{
 				std::swap(pp1, pp2);
 			}
-			FillFlatBottomTriangle(renderBuffer, color, *pp0, *pp1, *pp2, z);
+			FillFlatBottomTriangle(renderBuffer, color, *pp0, *pp1, *pp2, depth, scissor);
 		}
 		else // general triangle
 		{
@@ -653,7 +1037,7 @@ namespace gentle
 				}
 
 				// draw scanline to fill in triangle between x0 & x1
-				DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y, z);
+				DrawHorizontalLineInPixels(renderBuffer, color, x0, x1, y, depth, scissor);
 
 				// line p0 --> p1: decide to increment x0 or not for current y
 				if (isLongDimension0X)
@@ -698,219 +1082,1778 @@ namespace gentle
 			if (pp1xIsLessThanPp2X) // pp1->y is the leftPoint. i.e. Right major triangle
 			{
 				Vec3<int> intermediatePoint = { x1, pp1->y, 0 };
-				FillFlatTopTriangle(renderBuffer, color, *pp1, intermediatePoint, *pp2, z);
+				FillFlatTopTriangle(renderBuffer, color, *pp1, intermediatePoint, *pp2, depth, scissor);
 			}
 			else	// pp1->y is the rightPoint. i.e. Left major triangle
 			{
 				Vec3<int> intermediatePoint = { x0, pp1->y, 0 };
-				FillFlatTopTriangle(renderBuffer, color, intermediatePoint, *pp1, *pp2, z);
+				FillFlatTopTriangle(renderBuffer, color, intermediatePoint, *pp1, *pp2, depth, scissor);
 			}
 		}
 	}
 
 
-	void DrawTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec2<int> &p0, const Vec2<int> &p1, const Vec2<int> &p2)
+	static Vec2<float> GetPixelCentre(const Vec3<int> &pixel)
 	{
-		DrawLineInPixels(renderBuffer, color, p0, p1);
-		DrawLineInPixels(renderBuffer, color, p1, p2);
-		DrawLineInPixels(renderBuffer, color, p2, p0);
+		return Vec2<float> { (float)pixel.x + 0.5f, (float)pixel.y + 0.5f };
 	}
 
-	void ClearScreen(const RenderBuffer &renderBuffer, uint32_t color)
+	// Pixels a triangle with corners at p0, p1 & p2 may cover, for either fill engine
+	static PixelRect GetTriangleBounds(const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2)
 	{
-		uint32_t* pixel = renderBuffer.pixels;
-		float* depth = renderBuffer.depth;
-
-		for (int y = 0; y < renderBuffer.height; y += 1)
+		return PixelRect
 		{
-			for (int x = 0; x < renderBuffer.width; x += 1)
-			{
-				*pixel = color;
-				pixel++;
-
-				*depth = 0.0f;;
-				depth++;
-			}
-		}
+			std::min(p0.x, std::min(p1.x, p2.x)),
+			std::min(p0.y, std::min(p1.y, p2.y)),
+			std::max(p0.x, std::max(p1.x, p2.x)) + 1,
+			std::max(p0.y, std::max(p1.y, p2.y)) + 1
+		};
 	}
 
-	unsigned int GetColorFromRGB(int red, int green, int blue)
+	// The scissor to fill a triangle with, after marking the part of the triangle inside it dirty
+	static PixelRect GetTriangleScissor(const RenderBuffer &renderBuffer, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2)
 	{
-		// Use bitwise operators to construct a single uint32_t value from three 0-255 RGB values.
-		// There are 32 bits to fill up.
-		// Each 0-255 value is a single byte, or 8 bits. So the 32 bits will be split into 4 segments (32 bits / 8 bits = 4).
-		// |--1--|--2--|--3--|--4--|	bytes
-		// 1     8     16    24    32	bits
-		//
-		// So the 0xRRGGBB value is made by constructing:
-		// 1. the RR value and shifting it 16 places to the left
-		//		|00|00|00|RR|	--> |00|RR|00|00|
-		// 2. the GG value and shifting it 8 places to the left
-		//		|00|00|00|GG|	-->	|00|00|GG|00|
-		// 3. the BB value
-		//							|00|00|00|BB|
-		// Adding these together gives us the 0xRRGGBB value:
-		//		|0x|00|00|00| + |00|RR|00|00| + |00|00|GG|00| + |00|00|00|BB| = |0x|RR|GG|BB|
-		uint32_t color = (uint32_t)(0x000000 + (red << 16) + (green << 8) + blue);
-		return (unsigned int)color;
+		PixelRect scissor = GetScissor(renderBuffer);
+		MarkDirty(renderBuffer, IntersectPixelRects(scissor, GetTriangleBounds(p0, p1, p2)));
+		return scissor;
 	}
 
-	template<typename T>
-	void TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> transformMatrix, const Matrix4x4<T> projectionMatrix)
+	void FillTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z)
 	{
-		const int RED = 0;
-		const int GREEN = 255;
-		const int BLUE = 0;
+		FillTriangleInPixels(renderBuffer, color, p0, p1, p2, MakeConstantDepthPlane(z), GetTriangleScissor(renderBuffer, p0, p1, p2));
+	}
 
-		// Camera matrix
-		Vec4<T> target = AddVectors(camera.position, camera.direction);
-		Matrix4x4<T> cameraMatrix = PointAt(camera.position, target, camera.up);
+	void FillTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z0, float z1, float z2)
+	{
+		DepthPlane depth = MakeDepthPlane(GetPixelCentre(p0), GetPixelCentre(p1), GetPixelCentre(p2), z0, z1, z2);
+		FillTriangleInPixels(renderBuffer, color, p0, p1, p2, depth, GetTriangleScissor(renderBuffer, p0, p1, p2));
+	}
 
-		// View matrix
-		Matrix4x4<T> viewMatrix = LookAt(cameraMatrix);
+	/**
+	 * Half-space triangle fill
+	 *
+	 * Rather than walking the triangle edges, every pixel is tested against the three edge functions of the triangle.
+	 * Each edge function is positive on the inside of its edge, so a pixel is covered when all three are positive.
+	 * Edge functions are linear, so they can be evaluated for several pixels at once with SIMD and stepped incrementally.
+	 *
+	 * Vertex positions get snapped to a fixed-point grid with SUB_PIXEL_BITS of fractional precision and pixels are
+	 * sampled at their centre. Pixels lying exactly on an edge are only filled for top & left edges so triangles that
+	 * share an edge never both fill the same pixel.
+	 */
+	static const int SUB_PIXEL_BITS = 4;
+	static const int SUB_PIXEL_STEP = 1 << SUB_PIXEL_BITS;
+	static const int HALF_SPACE_BLOCK_SIZE = RENDER_TILE_SIZE;	// Blocks line up with the render tiles so each block can be tested against a single tile
 
-		std::vector<Triangle4d<T>> trianglesToDraw;
+	struct HalfSpaceEdge
+	{
+		int64_t a;	// edge function = (a * x) + (b * y) + c for a sub-pixel position x, y
+		int64_t b;
+		int64_t c;
+	};
 
-		Plane<T> bottomOfScreen = { (T)0, (T)0, (T)0,							(T)0, (T)1, (T)0 };
-		Plane<T> topOfScreen = { (T)0, (T)(renderBuffer.height - 1), (T)0,		(T)0, (T)-1, (T)0 };
-		Plane<T> leftOfScreen = { (T)0, (T)0, (T)0,								(T)1, (T)0, (T)0 };
-		Plane<T> rightOfScreen = { (T)(renderBuffer.width - 1), (T)0, (T)0,		(T)-1, (T)0, (T)0 };
+	static int64_t EvaluateEdge(const HalfSpaceEdge &edge, int pixelX, int pixelY)
+	{
+		int64_t sampleX = ((int64_t)pixelX * SUB_PIXEL_STEP) + (SUB_PIXEL_STEP / 2);
+		int64_t sampleY = ((int64_t)pixelY * SUB_PIXEL_STEP) + (SUB_PIXEL_STEP / 2);
+		return (edge.a * sampleX) + (edge.b * sampleY) + edge.c;
+	}
 
-		for (Triangle4d<T> tri : mesh.triangles)
+	/**
+	 * For the triangle winding where the edge functions are positive on the inside, the top edge is the
+	 * horizontal edge going in the +ve x direction and left edges go in the -ve y direction.
+	 */
+	static HalfSpaceEdge MakeHalfSpaceEdge(const Vec2<int> &from, const Vec2<int> &to)
+	{
+		HalfSpaceEdge edge;
+		edge.a = (int64_t)from.y - (int64_t)to.y;
+		edge.b = (int64_t)to.x - (int64_t)from.x;
+		edge.c = ((int64_t)from.x * (int64_t)to.y) - ((int64_t)from.y * (int64_t)to.x);
+
+		bool isTopEdge = (to.y == from.y) && (from.x < to.x);
+		bool isLeftEdge = (to.y < from.y);
+		if (!isTopEdge && !isLeftEdge)
 		{
-			Triangle4d<T> transformed;
-			Triangle4d<T> viewed;
-			Triangle4d<T> projected; // TODO: switch this to Triangle4d so the depth information is kept and can be used in a depth buffer to prevent double rendering of triangles behind each other
+			// Bias so pixels exactly on the edge fail the >= 0 test
+			edge.c -= 1;
+		}
+		return edge;
+	}
 
-			// Transform the triangle in the mesh
-			MultiplyVectorWithMatrix(tri.p[0], transformed.p[0], transformMatrix);
-			MultiplyVectorWithMatrix(tri.p[1], transformed.p[1], transformMatrix);
-			MultiplyVectorWithMatrix(tri.p[2], transformed.p[2], transformMatrix);
+	static int FloorDivide(int64_t numerator, int denominator)
+	{
+		int64_t quotient = numerator / denominator;
+		if ((numerator % denominator != 0) && (numerator < 0))
+		{
+			quotient -= 1;
+		}
+		return (int)quotient;
+	}
 
-			// Work out the normal of the triangle
-			Vec4<T> line1 = SubtractVectors(transformed.p[1], transformed.p[0]);
-			Vec4<T> line2 = SubtractVectors(transformed.p[2], transformed.p[0]);
-			Vec4<T> normal = UnitVector(CrossProduct(line1, line2));
+	/**
+	 * Fill the pixels in the block x0 to x1, y0 to y1 (inclusive) that are on the inside of every given edge and pass the depth test.
+	 * edgeValues are the edge functions at (x0, y0). edgeSteps & edgeRowSteps are the change in the edge functions from one pixel
+	 * to the next in x & y respectively.
+	 */
+	static void FillHalfSpaceBlock(const RenderBuffer &renderBuffer, uint32_t color, const DepthPlane &depth, int x0, int x1, int y0, int y1, int edgeCount, const int32_t* edgeValues, const int32_t* edgeSteps, const int32_t* edgeRowSteps)
+	{
+		int32_t eRow[3] = { 0 };
+		for (int i = 0; i < edgeCount; i += 1)
+		{
+			eRow[i] = edgeValues[i];
+		}
 
-			Vec4<T> fromCameraToTriangle = SubtractVectors(transformed.p[0], camera.position);
-			T dot = DotProduct(normal, fromCameraToTriangle);
+#if defined(GENTLE_AVX2)
+		__m256 dzdxWide = _mm256_set1_ps(depth.dzdx);
+		__m256 laneOffsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+		__m256i colorWide = _mm256_set1_epi32((int)color);
+		__m256i minusOne = _mm256_set1_epi32(-1);
+		__m256i eRowWide[3];
+		__m256i stepWide[3];
+		__m256i rowStepWide[3];
+		for (int i = 0; i < edgeCount; i += 1)
+		{
+			int32_t s = edgeSteps[i];
+			eRowWide[i] = _mm256_add_epi32(_mm256_set1_epi32(eRow[i]), _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s));
+			stepWide[i] = _mm256_set1_epi32(8 * s);
+			rowStepWide[i] = _mm256_set1_epi32(edgeRowSteps[i]);
+		}
+		const int simdWidth = 8;
+#elif defined(GENTLE_SSE2)
+		__m128 dzdxWide = _mm_set1_ps(depth.dzdx);
+		__m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		__m128i colorWide = _mm_set1_epi32((int)color);
+		__m128i minusOne = _mm_set1_epi32(-1);
+		__m128i eRowWide[3];
+		__m128i stepWide[3];
+		__m128i rowStepWide[3];
+		for (int i = 0; i < edgeCount; i += 1)
+		{
+			int32_t s = edgeSteps[i];
+			eRowWide[i] = _mm_add_epi32(_mm_set1_epi32(eRow[i]), _mm_setr_epi32(0, s, 2 * s, 3 * s));
+			stepWide[i] = _mm_set1_epi32(4 * s);
+			rowStepWide[i] = _mm_set1_epi32(edgeRowSteps[i]);
+		}
+		const int simdWidth = 4;
+#endif
 
-			if (dot >= (T)0)
+		for (int y = y0; y <= y1; y += 1)
+		{
+			int positionOfX0InRow = (renderBuffer.width * y) + x0;
+			uint32_t* pixelRow = (renderBuffer.pixels) ? renderBuffer.pixels + positionOfX0InRow : nullptr;
+			float* depthPointer = renderBuffer.depth + positionOfX0InRow;
+			float rowDepth = GetRowDepth(depth, y);
+			int x = x0;
+
+#if defined(GENTLE_AVX2)
+			__m256i eWide[3];
+			for (int i = 0; i < edgeCount; i += 1)
 			{
-				Vec4<T> lightDirection = { (T)0, (T)0, (T)1 };
-				Vec4<T> normalizedLightDirection = UnitVector(lightDirection);
-				T shade = DotProduct(normal, normalizedLightDirection);
-
-				unsigned int triangleColor = GetColorFromRGB(int(RED * shade), int(GREEN * shade), int(BLUE * shade));
+				eWide[i] = eRowWide[i];
+				eRowWide[i] = _mm256_add_epi32(eRowWide[i], rowStepWide[i]);
+			}
+			__m256 rowDepthWide = _mm256_set1_ps(rowDepth);
 
-				// Convert the triangle position from world space to view space
-				MultiplyVectorWithMatrix(transformed.p[0], viewed.p[0], viewMatrix);
-				MultiplyVectorWithMatrix(transformed.p[1], viewed.p[1], viewMatrix);
-				MultiplyVectorWithMatrix(transformed.p[2], viewed.p[2], viewMatrix);
+			for (; x + simdWidth - 1 <= x1; x += simdWidth)
+			{
+				__m256 xWide = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+				__m256 zWide = _mm256_add_ps(rowDepthWide, _mm256_mul_ps(dzdxWide, xWide));
+				__m256 depthValues = _mm256_loadu_ps(depthPointer);
+				__m256i mask = _mm256_castps_si256(_mm256_cmp_ps(depthValues, zWide, _CMP_LT_OQ));
+				for (int i = 0; i < edgeCount; i += 1)
+				{
+					mask = _mm256_and_si256(mask, _mm256_cmpgt_epi32(eWide[i], minusOne));
+					eWide[i] = _mm256_add_epi32(eWide[i], stepWide[i]);
+				}
 
-				// Clip the triangles before they get projected. Define a plane just in fron of the camera to clip against
-				Triangle4d<T> clipped[2];
-				Plane<T> inFrontOfScreen = { (T)0, (T)0, (T)0.1,	 (T)0, (T)0, (T)1 };
-				int clippedTriangleCount = ClipTriangleAgainstPlane(inFrontOfScreen, viewed, clipped[0], clipped[1]);
+				if (!_mm256_testz_si256(mask, mask))
+				{
+					if (pixelRow)
+					{
+						__m256i* pixelPointer = (__m256i*)(pixelRow + (x - x0));
+						_mm256_storeu_si256(pixelPointer, _mm256_blendv_epi8(_mm256_loadu_si256(pixelPointer), colorWide, mask));
+					}
+					_mm256_storeu_ps(depthPointer, _mm256_blendv_ps(depthValues, zWide, _mm256_castsi256_ps(mask)));
+				}
+				depthPointer += simdWidth;
+			}
+#elif defined(GENTLE_SSE2)
+			__m128i eWide[3];
+			for (int i = 0; i < edgeCount; i += 1)
+			{
+				eWide[i] = eRowWide[i];
+				eRowWide[i] = _mm_add_epi32(eRowWide[i], rowStepWide[i]);
+			}
+			__m128 rowDepthWide = _mm_set1_ps(rowDepth);
 
-				for (int i = 0; i < clippedTriangleCount; i += 1)
+			for (; x + simdWidth - 1 <= x1; x += simdWidth)
+			{
+				__m128 xWide = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+				__m128 zWide = _mm_add_ps(rowDepthWide, _mm_mul_ps(dzdxWide, xWide));
+				__m128 depthValues = _mm_loadu_ps(depthPointer);
+				__m128i mask = _mm_castps_si128(_mm_cmplt_ps(depthValues, zWide));
+				for (int i = 0; i < edgeCount; i += 1)
 				{
-					// Project each triangle in 3D space onto the 2D space triangle to render
-					Project3DPointTo2D(clipped[i].p[0], projected.p[0], projectionMatrix);
-					Project3DPointTo2D(clipped[i].p[1], projected.p[1], projectionMatrix);
-					Project3DPointTo2D(clipped[i].p[2], projected.p[2], projectionMatrix);
+					mask = _mm_and_si128(mask, _mm_cmpgt_epi32(eWide[i], minusOne));
+					eWide[i] = _mm_add_epi32(eWide[i], stepWide[i]);
+				}
 
-					// Scale to view
-					const float sf = 500.0f;
-					Triangle4d<T> triToRender = projected;
-					triToRender.p[0].x *= sf;
-					triToRender.p[0].y *= sf;
-					triToRender.p[1].x *= sf;
-					triToRender.p[1].y *= sf;
-					triToRender.p[2].x *= sf;
-					triToRender.p[2].y *= sf;
+				if (_mm_movemask_epi8(mask) != 0)
+				{
+					if (pixelRow)
+					{
+						__m128i* pixelPointer = (__m128i*)(pixelRow + (x - x0));
+						__m128i blendedPixels = _mm_or_si128(_mm_and_si128(mask, colorWide), _mm_andnot_si128(mask, _mm_loadu_si128(pixelPointer)));
+						_mm_storeu_si128(pixelPointer, blendedPixels);
+					}
 
-					const T translateX = (T)0.5 * (T)renderBuffer.width;
-					const T translateY = (T)0.5 * (T)renderBuffer.height;
-					triToRender.p[0].x += translateX; triToRender.p[0].y += translateY;
-					triToRender.p[1].x += translateX; triToRender.p[1].y += translateY;
-					triToRender.p[2].x += translateX; triToRender.p[2].y += translateY;
+					__m128 maskPs = _mm_castsi128_ps(mask);
+					__m128 blendedDepth = _mm_or_ps(_mm_and_ps(maskPs, zWide), _mm_andnot_ps(maskPs, depthValues));
+					_mm_storeu_ps(depthPointer, blendedDepth);
+				}
+				depthPointer += simdWidth;
+			}
+#endif
 
-					triToRender.color = triangleColor;
+			// Remaining pixels that don't fill a whole SIMD register. Never touch memory outside x0 to x1 since other threads may own it.
+			int32_t e[3] = { 0 };
+			for (int i = 0; i < edgeCount; i += 1)
+			{
+				e[i] = eRow[i] + ((x - x0) * edgeSteps[i]);
+				eRow[i] += edgeRowSteps[i];
+			}
+			for (; x <= x1; x += 1)
+			{
+				bool isInside = true;
+				for (int i = 0; i < edgeCount; i += 1)
+				{
+					isInside = isInside && (e[i] >= 0);
+					e[i] += edgeSteps[i];
+				}
 
-					trianglesToDraw.push_back(triToRender);
+				float z = rowDepth + (depth.dzdx * (float)x);
+				if (isInside && *depthPointer < z)
+				{
+					*depthPointer = z;
+					if (pixelRow)
+					{
+						pixelRow[x - x0] = color;
+					}
 				}
+				depthPointer++;
 			}
 		}
+	}
+
+	/**
+	 * v0, v1 & v2 are sub-pixel positions, i.e. pixel position * SUB_PIXEL_STEP
+	 */
+	static void FillTriangleHalfSpace(const RenderBuffer &renderBuffer, uint32_t color, Vec2<int> v0, Vec2<int> v1, Vec2<int> v2, const DepthPlane &depth, const PixelRect &scissor)
+	{
+		int64_t doubleArea = (((int64_t)v1.x - v0.x) * ((int64_t)v2.y - v0.y)) - (((int64_t)v1.y - v0.y) * ((int64_t)v2.x - v0.x));
+		if (doubleArea == 0)
+		{
+			return;
+		}
+		if (doubleArea < 0)
+		{
+			// Flip the winding so the edge functions are positive on the inside of the triangle
+			std::swap(v1, v2);
+		}
 
-		for (Triangle4d<T> triToRender : trianglesToDraw)
+		// Bounding box of the pixels whose centres can be inside the triangle, limited to the scissor rect
+		const int halfStep = SUB_PIXEL_STEP / 2;
+		int minX = FloorDivide((int64_t)std::min(v0.x, std::min(v1.x, v2.x)) - halfStep + SUB_PIXEL_STEP - 1, SUB_PIXEL_STEP);
+		int maxX = FloorDivide((int64_t)std::max(v0.x, std::max(v1.x, v2.x)) - halfStep, SUB_PIXEL_STEP);
+		int minY = FloorDivide((int64_t)std::min(v0.y, std::min(v1.y, v2.y)) - halfStep + SUB_PIXEL_STEP - 1, SUB_PIXEL_STEP);
+		int maxY = FloorDivide((int64_t)std::max(v0.y, std::max(v1.y, v2.y)) - halfStep, SUB_PIXEL_STEP);
+		minX = std::max(minX, scissor.x0);
+		maxX = std::min(maxX, scissor.x1 - 1);
+		minY = std::max(minY, scissor.y0);
+		maxY = std::min(maxY, scissor.y1 - 1);
+		if (minX > maxX || minY > maxY)
+		{
+			return;
+		}
+		if (IsHiddenByDepthTiles(renderBuffer, minX, minY, maxX, maxY, GetDepthRange(depth, minX, minY, maxX, maxY).max, true))
 		{
-			Triangle4d<T> clipped[2];
-			std::list<Triangle4d<T>> triangleQueue;
-			triangleQueue.push_back(triToRender);
-			int newTriangles = 1;
+			return;
+		}
 
-			// Clip against each screen edge
-			for (int edge = 0; edge < 4; edge += 1)
+		HalfSpaceEdge edges[3] = {
+			MakeHalfSpaceEdge(v0, v1),
+			MakeHalfSpaceEdge(v1, v2),
+			MakeHalfSpaceEdge(v2, v0)
+		};
+
+		// Walk the bounding box in blocks aligned to the block grid. Test the corners of each block first, since the edge
+		// functions are linear that tells us if the block is entirely outside an edge or entirely inside it. Only the
+		// edges that cross a block need testing per pixel. Those have small values inside the block so fit in 32 bits.
+		int blockY0 = FloorDivide(minY, HALF_SPACE_BLOCK_SIZE) * HALF_SPACE_BLOCK_SIZE;
+		int blockX0 = FloorDivide(minX, HALF_SPACE_BLOCK_SIZE) * HALF_SPACE_BLOCK_SIZE;
+		for (int blockY = blockY0; blockY <= maxY; blockY += HALF_SPACE_BLOCK_SIZE)
+		{
+			int y0 = std::max(blockY, minY);
+			int y1 = std::min(blockY + HALF_SPACE_BLOCK_SIZE - 1, maxY);
+			for (int blockX = blockX0; blockX <= maxX; blockX += HALF_SPACE_BLOCK_SIZE)
 			{
-				int trianglesToAdd = 0;
-				while (newTriangles > 0)
+				int x0 = std::max(blockX, minX);
+				int x1 = std::min(blockX + HALF_SPACE_BLOCK_SIZE - 1, maxX);
+
+				int edgeCount = 0;
+				int32_t edgeValues[3];
+				int32_t edgeSteps[3];
+				int32_t edgeRowSteps[3];
+				bool isBlockOutside = false;
+				for (int i = 0; i < 3; i += 1)
+				{
+					int64_t e00 = EvaluateEdge(edges[i], x0, y0);
+					int64_t e10 = EvaluateEdge(edges[i], x1, y0);
+					int64_t e01 = EvaluateEdge(edges[i], x0, y1);
+					int64_t e11 = EvaluateEdge(edges[i], x1, y1);
+					int64_t eMin = std::min(std::min(e00, e10), std::min(e01, e11));
+					int64_t eMax = std::max(std::max(e00, e10), std::max(e01, e11));
+					if (eMax < 0)
+					{
+						isBlockOutside = true;
+						break;
+					}
+					if (eMin < 0)
+					{
+						edgeValues[edgeCount] = (int32_t)e00;
+						edgeSteps[edgeCount] = (int32_t)(edges[i].a * SUB_PIXEL_STEP);
+						edgeRowSteps[edgeCount] = (int32_t)(edges[i].b * SUB_PIXEL_STEP);
+						edgeCount += 1;
+					}
+				}
+
+				if (isBlockOutside)
+				{
+					continue;
+				}
+
+				DepthRange blockDepth = GetDepthRange(depth, x0, y0, x1, y1);
+				if (IsHiddenByDepthTiles(renderBuffer, x0, y0, x1, y1, blockDepth.max, false))
 				{
-					Triangle4d<T> test = triangleQueue.front();
-					triangleQueue.pop_front();
-					newTriangles -= 1;
+					continue;
+				}
 
-					switch (edge)
+				// When the block covers its whole tile and is in front of everything in it, every pixel is going to pass the depth test.
+				// So the colour of a pending clear can be dropped without writing it, and afterwards the tile's depth range is exactly the block's.
+				// The depth test still reads whatever the depth buffer held before the clear though, so that does need clearing.
+				RenderTile* tile = (renderBuffer.tiles) ? GetRenderTile(renderBuffer, blockX / RENDER_TILE_SIZE, blockY / RENDER_TILE_SIZE) : nullptr;
+				bool isTileOverwritten = (tile != nullptr) && (edgeCount == 0) && (x0 == blockX) && (y0 == blockY) &&
+					(x1 == std::min(blockX + RENDER_TILE_SIZE, renderBuffer.width) - 1) && (y1 == std::min(blockY + RENDER_TILE_SIZE, renderBuffer.height) - 1) &&
+					(tile->maxDepth < blockDepth.min);
+				if (isTileOverwritten)
+				{
+					if (tile->isClearPending)
 					{
-						case 0:
-						{
-							trianglesToAdd = ClipTriangleAgainstPlane(bottomOfScreen, test, clipped[0], clipped[1]);
-							break;
-						}
-						case 1:
-						{
-							trianglesToAdd = ClipTriangleAgainstPlane(topOfScreen, test, clipped[0], clipped[1]);
-							break;
-						}
-						case 2:
-						{
-							trianglesToAdd = ClipTriangleAgainstPlane(leftOfScreen, test, clipped[0], clipped[1]);
-							break;
-						}
-						case 3:
+						for (int y = y0; y <= y1; y += 1)
 						{
-							trianglesToAdd = ClipTriangleAgainstPlane(rightOfScreen, test, clipped[0], clipped[1]);
-							break;
+							FillRow(renderBuffer.depth + (renderBuffer.width * y) + x0, 0.0f, x1 - x0 + 1, false);
 						}
 					}
+					tile->isClearPending = false;
+				}
+				else
+				{
+					ResolvePendingClears(renderBuffer, x0, y0, x1, y1);
+				}
+
+				FillHalfSpaceBlock(renderBuffer, color, depth, x0, x1, y0, y1, edgeCount, edgeValues, edgeSteps, edgeRowSteps);
+
+				if (isTileOverwritten)
+				{
+					tile->minDepth = blockDepth.min;
+					tile->maxDepth = blockDepth.max;
+					tile->isMinDepthStale = false;
+				}
+				else
+				{
+					MarkDepthTilesWritten(renderBuffer, x0, y0, x1, y1, blockDepth.max);
+				}
+			}
+		}
+	}
+
+	static Vec2<int> SnapToSubPixel(const Vec3<int> &pixel)
+	{
+		// Integer pixel ordinals are treated as the centre of that pixel
+		return Vec2<int> { (pixel.x * SUB_PIXEL_STEP) + (SUB_PIXEL_STEP / 2), (pixel.y * SUB_PIXEL_STEP) + (SUB_PIXEL_STEP / 2) };
+	}
+
+	static Vec2<int> SnapToSubPixel(const Vec2<float> &position)
+	{
+		return Vec2<int> { (int)floorf((position.x * (float)SUB_PIXEL_STEP) + 0.5f), (int)floorf((position.y * (float)SUB_PIXEL_STEP) + 0.5f) };
+	}
+
+	void FillTriangleHalfSpace(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z)
+	{
+		PixelRect scissor = GetTriangleScissor(renderBuffer, p0, p1, p2);
+		FillTriangleHalfSpace(renderBuffer, color, SnapToSubPixel(p0), SnapToSubPixel(p1), SnapToSubPixel(p2), MakeConstantDepthPlane(z), scissor);
+	}
+
+	void FillTriangleHalfSpace(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z0, float z1, float z2)
+	{
+		PixelRect scissor = GetTriangleScissor(renderBuffer, p0, p1, p2);
+		DepthPlane depth = MakeDepthPlane(GetPixelCentre(p0), GetPixelCentre(p1), GetPixelCentre(p2), z0, z1, z2);
+		FillTriangleHalfSpace(renderBuffer, color, SnapToSubPixel(p0), SnapToSubPixel(p1), SnapToSubPixel(p2), depth, scissor);
+	}
+
+	void DrawTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec2<int> &p0, const Vec2<int> &p1, const Vec2<int> &p2)
+	{
+		DrawLineInPixels(renderBuffer, color, p0, p1);
+		DrawLineInPixels(renderBuffer, color, p1, p2);
+		DrawLineInPixels(renderBuffer, color, p2, p0);
+	}
+
+	// Clear only the pixels inside rect. Tiles it covers part of get their deferred clear carried out first, so the rest of them survives
+	static void ClearRect(const RenderBuffer &renderBuffer, uint32_t color, const PixelRect &rect)
+	{
+		if (IsPixelRectEmpty(rect))
+		{
+			return;
+		}
+
+		ResolvePendingClears(renderBuffer, rect.x0, rect.y0, rect.x1 - 1, rect.y1 - 1);
+		for (int y = rect.y0; y < rect.y1; y += 1)
+		{
+			int positionOfX0InRow = (renderBuffer.width * y) + rect.x0;
+			if (renderBuffer.pixels)
+			{
+				FillRow(renderBuffer.pixels + positionOfX0InRow, color, rect.x1 - rect.x0, false);
+			}
+			FillRow(renderBuffer.depth + positionOfX0InRow, 0.0f, rect.x1 - rect.x0, false);
+		}
+
+		// Some pixels of each tile touched are now infinitely far away. maxDepth only has to be an upper bound, so it can stay
+		if (renderBuffer.tiles)
+		{
+			for (int tileY = rect.y0 / RENDER_TILE_SIZE; tileY <= (rect.y1 - 1) / RENDER_TILE_SIZE; tileY += 1)
+			{
+				for (int tileX = rect.x0 / RENDER_TILE_SIZE; tileX <= (rect.x1 - 1) / RENDER_TILE_SIZE; tileX += 1)
+				{
+					RenderTile* tile = GetRenderTile(renderBuffer, tileX, tileY);
+					tile->minDepth = 0.0f;
+					tile->isMinDepthStale = false;
+				}
+			}
+		}
+	}
+
+	void ClearScreen(const RenderBuffer &renderBuffer, uint32_t color)
+	{
+		PixelRect scissor = GetScissor(renderBuffer);
+		MarkDirty(renderBuffer, scissor);
+		if (!IsWholeBuffer(renderBuffer, scissor))
+		{
+			ClearRect(renderBuffer, color, scissor);
+			return;
+		}
+
+		// Every cache line of the buffers gets overwritten, so use streaming stores rather than reading each one in first
+		int pixelCount = renderBuffer.width * renderBuffer.height;
+		if (renderBuffer.pixels)
+		{
+			FillRow(renderBuffer.pixels, color, pixelCount, true);
+		}
+		FillRow(renderBuffer.depth, 0.0f, pixelCount, true);
+		StoreFence();
+
+		if (renderBuffer.tiles)
+		{
+			int tileCount = ((renderBuffer.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE) * ((renderBuffer.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE);
+			for (int i = 0; i < tileCount; i += 1)
+			{
+				renderBuffer.tiles[i].minDepth = 0.0f;
+				renderBuffer.tiles[i].maxDepth = 0.0f;
+				renderBuffer.tiles[i].isMinDepthStale = false;
+				renderBuffer.tiles[i].isClearPending = false;
+			}
+		}
+	}
+
+	void ClearScreenDeferred(const RenderBuffer &renderBuffer, uint32_t color)
+	{
+		if (!renderBuffer.tiles || !IsWholeBuffer(renderBuffer, GetScissor(renderBuffer)))
+		{
+			ClearScreen(renderBuffer, color);
+			return;
+		}
+
+		MarkDirty(renderBuffer, GetScissor(renderBuffer));
+		int tileCount = ((renderBuffer.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE) * ((renderBuffer.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE);
+		for (int i = 0; i < tileCount; i += 1)
+		{
+			renderBuffer.tiles[i].minDepth = 0.0f;
+			renderBuffer.tiles[i].maxDepth = 0.0f;
+			renderBuffer.tiles[i].isMinDepthStale = false;
+			renderBuffer.tiles[i].isClearPending = true;
+			renderBuffer.tiles[i].clearColor = color;
+		}
+	}
+
+	void ResolveDeferredClear(const RenderBuffer &renderBuffer)
+	{
+		if (!renderBuffer.tiles)
+		{
+			return;
+		}
+
+		int tileCountX = (renderBuffer.width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+		int tileCountY = (renderBuffer.height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+		for (int tileY = 0; tileY < tileCountY; tileY += 1)
+		{
+			RenderTile* rowOfTiles = GetRenderTile(renderBuffer, 0, tileY);
+			int tileX = 0;
+			while (tileX < tileCountX)
+			{
+				if (!rowOfTiles[tileX].isClearPending)
+				{
+					tileX += 1;
+					continue;
+				}
+
+				// Clear neighbouring tiles with the same color together so the streaming stores write whole cache lines
+				uint32_t color = rowOfTiles[tileX].clearColor;
+				int runEnd = tileX + 1;
+				while (runEnd < tileCountX && rowOfTiles[runEnd].isClearPending && rowOfTiles[runEnd].clearColor == color)
+				{
+					runEnd += 1;
+				}
 
-					for (int i = 0; i < trianglesToAdd; i += 1)
+				int x0 = tileX * RENDER_TILE_SIZE;
+				int x1 = std::min(runEnd * RENDER_TILE_SIZE, renderBuffer.width);
+				int y0 = tileY * RENDER_TILE_SIZE;
+				int y1 = std::min(y0 + RENDER_TILE_SIZE, renderBuffer.height);
+				for (int y = y0; y < y1; y += 1)
+				{
+					int positionOfX0InRow = (renderBuffer.width * y) + x0;
+					if (renderBuffer.pixels)
 					{
-						triangleQueue.push_back(clipped[i]);
+						FillRow(renderBuffer.pixels + positionOfX0InRow, color, x1 - x0, true);
 					}
+					FillRow(renderBuffer.depth + positionOfX0InRow, 0.0f, x1 - x0, true);
+				}
+
+				for (; tileX < runEnd; tileX += 1)
+				{
+					rowOfTiles[tileX].isClearPending = false;
+				}
+			}
+		}
+		StoreFence();
+	}
+
+	unsigned int GetColorFromRGB(int red, int green, int blue)
+	{
+		// Use bitwise operators to construct a single uint32_t value from three 0-255 RGB values.
+		// There are 32 bits to fill up.
+		// Each 0-255 value is a single byte, or 8 bits. So the 32 bits will be split into 4 segments (32 bits / 8 bits = 4).
+		// |--1--|--2--|--3--|--4--|	bytes
+		// 1     8     16    24    32	bits
+		//
+		// So the 0xRRGGBB value is made by constructing:
+		// 1. the RR value and shifting it 16 places to the left
+		//		|00|00|00|RR|	--> |00|RR|00|00|
+		// 2. the GG value and shifting it 8 places to the left
+		//		|00|00|00|GG|	-->	|00|00|GG|00|
+		// 3. the BB value
+		//							|00|00|00|BB|
+		// Adding these together gives us the 0xRRGGBB value:
+		//		|0x|00|00|00| + |00|RR|00|00| + |00|00|GG|00| + |00|00|00|BB| = |0x|RR|GG|BB|
+		uint32_t color = (uint32_t)(0x000000 + (red << 16) + (green << 8) + blue);
+		return (unsigned int)color;
+	}
+
+	struct ScreenTriangle
+	{
+		Vec2<float> p[3];	// position in pixels. The scanline fill rounds these down to pixel ordinals, the half-space fill snaps them to sub-pixels
+		DepthPlane depth;
+		uint32_t color;
+	};
+
+	static void FillScreenTriangle(const RenderBuffer &renderBuffer, const ScreenTriangle &tri, FillEngine fillEngine, const PixelRect &scissor)
+	{
+		if (fillEngine == FILL_ENGINE_HALF_SPACE)
+		{
+			FillTriangleHalfSpace(renderBuffer, tri.color, SnapToSubPixel(tri.p[0]), SnapToSubPixel(tri.p[1]), SnapToSubPixel(tri.p[2]), tri.depth, scissor);
+		}
+		else
+		{
+			Vec3<int> p0 = { (int)floorf(tri.p[0].x), (int)floorf(tri.p[0].y), 0 };
+			Vec3<int> p1 = { (int)floorf(tri.p[1].x), (int)floorf(tri.p[1].y), 0 };
+			Vec3<int> p2 = { (int)floorf(tri.p[2].x), (int)floorf(tri.p[2].y), 0 };
+			FillTriangleInPixels(renderBuffer, tri.color, p0, p1, p2, tri.depth, scissor);
+		}
+	}
+
+	/**
+	 * Fill every triangle in the bin whose bounds overlap the tile, in the order they were submitted.
+	 * The tile acts as a scissor rect so only the pixels owned by the tile get written to.
+	 */
+	static void RasterizeTile(const RenderBuffer &renderBuffer, const std::vector<ScreenTriangle> &triangles, const int* bin, int binSize, FillEngine fillEngine, const PixelRect &tile)
+	{
+		for (int i = 0; i < binSize; i += 1)
+		{
+			FillScreenTriangle(renderBuffer, triangles[bin[i]], fillEngine, tile);
+		}
+	}
+
+	// Range of tiles, inclusive, that the bounding box of the triangle overlaps
+	static PixelRect GetTriangleTiles(const ScreenTriangle &tri, int tileSize, int tileCountX, int tileCountY)
+	{
+		int minX = (int)floorf(std::min(tri.p[0].x, std::min(tri.p[1].x, tri.p[2].x)));
+		int maxX = (int)floorf(std::max(tri.p[0].x, std::max(tri.p[1].x, tri.p[2].x)));
+		int minY = (int)floorf(std::min(tri.p[0].y, std::min(tri.p[1].y, tri.p[2].y)));
+		int maxY = (int)floorf(std::max(tri.p[0].y, std::max(tri.p[1].y, tri.p[2].y)));
+
+		PixelRect tiles;
+		tiles.x0 = ClampInt(0, minX / tileSize, tileCountX - 1);
+		tiles.x1 = ClampInt(0, maxX / tileSize, tileCountX - 1);
+		tiles.y0 = ClampInt(0, minY / tileSize, tileCountY - 1);
+		tiles.y1 = ClampInt(0, maxY / tileSize, tileCountY - 1);
+		return tiles;
+	}
+
+	/**
+	 * Sort-middle rasterization. Each triangle is binned into every screen tile its bounding box overlaps,
+	 * then the calling thread & the workers of settings.threadPool take turns grabbing the next unclaimed tile and fill its bin.
+	 * A pixel belongs to exactly one tile and each bin keeps the submission order of the triangles, so the
+	 * output is deterministic and matches filling all the triangles in order on a single thread.
+	 * The bins are counted first, then packed one after another into a single array in settings.scratchArena when there is one.
+	 */
+	static void RasterizeTriangles(const RenderBuffer &renderBuffer, const std::vector<ScreenTriangle> &triangles, const RenderSettings &settings)
+	{
+		PixelRect scissor = GetScissor(renderBuffer);
+		if (renderBuffer.dirtyRegion && !triangles.empty())
+		{
+			// One rect around every triangle is far cheaper to track than a rect per triangle, & meshes are rarely sparse
+			PixelRect bounds = { INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+			for (const ScreenTriangle &tri : triangles)
+			{
+				for (const Vec2<float> &p : tri.p)
+				{
+					bounds.x0 = std::min(bounds.x0, (int)floorf(p.x));
+					bounds.y0 = std::min(bounds.y0, (int)floorf(p.y));
+					bounds.x1 = std::max(bounds.x1, (int)floorf(p.x) + 1);
+					bounds.y1 = std::max(bounds.y1, (int)floorf(p.y) + 1);
+				}
+			}
+			MarkDirty(renderBuffer, IntersectPixelRects(scissor, bounds));
+		}
+
+		if (!settings.threadPool || GetThreadPoolWorkerCount(*settings.threadPool) == 0 || settings.tileSize <= 0)
+		{
+			for (const ScreenTriangle &tri : triangles)
+			{
+				FillScreenTriangle(renderBuffer, tri, settings.fillEngine, scissor);
+			}
+			return;
+		}
+
+		// Round the tiles up to a whole number of render tiles so no two threads ever update the same render tile
+		const int tileSize = ((settings.tileSize + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE) * RENDER_TILE_SIZE;
+		const int tileCountX = (renderBuffer.width + tileSize - 1) / tileSize;
+		const int tileCountY = (renderBuffer.height + tileSize - 1) / tileSize;
+		const int tileCount = tileCountX * tileCountY;
+
+		ScopedArenaMark scratch(settings.scratchArena);
+		ArenaAllocator<int> allocator(settings.scratchArena);
+
+		// binStarts[tile] is where the tile's bin starts in binnedTriangles, & binStarts[tile + 1] where it ends
+		std::vector<int, ArenaAllocator<int>> binStarts(tileCount + 1, 0, allocator);
+		for (const ScreenTriangle &tri : triangles)
+		{
+			PixelRect tiles = GetTriangleTiles(tri, tileSize, tileCountX, tileCountY);
+			for (int tileY = tiles.y0; tileY <= tiles.y1; tileY += 1)
+			{
+				for (int tileX = tiles.x0; tileX <= tiles.x1; tileX += 1)
+				{
+					binStarts[(tileY * tileCountX) + tileX + 1] += 1;
 				}
+			}
+		}
+		for (int tileIndex = 0; tileIndex < tileCount; tileIndex += 1)
+		{
+			binStarts[tileIndex + 1] += binStarts[tileIndex];
+		}
 
-				newTriangles = (int)triangleQueue.size();
+		std::vector<int, ArenaAllocator<int>> binnedTriangles(binStarts[tileCount], 0, allocator);
+		std::vector<int, ArenaAllocator<int>> binEnds(binStarts.begin(), binStarts.end() - 1, allocator);
+		for (int i = 0; i < (int)triangles.size(); i += 1)
+		{
+			PixelRect tiles = GetTriangleTiles(triangles[i], tileSize, tileCountX, tileCountY);
+			for (int tileY = tiles.y0; tileY <= tiles.y1; tileY += 1)
+			{
+				for (int tileX = tiles.x0; tileX <= tiles.x1; tileX += 1)
+				{
+					int tileIndex = (tileY * tileCountX) + tileX;
+					binnedTriangles[binEnds[tileIndex]] = i;
+					binEnds[tileIndex] += 1;
+				}
 			}
+		}
 
-			for (Triangle4d<T> draw : triangleQueue)
+		std::atomic<int> nextTile(0);
+		auto worker = [&]()
+		{
+			// Pool workers start out untagged, so anything they allocate wouldn't count as rendering otherwise
+			GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_RENDER);
+			for (int tileIndex = nextTile++; tileIndex < tileCount; tileIndex = nextTile++)
 			{
-				// Vec2<int> p0Int = { (int)draw.p[0].x, (int)draw.p[0].y };
-				// Vec2<int> p1Int = { (int)draw.p[1].x, (int)draw.p[1].y };
-				// Vec2<int> p2Int = { (int)draw.p[2].x, (int)draw.p[2].y };
-				// DrawTriangleInPixels(renderBuffer, draw.color, p0Int, p1Int, p2Int);
+				int binSize = binStarts[tileIndex + 1] - binStarts[tileIndex];
+				if (binSize == 0)
+				{
+					continue;
+				}
+
+				int tileX = tileIndex % tileCountX;
+				int tileY = tileIndex / tileCountX;
+				PixelRect tile;
+				tile.x0 = tileX * tileSize;
+				tile.y0 = tileY * tileSize;
+				tile.x1 = std::min(tile.x0 + tileSize, renderBuffer.width);
+				tile.y1 = std::min(tile.y0 + tileSize, renderBuffer.height);
+				tile = IntersectPixelRects(tile, scissor);
+				if (IsPixelRectEmpty(tile))
+				{
+					continue;
+				}
+				RasterizeTile(renderBuffer, triangles, binnedTriangles.data() + binStarts[tileIndex], binSize, settings.fillEngine, tile);
+			}
+		};
+
+		// The calling thread rasterizes tiles too, so one fewer worker than tiles is enough to keep every tile busy
+		RunOnThreadPool(*settings.threadPool, tileCount - 1, worker);
+	}
+
+	/**
+	 * Clipping
+	 *
+	 * Triangles get clipped once, in homogeneous clip space after the projection matrix and before the perspective divide.
+	 * Each vertex gets an outcode with a bit set for every plane it's outside of. A triangle with all three vertices outside
+	 * the same plane is thrown away, a triangle with no vertices outside any clip plane is kept as it is, and only the few
+	 * straddling a clip plane get clipped, into a convex polygon that is then fanned into triangles.
+	 *
+	 * The fill routines scissor to the screen themselves, so x & y are clipped to a guard band GUARD_BAND_SIZE pixels beyond
+	 * each edge of the screen rather than to the screen edges. That keeps the sub-pixel positions & edge functions of
+	 * FillTriangleHalfSpace comfortably inside their integer ranges and keeps the scanline fill from walking edges far off the
+	 * screen, while hardly any triangles are big enough to need clipping. The screen edges still get outcode bits, but only
+	 * to throw away triangles that are entirely off one side of the screen.
+	 */
+	static const int GUARD_BAND_SIZE = 4096;
+	static const int VIEWPORT_SCALE = 500;	// Pixels per unit of normalized device co-ordinates
 
-				Vec3<int> p0Int = { (int)draw.p[0].x, (int)draw.p[0].y };
-				Vec3<int> p1Int = { (int)draw.p[1].x, (int)draw.p[1].y };
-				Vec3<int> p2Int = { (int)draw.p[2].x, (int)draw.p[2].y };
+	enum ClipPlane
+	{
+		CLIP_PLANE_GUARD_BAND_LEFT,
+		CLIP_PLANE_GUARD_BAND_RIGHT,
+		CLIP_PLANE_GUARD_BAND_BOTTOM,
+		CLIP_PLANE_GUARD_BAND_TOP,
+		CLIP_PLANE_NEAR,
+		CLIP_PLANE_FAR,
+		CLIP_PLANE_SCREEN_LEFT,
+		CLIP_PLANE_SCREEN_RIGHT,
+		CLIP_PLANE_SCREEN_BOTTOM,
+		CLIP_PLANE_SCREEN_TOP,
+
+		CLIP_PLANE_COUNT
+	};
+
+	static const int CLIPPING_PLANE_COUNT = CLIP_PLANE_FAR + 1;	// Planes that triangles actually get clipped against
+	static const uint32_t CLIPPING_PLANES_MASK = (1u << CLIPPING_PLANE_COUNT) - 1;
+	static const int MAX_CLIPPED_POLYGON_POINTS = 3 + CLIPPING_PLANE_COUNT;	// Each plane can add at most one point to a convex polygon
 
-				// Super rough, take the depth as the average z value
-				// For whatever reason, the z values are inverted for the teapot. i.e. closer triangles have a lower Z value.
-				// As an ultra-hack I'm doing 10 minus the z-value to invert them.
-				T z = (T)10 - ((draw.p[0].z + draw.p[1].z + draw.p[2].z) / (T)3);
-				FillTriangleInPixels(renderBuffer, draw.color, p0Int, p1Int, p2Int, z);
+	template<typename T>
+	static uint32_t GetOutcode(const Vec4<T> &point, const Vec4<T> (&planes)[CLIP_PLANE_COUNT])
+	{
+		uint32_t outcode = 0;
+		for (int i = 0; i < CLIP_PLANE_COUNT; i += 1)
+		{
+			const Vec4<T> &plane = planes[i];
+			T distance = (plane.x * point.x) + (plane.y * point.y) + (plane.z * point.z) + (plane.w * point.w);
+			if (distance < (T)0)
+			{
+				outcode |= (1u << i);
 			}
 		}
+		return outcode;
+	}
+
+	/**
+	 * Where each clip space vertex ends up, worked out for every vertex in SIMD batches before any triangle is looked at.
+	 * The screen position & depth only mean something for vertices without any CLIPPING_PLANES_MASK outcode bits set,
+	 * which is all that triangles that don't need clipping are made of.
+	 */
+	struct ProjectedVertices
+	{
+		std::vector<uint32_t> outcodes;
+		std::vector<float> screenX;
+		std::vector<float> screenY;
+		std::vector<float> depth;
+	};
+
+	// Only projects vertices first to first + count - 1, though projected gets resized to match clipVertices
+	static void ProjectVertices(const VertexStream<float> &clipVertices, size_t first, size_t count, const Vec4<float> (&planes)[CLIP_PLANE_COUNT], float viewportScale, float translateX, float translateY, float nearPlane, ProjectedVertices &projected)
+	{
+		size_t size = clipVertices.x.size();
+		projected.outcodes.resize(size);
+		projected.screenX.resize(size);
+		projected.screenY.resize(size);
+		projected.depth.resize(size);
+		size_t end = first + count;
+
+		size_t i = first;
+#if defined(GENTLE_AVX2) || defined(GENTLE_SSE2)
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(clipVertices.x.data() + i);
+			__m128 y = _mm_loadu_ps(clipVertices.y.data() + i);
+			__m128 z = _mm_loadu_ps(clipVertices.z.data() + i);
+			__m128 w = _mm_loadu_ps(clipVertices.w.data() + i);
+
+			__m128i outcode = _mm_setzero_si128();
+			for (int plane = 0; plane < CLIP_PLANE_COUNT; plane += 1)
+			{
+				const Vec4<float> &p = planes[plane];
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x), x), _mm_mul_ps(_mm_set1_ps(p.y), y)), _mm_mul_ps(_mm_set1_ps(p.z), z)), _mm_mul_ps(_mm_set1_ps(p.w), w));
+				__m128i isOutside = _mm_castps_si128(_mm_cmplt_ps(distance, zero));
+				outcode = _mm_or_si128(outcode, _mm_and_si128(isOutside, _mm_set1_epi32(1 << plane)));
+			}
+			_mm_storeu_si128((__m128i*)(projected.outcodes.data() + i), outcode);
+
+			_mm_storeu_ps(projected.screenX.data() + i, _mm_add_ps(_mm_mul_ps(_mm_div_ps(x, w), _mm_set1_ps(viewportScale)), _mm_set1_ps(translateX)));
+			_mm_storeu_ps(projected.screenY.data() + i, _mm_add_ps(_mm_mul_ps(_mm_div_ps(y, w), _mm_set1_ps(viewportScale)), _mm_set1_ps(translateY)));
+			_mm_storeu_ps(projected.depth.data() + i, _mm_div_ps(_mm_set1_ps(nearPlane), w));
+		}
+#endif
+		for (; i < end; i += 1)
+		{
+			Vec4<float> p = { clipVertices.x[i], clipVertices.y[i], clipVertices.z[i], clipVertices.w[i] };
+			projected.outcodes[i] = GetOutcode(p, planes);
+			projected.screenX[i] = ((p.x / p.w) * viewportScale) + translateX;
+			projected.screenY[i] = ((p.y / p.w) * viewportScale) + translateY;
+			projected.depth[i] = nearPlane / p.w;
+		}
+	}
+
+	static uint32_t GetTriangleVertex(const uint32_t* indices, size_t triangle, int corner)
+	{
+		size_t index = (triangle * 3) + corner;
+		return indices ? indices[index] : (uint32_t)index;
+	}
+
+	/**
+	 * Determinant of the clip space x, y & w of the three corners. It's the screen space signed area of the triangle scaled
+	 * by w0 * w1 * w2, so it gives the winding without a perspective divide, even for triangles that cross the near plane.
+	 */
+	static float GetClipSpaceDeterminant(const float (&x)[3], const float (&y)[3], const float (&w)[3])
+	{
+		return (x[0] * ((y[1] * w[2]) - (w[1] * y[2]))) - (y[0] * ((x[1] * w[2]) - (w[1] * x[2]))) + (w[0] * ((x[1] * y[2]) - (y[1] * x[2])));
+	}
+
+	// Whether the screen triangle misses every pixel centre FillTriangleHalfSpace would sample, going by its bounding box
+	static bool CoversNoPixelCentres(const float (&screenX)[3], const float (&screenY)[3])
+	{
+		Vec2<int> min = SnapToSubPixel(Vec2<float>{ std::min(screenX[0], std::min(screenX[1], screenX[2])), std::min(screenY[0], std::min(screenY[1], screenY[2])) });
+		Vec2<int> max = SnapToSubPixel(Vec2<float>{ std::max(screenX[0], std::max(screenX[1], screenX[2])), std::max(screenY[0], std::max(screenY[1], screenY[2])) });
+		const int halfStep = SUB_PIXEL_STEP / 2;
+		int firstX = FloorDivide((int64_t)min.x - halfStep + SUB_PIXEL_STEP - 1, SUB_PIXEL_STEP);
+		int lastX = FloorDivide((int64_t)max.x - halfStep, SUB_PIXEL_STEP);
+		int firstY = FloorDivide((int64_t)min.y - halfStep + SUB_PIXEL_STEP - 1, SUB_PIXEL_STEP);
+		int lastY = FloorDivide((int64_t)max.y - halfStep, SUB_PIXEL_STEP);
+		return (firstX > lastX) || (firstY > lastY);
+	}
+
+	static void AddTriangleIfVisible(uint32_t triangle, uint32_t outcodeAnd, uint32_t outcodeOr, bool isDegenerate, bool isBackFacing, bool coversNoPixelCentres, bool cullMissingSamples, std::vector<uint32_t> &visibleTriangles, RenderStats &stats)
+	{
+		if (outcodeAnd != 0)
+		{
+			stats.trianglesOutside += 1;
+		}
+		else if (isDegenerate)
+		{
+			stats.trianglesDegenerate += 1;
+		}
+		else if (isBackFacing)
+		{
+			stats.trianglesBackFacing += 1;
+		}
+		else if (cullMissingSamples && ((outcodeOr & CLIPPING_PLANES_MASK) == 0) && coversNoPixelCentres)
+		{
+			stats.trianglesMissingSamples += 1;
+		}
+		else
+		{
+			visibleTriangles.push_back(triangle);
+		}
+	}
+
+#if defined(GENTLE_AVX2) || defined(GENTLE_SSE2)
+	// floor for values that fit in an int, without needing SSE4.1
+	static __m128 FloorPs(__m128 value)
+	{
+		__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+	}
+
+	// SIMD version of SnapToSubPixel followed by the FloorDivide in CoversNoPixelCentres. first is true for the minimum
+	static __m128i GetPixelCentreOrdinals(__m128 position, bool first)
+	{
+		__m128i snapped = _mm_cvttps_epi32(FloorPs(_mm_add_ps(_mm_mul_ps(position, _mm_set1_ps((float)SUB_PIXEL_STEP)), _mm_set1_ps(0.5f))));
+		int offset = first ? (SUB_PIXEL_STEP - 1 - (SUB_PIXEL_STEP / 2)) : -(SUB_PIXEL_STEP / 2);
+		return _mm_srai_epi32(_mm_add_epi32(snapped, _mm_set1_epi32(offset)), SUB_PIXEL_BITS);
+	}
+#endif
+
+	/**
+	 * Culling stage. Runs over triangles firstTriangle to firstTriangle + triangleCount - 1 in SIMD batches, before any
+	 * clipping or triangle setup, and appends the ones worth filling to visibleTriangles. Triangles get thrown away when all their vertices are outside the same clip plane,
+	 * when they have no area, when they face away from the camera, and when cullMissingSamples is set & they're too small or
+	 * thin to cover a single pixel centre.
+	 * orientation is 1 or -1, whichever makes orientation * GetClipSpaceDeterminant negative for triangles facing away.
+	 */
+	static void CullTriangles(const VertexStream<float> &clipVertices, const ProjectedVertices &projected, const uint32_t* indices, size_t firstTriangle, size_t triangleCount, float orientation, bool cullMissingSamples, std::vector<uint32_t> &visibleTriangles, RenderStats &stats)
+	{
+		size_t end = firstTriangle + triangleCount;
+		size_t triangle = firstTriangle;
+#if defined(GENTLE_AVX2) || defined(GENTLE_SSE2)
+		const int LANES = 4;
+		const __m128 zero = _mm_setzero_ps();
+		for (; triangle + LANES <= end; triangle += LANES)
+		{
+			// Gather the corners of LANES triangles into one register per corner & component
+			alignas(16) float x[3][LANES];
+			alignas(16) float y[3][LANES];
+			alignas(16) float w[3][LANES];
+			alignas(16) float screenX[3][LANES];
+			alignas(16) float screenY[3][LANES];
+			uint32_t outcodeAnd[LANES];
+			uint32_t outcodeOr[LANES];
+			for (int lane = 0; lane < LANES; lane += 1)
+			{
+				outcodeAnd[lane] = ~0u;
+				outcodeOr[lane] = 0;
+				for (int corner = 0; corner < 3; corner += 1)
+				{
+					uint32_t vertex = GetTriangleVertex(indices, triangle + lane, corner);
+					x[corner][lane] = clipVertices.x[vertex];
+					y[corner][lane] = clipVertices.y[vertex];
+					w[corner][lane] = clipVertices.w[vertex];
+					screenX[corner][lane] = projected.screenX[vertex];
+					screenY[corner][lane] = projected.screenY[vertex];
+					outcodeAnd[lane] &= projected.outcodes[vertex];
+					outcodeOr[lane] |= projected.outcodes[vertex];
+				}
+			}
+
+			__m128 x0 = _mm_load_ps(x[0]), x1 = _mm_load_ps(x[1]), x2 = _mm_load_ps(x[2]);
+			__m128 y0 = _mm_load_ps(y[0]), y1 = _mm_load_ps(y[1]), y2 = _mm_load_ps(y[2]);
+			__m128 w0 = _mm_load_ps(w[0]), w1 = _mm_load_ps(w[1]), w2 = _mm_load_ps(w[2]);
+			__m128 determinant = _mm_add_ps(
+				_mm_sub_ps(
+					_mm_mul_ps(x0, _mm_sub_ps(_mm_mul_ps(y1, w2), _mm_mul_ps(w1, y2))),
+					_mm_mul_ps(y0, _mm_sub_ps(_mm_mul_ps(x1, w2), _mm_mul_ps(w1, x2)))),
+				_mm_mul_ps(w0, _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(y1, x2))));
+			determinant = _mm_mul_ps(determinant, _mm_set1_ps(orientation));
+			int degenerateMask = _mm_movemask_ps(_mm_cmpeq_ps(determinant, zero));
+			int backFacingMask = _mm_movemask_ps(_mm_cmplt_ps(determinant, zero));
+
+			__m128 sx0 = _mm_load_ps(screenX[0]), sx1 = _mm_load_ps(screenX[1]), sx2 = _mm_load_ps(screenX[2]);
+			__m128 sy0 = _mm_load_ps(screenY[0]), sy1 = _mm_load_ps(screenY[1]), sy2 = _mm_load_ps(screenY[2]);
+			__m128i firstX = GetPixelCentreOrdinals(_mm_min_ps(sx0, _mm_min_ps(sx1, sx2)), true);
+			__m128i lastX = GetPixelCentreOrdinals(_mm_max_ps(sx0, _mm_max_ps(sx1, sx2)), false);
+			__m128i firstY = GetPixelCentreOrdinals(_mm_min_ps(sy0, _mm_min_ps(sy1, sy2)), true);
+			__m128i lastY = GetPixelCentreOrdinals(_mm_max_ps(sy0, _mm_max_ps(sy1, sy2)), false);
+			__m128i isEmpty = _mm_or_si128(_mm_cmpgt_epi32(firstX, lastX), _mm_cmpgt_epi32(firstY, lastY));
+			int noPixelCentresMask = _mm_movemask_ps(_mm_castsi128_ps(isEmpty));
+
+			for (int lane = 0; lane < LANES; lane += 1)
+			{
+				int bit = 1 << lane;
+				AddTriangleIfVisible((uint32_t)(triangle + lane), outcodeAnd[lane], outcodeOr[lane], (degenerateMask & bit) != 0, (backFacingMask & bit) != 0, (noPixelCentresMask & bit) != 0, cullMissingSamples, visibleTriangles, stats);
+			}
+		}
+#endif
+		for (; triangle < end; triangle += 1)
+		{
+			float x[3], y[3], w[3], screenX[3], screenY[3];
+			uint32_t outcodeAnd = ~0u;
+			uint32_t outcodeOr = 0;
+			for (int corner = 0; corner < 3; corner += 1)
+			{
+				uint32_t vertex = GetTriangleVertex(indices, triangle, corner);
+				x[corner] = clipVertices.x[vertex];
+				y[corner] = clipVertices.y[vertex];
+				w[corner] = clipVertices.w[vertex];
+				screenX[corner] = projected.screenX[vertex];
+				screenY[corner] = projected.screenY[vertex];
+				outcodeAnd &= projected.outcodes[vertex];
+				outcodeOr |= projected.outcodes[vertex];
+			}
+
+			float determinant = orientation * GetClipSpaceDeterminant(x, y, w);
+			bool coversNoPixelCentres = ((outcodeOr & CLIPPING_PLANES_MASK) == 0) && CoversNoPixelCentres(screenX, screenY);
+			AddTriangleIfVisible((uint32_t)triangle, outcodeAnd, outcodeOr, determinant == 0.0f, determinant < 0.0f, coversNoPixelCentres, cullMissingSamples, visibleTriangles, stats);
+		}
+	}
+
+	template<typename T>
+	static unsigned int GetShadedColor(const Vec4<T> &unitNormal, const Vec4<T> &unitLightDirection)
+	{
+		const int RED = 0;
+		const int GREEN = 255;
+		const int BLUE = 0;
+
+		T shade = DotProduct(unitNormal, unitLightDirection);
+		return GetColorFromRGB(int(RED * shade), int(GREEN * shade), int(BLUE * shade));
+	}
+
+	template<typename T>
+	static Vec4<T> GetUnitLightDirection(const RenderSettings &settings)
+	{
+		return UnitVector(Vec4<T>{ (T)settings.lightDirection.x, (T)settings.lightDirection.y, (T)settings.lightDirection.z, (T)0 });
+	}
+
+	// Transform the face normals of mesh into world space & shade every triangle, unless the cache already holds them for these normals, transform & light
+	template<typename T>
+	static void UpdateShadingCache(ShadingCache<T> &cache, const IndexedMesh<T> &mesh, const Matrix4x4<T> &transformMatrix, const Vec4<T> &unitLightDirection)
+	{
+		const VertexStream<T> &faceNormals = mesh.faceNormals;
+		size_t triangleCount = faceNormals.x.size();
+		if (cache.isValid
+			&& (cache.faceNormals == &faceNormals)
+			&& (cache.faceNormalsVersion == mesh.faceNormalsVersion)
+			&& (cache.colors.size() == triangleCount)
+			&& (memcmp(&cache.transformMatrix, &transformMatrix, sizeof(transformMatrix)) == 0)
+			&& (cache.lightDirection.x == unitLightDirection.x)
+			&& (cache.lightDirection.y == unitLightDirection.y)
+			&& (cache.lightDirection.z == unitLightDirection.z))
+		{
+			return;
+		}
+
+		TransformVertexStream(faceNormals, MakeNormalMatrix(transformMatrix), cache.worldNormals);
+		cache.colors.resize(triangleCount);
+		for (size_t i = 0; i < triangleCount; i += 1)
+		{
+			Vec4<T> normal = UnitVector(Vec4<T>{ cache.worldNormals.x[i], cache.worldNormals.y[i], cache.worldNormals.z[i], (T)0 });
+			cache.colors[i] = GetShadedColor(normal, unitLightDirection);
+		}
+
+		cache.faceNormals = &faceNormals;
+		cache.faceNormalsVersion = mesh.faceNormalsVersion;
+		cache.transformMatrix = transformMatrix;
+		cache.lightDirection = { unitLightDirection.x, unitLightDirection.y, unitLightDirection.z };
+		cache.isValid = true;
+	}
+
+	template<typename T>
+	static Matrix4x4<T> MakeViewProjectionMatrix(const Camera<T> &camera, const Matrix4x4<T> &projectionMatrix)
+	{
+		// Camera matrix
+		Vec4<T> target = AddVectors(camera.position, camera.direction);
+		Matrix4x4<T> cameraMatrix = PointAt(camera.position, target, camera.up);
+
+		// View matrix
+		Matrix4x4<T> viewMatrix = LookAt(cameraMatrix);
+
+		return MultiplyMatrixWithMatrix(viewMatrix, projectionMatrix);
+	}
+
+	/**
+	 * Clip space planes (a, b, c, d) with the inside where (a * x) + (b * y) + (c * z) + (d * w) >= 0, in ClipPlane order.
+	 * A pixel x position is ((x / w) * viewportScale) + (width / 2), so it's inside the screen edge at pixel -edge when
+	 * x >= -(((width / 2) + edge) / viewportScale) * w. Likewise for y.
+	 */
+	template<typename T>
+	static void MakeClipPlanes(const RenderBuffer &renderBuffer, T viewportScale, Vec4<T> (&planes)[CLIP_PLANE_COUNT])
+	{
+		const T translateX = (T)0.5 * (T)renderBuffer.width;
+		const T translateY = (T)0.5 * (T)renderBuffer.height;
+		const T guardBandX = (translateX + (T)GUARD_BAND_SIZE) / viewportScale;
+		const T guardBandY = (translateY + (T)GUARD_BAND_SIZE) / viewportScale;
+		const T screenX = translateX / viewportScale;
+		const T screenY = translateY / viewportScale;
+		planes[CLIP_PLANE_GUARD_BAND_LEFT] = { (T)1, (T)0, (T)0, guardBandX };
+		planes[CLIP_PLANE_GUARD_BAND_RIGHT] = { (T)-1, (T)0, (T)0, guardBandX };
+		planes[CLIP_PLANE_GUARD_BAND_BOTTOM] = { (T)0, (T)1, (T)0, guardBandY };
+		planes[CLIP_PLANE_GUARD_BAND_TOP] = { (T)0, (T)-1, (T)0, guardBandY };
+		planes[CLIP_PLANE_NEAR] = { (T)0, (T)0, (T)1, (T)0 };	// z >= 0 in front of the near plane
+		planes[CLIP_PLANE_FAR] = { (T)0, (T)0, (T)-1, (T)1 };	// z <= w behind the far plane
+		planes[CLIP_PLANE_SCREEN_LEFT] = { (T)1, (T)0, (T)0, screenX };
+		planes[CLIP_PLANE_SCREEN_RIGHT] = { (T)-1, (T)0, (T)0, screenX };
+		planes[CLIP_PLANE_SCREEN_BOTTOM] = { (T)0, (T)1, (T)0, screenY };
+		planes[CLIP_PLANE_SCREEN_TOP] = { (T)0, (T)-1, (T)0, screenY };
+	}
+
+	// Everything about the camera, projection & render buffer that's the same for every mesh drawn in a frame
+	template<typename T>
+	struct View
+	{
+		Vec4<T> cameraPosition;
+		Matrix4x4<T> viewProjectionMatrix;
+		Vec4<T> planes[CLIP_PLANE_COUNT];
+		T orientation;		// 1 or -1, see CullTriangles
+		T nearPlane;
+		T viewportScale;	// Scale & offset from normalized device co-ordinates to pixels
+		T translateX;
+		T translateY;
+	};
+
+	// viewportScale is the pixels per unit of normalized device co-ordinates, VIEWPORT_SCALE unless the buffer is a scaled down copy of the screen
+	template<typename T>
+	static View<T> MakeView(const RenderBuffer &renderBuffer, T viewportScale, const Camera<T> &camera, const Matrix4x4<T> &projectionMatrix)
+	{
+		View<T> view;
+		view.cameraPosition = camera.position;
+		view.viewProjectionMatrix = MakeViewProjectionMatrix(camera, projectionMatrix);
+		MakeClipPlanes(renderBuffer, viewportScale, view.planes);
+
+		// The clip space determinant of a triangle is its world space back face test, (normal . (corner - camera position)),
+		// scaled by the determinant of the view projection's x, y & w columns. Only the sign of that scale matters
+		const int columns[3] = { 0, 1, 3 };
+		const T (&m)[4][4] = view.viewProjectionMatrix.m;
+		T viewProjectionDeterminant = (T)0;
+		for (int i = 0; i < 3; i += 1)
+		{
+			int col0 = columns[i];
+			int col1 = columns[(i + 1) % 3];
+			int col2 = columns[(i + 2) % 3];
+			viewProjectionDeterminant += m[0][col0] * ((m[1][col1] * m[2][col2]) - (m[1][col2] * m[2][col1]));
+		}
+		view.orientation = (viewProjectionDeterminant < (T)0) ? (T)-1 : (T)1;
+
+		// Depth gets stored reversed as near / w. i.e. 1 at the near plane, falling towards 0 at infinity.
+		// Work out the near plane distance from the projection matrix, m[2][2] = f / (f - n) & m[3][2] = -f * n / (f - n)
+		view.nearPlane = (projectionMatrix.m[2][2] != (T)0) ? -projectionMatrix.m[3][2] / projectionMatrix.m[2][2] : (T)1;
+
+		view.viewportScale = viewportScale;
+		view.translateX = (T)0.5 * (T)renderBuffer.width;
+		view.translateY = (T)0.5 * (T)renderBuffer.height;
+		return view;
+	}
+
+	static const int FRUSTUM_PLANE_COUNT = 6;
+
+	/**
+	 * The near, far & screen edge clip planes moved into model space with the model view projection matrix, so bounds in
+	 * model space can be tested against them directly, whatever the model transform is.
+	 */
+	template<typename T>
+	static void MakeModelSpaceFrustumPlanes(const View<T> &view, const Matrix4x4<T> &transformMatrix, Vec4<T> (&frustumPlanes)[FRUSTUM_PLANE_COUNT])
+	{
+		const Vec4<T> (&planes)[CLIP_PLANE_COUNT] = view.planes;
+		Matrix4x4<T> modelViewProjectionMatrix = MultiplyMatrixWithMatrix(transformMatrix, view.viewProjectionMatrix);
+
+		const int frustumClipPlanes[FRUSTUM_PLANE_COUNT] = { CLIP_PLANE_NEAR, CLIP_PLANE_FAR, CLIP_PLANE_SCREEN_LEFT, CLIP_PLANE_SCREEN_RIGHT, CLIP_PLANE_SCREEN_BOTTOM, CLIP_PLANE_SCREEN_TOP };
+		for (int i = 0; i < FRUSTUM_PLANE_COUNT; i += 1)
+		{
+			frustumPlanes[i] = MakePlaneBeforeTransform(planes[frustumClipPlanes[i]], modelViewProjectionMatrix);
+		}
+	}
+
+	/**
+	 * True when bounds are entirely outside the view frustum, so none of the mesh can be seen. Costs the same however many
+	 * vertices the mesh has, testing the bounding sphere, then the box, against each frustum plane.
+	 */
+	template<typename T>
+	static bool IsOutsideView(const Bounds<T> &bounds, const View<T> &view, const Matrix4x4<T> &transformMatrix)
+	{
+		if (!bounds.isValid)
+		{
+			return false;
+		}
+
+		Vec4<T> frustumPlanes[FRUSTUM_PLANE_COUNT];
+		MakeModelSpaceFrustumPlanes(view, transformMatrix, frustumPlanes);
+		for (const Vec4<T> &plane : frustumPlanes)
+		{
+			if (IsSphereOutsidePlane(bounds.sphere, plane) || IsBoxOutsidePlane(bounds.box, plane))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static RenderBuffer GetOcclusionRenderBuffer(OcclusionBuffer &occlusionBuffer)
+	{
+		RenderBuffer renderBuffer;
+		renderBuffer.pixels = nullptr;
+		renderBuffer.width = occlusionBuffer.width;
+		renderBuffer.height = occlusionBuffer.height;
+		renderBuffer.pitch = 0;
+		renderBuffer.bytesPerPixel = 0;
+		renderBuffer.depth = occlusionBuffer.depth.data();
+		renderBuffer.tiles = occlusionBuffer.tiles.data();
+		return renderBuffer;
+	}
+
+	/**
+	 * True when bounds are entirely behind the occluders in occlusionBuffer. The corners of the bounding box get projected
+	 * into the occlusion buffer, & the box is hidden when every pixel of the rectangle around them is already nearer than the
+	 * nearest corner. The render tiles usually settle it without reading any depth values.
+	 */
+	template<typename T>
+	static bool IsOccluded(const Bounds<T> &bounds, const View<T> &view, const Matrix4x4<T> &transformMatrix, OcclusionBuffer &occlusionBuffer)
+	{
+		if (!bounds.isValid)
+		{
+			return false;
+		}
+
+		Matrix4x4<T> modelViewProjectionMatrix = MultiplyMatrixWithMatrix(transformMatrix, view.viewProjectionMatrix);
+		const T viewportScale = (T)occlusionBuffer.viewportScale;
+		const T translateX = (T)0.5 * (T)occlusionBuffer.width;
+		const T translateY = (T)0.5 * (T)occlusionBuffer.height;
+		T minX = std::numeric_limits<T>::max();
+		T minY = std::numeric_limits<T>::max();
+		T maxX = std::numeric_limits<T>::lowest();
+		T maxY = std::numeric_limits<T>::lowest();
+		T minW = std::numeric_limits<T>::max();
+		for (int corner = 0; corner < 8; corner += 1)
+		{
+			Vec4<T> p = {
+				(corner & 1) ? bounds.box.max.x : bounds.box.min.x,
+				(corner & 2) ? bounds.box.max.y : bounds.box.min.y,
+				(corner & 4) ? bounds.box.max.z : bounds.box.min.z,
+				(T)1
+			};
+			Vec4<T> clip;
+			MultiplyVectorWithMatrix(p, clip, modelViewProjectionMatrix);
+
+			// A corner in front of the near plane doesn't project onto the screen in any useful way, so keep the mesh
+			if (clip.z < (T)0)
+			{
+				return false;
+			}
+			T x = ((clip.x / clip.w) * viewportScale) + translateX;
+			T y = ((clip.y / clip.w) * viewportScale) + translateY;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minW = std::min(minW, clip.w);
+		}
+
+		// Every pixel the rectangle touches, not just the ones whose centres it covers
+		int x0 = std::max((int)floor(minX), 0);
+		int y0 = std::max((int)floor(minY), 0);
+		int x1 = std::min((int)floor(maxX), occlusionBuffer.width - 1);
+		int y1 = std::min((int)floor(maxY), occlusionBuffer.height - 1);
+		if (x0 > x1 || y0 > y1)
+		{
+			return false;
+		}
+
+		float nearestDepth = (float)(view.nearPlane / minW);
+		if (IsHiddenByDepthTiles(GetOcclusionRenderBuffer(occlusionBuffer), x0, y0, x1, y1, nearestDepth, true))
+		{
+			return true;
+		}
+		for (int y = y0; y <= y1; y += 1)
+		{
+			const float* depthPointer = occlusionBuffer.depth.data() + (occlusionBuffer.width * y) + x0;
+			for (int x = x0; x <= x1; x += 1)
+			{
+				if (*depthPointer < nearestDepth)
+				{
+					return false;
+				}
+				depthPointer++;
+			}
+		}
+		return true;
+	}
+
+	// Triangles firstTriangle to firstTriangle + triangleCount - 1, which only use vertices firstVertex to firstVertex + vertexCount - 1
+	struct TriangleRange
+	{
+		size_t firstTriangle;
+		size_t triangleCount;
+		size_t firstVertex;
+		size_t vertexCount;
+	};
+
+	/**
+	 * Throw away the clusters that are entirely outside the view or that only hold triangles facing away from the camera,
+	 * before any of their vertices get transformed. The rest go in visibleRanges, with neighbouring clusters merged.
+	 * Their triangles count as outside or back facing in stats, just as if they'd been culled one at a time.
+	 */
+	template<typename T>
+	static void CullClusters(const std::vector<Cluster<T>> &clusters, const View<T> &view, const Matrix4x4<T> &transformMatrix, std::vector<TriangleRange> &visibleRanges, RenderStats &stats)
+	{
+		visibleRanges.clear();
+
+		Vec4<T> frustumPlanes[FRUSTUM_PLANE_COUNT];
+		MakeModelSpaceFrustumPlanes(view, transformMatrix, frustumPlanes);
+
+		// Move the camera into model space with the inverse of the transform, which is the transpose of the cofactor matrix
+		// over the determinant. The back face test is the triple product of two edges & the vector from the camera, so it keeps
+		// its sign through the transform unless the determinant is negative, i.e. the transform mirrors the mesh
+		const T (&m)[4][4] = transformMatrix.m;
+		Matrix4x4<T> cofactors = MakeNormalMatrix(transformMatrix);
+		T determinant = (m[0][0] * cofactors.m[0][0]) + (m[0][1] * cofactors.m[0][1]) + (m[0][2] * cofactors.m[0][2]);
+		bool canCullBackFaces = (determinant != (T)0);
+		Vec3<T> camera3d = { view.cameraPosition.x - m[3][0], view.cameraPosition.y - m[3][1], view.cameraPosition.z - m[3][2] };
+		Vec3<T> modelCamera = { (T)0, (T)0, (T)0 };
+		if (canCullBackFaces)
+		{
+			const T (&c)[4][4] = cofactors.m;
+			modelCamera.x = ((camera3d.x * c[0][0]) + (camera3d.y * c[0][1]) + (camera3d.z * c[0][2])) / determinant;
+			modelCamera.y = ((camera3d.x * c[1][0]) + (camera3d.y * c[1][1]) + (camera3d.z * c[1][2])) / determinant;
+			modelCamera.z = ((camera3d.x * c[2][0]) + (camera3d.y * c[2][1]) + (camera3d.z * c[2][2])) / determinant;
+		}
+		T orientation = (determinant < (T)0) ? (T)-1 : (T)1;
+
+		for (const Cluster<T> &cluster : clusters)
+		{
+			bool isOutside = false;
+			for (const Vec4<T> &plane : frustumPlanes)
+			{
+				isOutside = isOutside || IsSphereOutsidePlane(cluster.sphere, plane);
+			}
+			if (isOutside)
+			{
+				stats.clustersCulled += 1;
+				stats.trianglesOutside += (int)cluster.triangleCount;
+				continue;
+			}
+
+			// Every triangle faces away when every direction from the camera into the sphere is more than 90 degrees plus the
+			// cone angle away from the axis. Taking the sphere as far off the axis as it can be keeps this conservative
+			if (canCullBackFaces)
+			{
+				Vec3<T> toCentre = { cluster.sphere.centre.x - modelCamera.x, cluster.sphere.centre.y - modelCamera.y, cluster.sphere.centre.z - modelCamera.z };
+				T distance = sqrtf(DotProduct(toCentre, toCentre));
+				T axisDistance = orientation * DotProduct(toCentre, cluster.coneAxis);
+				if (axisDistance < -(cluster.coneCutoff * distance) - (cluster.sphere.radius * ((T)1 + cluster.coneCutoff)))
+				{
+					stats.clustersCulled += 1;
+					stats.trianglesBackFacing += (int)cluster.triangleCount;
+					continue;
+				}
+			}
+
+			TriangleRange *last = visibleRanges.empty() ? nullptr : &visibleRanges.back();
+			if (last && (last->firstTriangle + last->triangleCount == cluster.firstTriangle) && (last->firstVertex + last->vertexCount == cluster.firstVertex))
+			{
+				last->triangleCount += cluster.triangleCount;
+				last->vertexCount += cluster.vertexCount;
+			}
+			else
+			{
+				visibleRanges.push_back({ cluster.firstTriangle, cluster.triangleCount, cluster.firstVertex, cluster.vertexCount });
+			}
+		}
+	}
+
+	/**
+	 * The pipeline shared by every kind of mesh, up to the point the triangles are ready to fill. Only the triangles &
+	 * vertices in ranges get looked at. Each vertex gets transformed & projected once, however many triangles share it, then
+	 * triangle i is made of the vertices at indices[3i], indices[3i + 1] & indices[3i + 2], or of vertices 3i, 3i + 1 & 3i + 2
+	 * when indices is null. CullTriangles throws away every triangle it can before the rest get clipped, set up & appended to
+	 * trianglesToFill.
+	 * Triangle i gets colours[i] when colours isn't null. Otherwise triangles get shaded from faceNormals, or from normals
+	 * worked out from their vertices when that's null too.
+	 */
+	template<typename T>
+	static void TransformAndSetUpTriangles(const VertexStream<T> &vertices, const uint32_t* indices, const TriangleRange* ranges, size_t rangeCount, const VertexStream<T>* faceNormals, const unsigned int* colors, const View<T> &view, const Matrix4x4<T> &transformMatrix, const RenderSettings &settings, std::vector<ScreenTriangle> &trianglesToFill, RenderStats &stats)
+	{
+		if (rangeCount == 0)
+		{
+			return;
+		}
+
+		// Transform every vertex straight from model space to clip space in one batch per range, with the model, view &
+		// projection matrices combined. The streams are kept between calls so big meshes don't allocate & fault in fresh pages
+		// every frame.
+		Matrix4x4<T> modelViewProjectionMatrix = MultiplyMatrixWithMatrix(transformMatrix, view.viewProjectionMatrix);
+		static thread_local VertexStream<T> clipVertices;
+		for (size_t i = 0; i < rangeCount; i += 1)
+		{
+			TransformVertexStream(vertices, ranges[i].firstVertex, ranges[i].vertexCount, modelViewProjectionMatrix, clipVertices);
+		}
+
+		Vec4<T> lightDirection = GetUnitLightDirection<T>(settings);
+		Matrix4x4<T> normalMatrix;
+		if (!colors)
+		{
+			normalMatrix = MakeNormalMatrix(transformMatrix);
+		}
+
+		const T nearPlane = view.nearPlane;
+		const T viewportScale = view.viewportScale;
+		const T translateX = view.translateX;
+		const T translateY = view.translateY;
+		const Vec4<T> (&planes)[CLIP_PLANE_COUNT] = view.planes;
+
+		static thread_local ProjectedVertices projected;
+		for (size_t i = 0; i < rangeCount; i += 1)
+		{
+			ProjectVertices(clipVertices, ranges[i].firstVertex, ranges[i].vertexCount, planes, viewportScale, translateX, translateY, nearPlane, projected);
+		}
+
+		// The scanline fill covers the pixels its corners land in, however small the triangle, so only the half-space fill
+		// can lose triangles that miss every pixel centre
+		static thread_local std::vector<uint32_t> visibleTriangles;
+		visibleTriangles.clear();
+		for (size_t i = 0; i < rangeCount; i += 1)
+		{
+			CullTriangles(clipVertices, projected, indices, ranges[i].firstTriangle, ranges[i].triangleCount, view.orientation, settings.fillEngine == FILL_ENGINE_HALF_SPACE, visibleTriangles, stats);
+		}
+
+		size_t firstTriangleToFill = trianglesToFill.size();
+
+		for (uint32_t triangle : visibleTriangles)
+		{
+			uint32_t triangleVertices[3];
+			uint32_t outcodeOr = 0;
+			for (int i = 0; i < 3; i += 1)
+			{
+				triangleVertices[i] = GetTriangleVertex(indices, triangle, i);
+				outcodeOr |= projected.outcodes[triangleVertices[i]];
+			}
+
+			unsigned int triangleColor;
+			if (colors)
+			{
+				triangleColor = colors[triangle];
+			}
+			else if (faceNormals)
+			{
+				Vec4<T> normal = { faceNormals->x[triangle], faceNormals->y[triangle], faceNormals->z[triangle], (T)0 };
+				Vec4<T> worldNormal;
+				MultiplyVectorWithMatrix(normal, worldNormal, normalMatrix);
+				worldNormal.w = (T)0;
+				triangleColor = GetShadedColor(UnitVector(worldNormal), lightDirection);
+			}
+			else
+			{
+				// Work out the normal in model space & move it to world space
+				Vec4<T> p[3];
+				for (int i = 0; i < 3; i += 1)
+				{
+					uint32_t vertex = triangleVertices[i];
+					p[i] = { vertices.x[vertex], vertices.y[vertex], vertices.z[vertex], (T)0 };
+				}
+				Vec4<T> normal = CrossProduct(SubtractVectors(p[1], p[0]), SubtractVectors(p[2], p[0]));
+				Vec4<T> worldNormal;
+				MultiplyVectorWithMatrix(normal, worldNormal, normalMatrix);
+				worldNormal.w = (T)0;
+				triangleColor = GetShadedColor(UnitVector(worldNormal), lightDirection);
+			}
+
+			Vec2<float> screenPoints[MAX_CLIPPED_POLYGON_POINTS];
+			float depths[MAX_CLIPPED_POLYGON_POINTS];
+			int pointCount = 3;
+
+			uint32_t straddledPlanes = outcodeOr & CLIPPING_PLANES_MASK;
+			if (straddledPlanes == 0)
+			{
+				for (int i = 0; i < 3; i += 1)
+				{
+					uint32_t vertex = triangleVertices[i];
+					screenPoints[i] = { projected.screenX[vertex], projected.screenY[vertex] };
+					depths[i] = projected.depth[vertex];
+				}
+			}
+			else
+			{
+				GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_CLIP);
+				stats.trianglesClipped += 1;
+
+				Vec4<T> polygons[2][MAX_CLIPPED_POLYGON_POINTS];
+				Vec4<T>* polygon = polygons[0];
+				Vec4<T>* clippedPolygon = polygons[1];
+				for (int i = 0; i < 3; i += 1)
+				{
+					uint32_t vertex = triangleVertices[i];
+					polygon[i] = { clipVertices.x[vertex], clipVertices.y[vertex], clipVertices.z[vertex], clipVertices.w[vertex] };
+				}
+
+				for (int i = 0; (i < CLIPPING_PLANE_COUNT) && (straddledPlanes != 0); i += 1)
+				{
+					if (straddledPlanes & (1u << i))
+					{
+						pointCount = ClipPolygonAgainstPlane(planes[i], polygon, pointCount, clippedPolygon);
+						std::swap(polygon, clippedPolygon);
+						if (pointCount < 3)
+						{
+							break;
+						}
+					}
+				}
+				if (pointCount < 3)
+				{
+					continue;
+				}
+
+				// Perspective divide & scale to the view. w is the view space depth
+				for (int i = 0; i < pointCount; i += 1)
+				{
+					const Vec4<T> &p = polygon[i];
+					screenPoints[i] = { (float)(((p.x / p.w) * viewportScale) + translateX), (float)(((p.y / p.w) * viewportScale) + translateY) };
+					depths[i] = (float)(nearPlane / p.w);
+				}
+			}
+
+			// Fan the convex polygon out from its first point
+			for (int i = 1; i + 1 < pointCount; i += 1)
+			{
+				ScreenTriangle fill;
+				fill.p[0] = screenPoints[0];
+				fill.p[1] = screenPoints[i];
+				fill.p[2] = screenPoints[i + 1];
+				fill.depth = MakeDepthPlane(fill.p[0], fill.p[1], fill.p[2], depths[0], depths[i], depths[i + 1]);
+				fill.color = triangleColor;
+				trianglesToFill.push_back(fill);
+			}
+		}
+
+		stats.trianglesFilled += (int)(trianglesToFill.size() - firstTriangleToFill);
+	}
+
+	// Append the triangles of a vertex stream, every three consecutive vertices making a triangle, that are worth filling to trianglesToFill
+	template<typename T>
+	static void SetUpVertexStream(const VertexStream<T> &vertices, const View<T> &view, const Matrix4x4<T> &transformMatrix, const RenderSettings &settings, std::vector<ScreenTriangle> &trianglesToFill, RenderStats &stats)
+	{
+		size_t triangleCount = vertices.x.size() / 3;
+		stats.trianglesSubmitted += (int)triangleCount;
+		TriangleRange everything = { 0, triangleCount, 0, triangleCount * 3 };
+		TransformAndSetUpTriangles<T>(vertices, nullptr, &everything, 1, nullptr, nullptr, view, transformMatrix, settings, trianglesToFill, stats);
+	}
+
+	/**
+	 * Append the triangles of mesh that are worth filling to trianglesToFill, skipping the whole mesh or whole clusters of it
+	 * when they can't be seen. Triangles get their colours from shadingCache when it isn't null & the mesh has face normals.
+	 */
+	template<typename T>
+	static void SetUpIndexedMesh(const IndexedMesh<T> &mesh, const View<T> &view, const Matrix4x4<T> &transformMatrix, ShadingCache<T>* shadingCache, const RenderSettings &settings, std::vector<ScreenTriangle> &trianglesToFill, RenderStats &stats)
+	{
+		size_t triangleCount = mesh.indices.size() / 3;
+		stats.trianglesSubmitted += (int)triangleCount;
+		if (IsOutsideView(mesh.bounds, view, transformMatrix))
+		{
+			stats.meshesCulled += 1;
+			return;
+		}
+		if (settings.occlusionBuffer && IsOccluded(mesh.bounds, view, transformMatrix, *settings.occlusionBuffer))
+		{
+			stats.meshesOccluded += 1;
+			return;
+		}
+
+		static thread_local std::vector<TriangleRange> visibleRanges;
+		if (mesh.clusters.empty())
+		{
+			visibleRanges.assign(1, TriangleRange{ 0, triangleCount, 0, mesh.vertices.x.size() });
+		}
+		else
+		{
+			CullClusters(mesh.clusters, view, transformMatrix, visibleRanges, stats);
+		}
+
+		bool hasFaceNormals = (mesh.faceNormals.x.size() == triangleCount);
+		const unsigned int* colors = nullptr;
+		if (hasFaceNormals && shadingCache)
+		{
+			UpdateShadingCache(*shadingCache, mesh, transformMatrix, GetUnitLightDirection<T>(settings));
+			colors = shadingCache->colors.data();
+		}
+		TransformAndSetUpTriangles(mesh.vertices, mesh.indices.data(), visibleRanges.data(), visibleRanges.size(),
+			hasFaceNormals ? &mesh.faceNormals : nullptr, colors, view, transformMatrix, settings, trianglesToFill, stats);
+	}
+
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const VertexStream<T> &vertices, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings)
+	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_RENDER);
+		RenderStats stats;
+		static thread_local std::vector<ScreenTriangle> trianglesToFill;
+		trianglesToFill.clear();
+		SetUpVertexStream(vertices, MakeView(renderBuffer, (T)VIEWPORT_SCALE, camera, projectionMatrix), transformMatrix, settings, trianglesToFill, stats);
+		RasterizeTriangles(renderBuffer, trianglesToFill, settings);
+		return stats;
+	}
+	template RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const VertexStream<float> &vertices, const Camera<float> &camera, const Matrix4x4<float> &transformMatrix, const Matrix4x4<float> &projectionMatrix, const RenderSettings &settings);
+
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const IndexedMesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings, ShadingCache<T>* shadingCache)
+	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_RENDER);
+		RenderStats stats;
+		static thread_local std::vector<ScreenTriangle> trianglesToFill;
+		trianglesToFill.clear();
+		SetUpIndexedMesh(mesh, MakeView(renderBuffer, (T)VIEWPORT_SCALE, camera, projectionMatrix), transformMatrix, shadingCache, settings, trianglesToFill, stats);
+		RasterizeTriangles(renderBuffer, trianglesToFill, settings);
+		return stats;
+	}
+	template RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const IndexedMesh<float> &mesh, const Camera<float> &camera, const Matrix4x4<float> &transformMatrix, const Matrix4x4<float> &projectionMatrix, const RenderSettings &settings, ShadingCache<float>* shadingCache);
+
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings)
+	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_RENDER);
+		RenderStats stats;
+		View<T> view = MakeView(renderBuffer, (T)VIEWPORT_SCALE, camera, projectionMatrix);
+		if (IsOutsideView(mesh.bounds, view, transformMatrix))
+		{
+			stats.trianglesSubmitted = (int)mesh.triangles.size();
+			stats.meshesCulled = 1;
+			return stats;
+		}
+		if (settings.occlusionBuffer && IsOccluded(mesh.bounds, view, transformMatrix, *settings.occlusionBuffer))
+		{
+			stats.trianglesSubmitted = (int)mesh.triangles.size();
+			stats.meshesOccluded = 1;
+			return stats;
+		}
+
+		static thread_local VertexStream<T> vertices;
+		FillVertexStream(mesh, vertices);
+		static thread_local std::vector<ScreenTriangle> trianglesToFill;
+		trianglesToFill.clear();
+		SetUpVertexStream(vertices, view, transformMatrix, settings, trianglesToFill, stats);
+		RasterizeTriangles(renderBuffer, trianglesToFill, settings);
+		return stats;
+	}
+	template RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<float> &mesh, const Camera<float> &camera, const Matrix4x4<float> &transformMatrix, const Matrix4x4<float> &projectionMatrix, const RenderSettings &settings);
+
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix)
+	{
+		RenderSettings settings;
+		return TransformAndRenderMesh(renderBuffer, mesh, camera, transformMatrix, projectionMatrix, settings);
+	}
+	template RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<float> &mesh, const Camera<float> &camera, const Matrix4x4<float> &transformMatrix, const Matrix4x4<float> &projectionMatrix);
+
+	template<typename T>
+	void AddMeshInstance(DrawList<T> &drawList, const IndexedMesh<T> &mesh, const Matrix4x4<T> &transformMatrix, ShadingCache<T>* shadingCache)
+	{
+		drawList.instances.push_back({ &mesh, transformMatrix, shadingCache });
+	}
+	template void AddMeshInstance(DrawList<float> &drawList, const IndexedMesh<float> &mesh, const Matrix4x4<float> &transformMatrix, ShadingCache<float>* shadingCache);
+
+	template<typename T>
+	RenderStats RenderDrawList(const RenderBuffer &renderBuffer, const DrawList<T> &drawList, const Camera<T> &camera, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings)
+	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_RENDER);
+		RenderStats stats;
+		View<T> view = MakeView(renderBuffer, (T)VIEWPORT_SCALE, camera, projectionMatrix);
+		static thread_local std::vector<ScreenTriangle> trianglesToFill;
+		trianglesToFill.clear();
+		for (const MeshInstance<T> &instance : drawList.instances)
+		{
+			SetUpIndexedMesh(*instance.mesh, view, instance.transformMatrix, instance.shadingCache, settings, trianglesToFill, stats);
+		}
+		RasterizeTriangles(renderBuffer, trianglesToFill, settings);
+		return stats;
+	}
+	template RenderStats RenderDrawList(const RenderBuffer &renderBuffer, const DrawList<float> &drawList, const Camera<float> &camera, const Matrix4x4<float> &projectionMatrix, const RenderSettings &settings);
+
+	OcclusionBuffer MakeOcclusionBuffer(int width, int height, const RenderBuffer &screen)
+	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_RENDER);
+		OcclusionBuffer occlusionBuffer;
+		occlusionBuffer.width = width;
+		occlusionBuffer.height = height;
+
+		// Scale by whichever of width & height shrinks the most, so the occlusion buffer sees at least as much as the screen
+		// in both directions
+		float scale = std::min((float)width / (float)screen.width, (float)height / (float)screen.height);
+		occlusionBuffer.viewportScale = (float)VIEWPORT_SCALE * scale;
+
+		int tileCount = ((width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE) * ((height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE);
+		occlusionBuffer.depth.resize(width * height);
+		occlusionBuffer.tiles.resize(tileCount);
+		occlusionBuffer.occluderDepth.resize((width + 2) * (height + 2));
+		ClearOcclusionBuffer(occlusionBuffer);
+		return occlusionBuffer;
+	}
+
+	void ClearOcclusionBuffer(OcclusionBuffer &occlusionBuffer)
+	{
+		ClearScreen(GetOcclusionRenderBuffer(occlusionBuffer), 0);
+	}
+
+	template<typename T>
+	RenderStats RenderOccluder(OcclusionBuffer &occlusionBuffer, const IndexedMesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix)
+	{
+		GENTLE_ALLOCATION_TAG(ALLOCATION_TAG_RENDER);
+
+		RenderSettings settings;
+		settings.fillEngine = FILL_ENGINE_HALF_SPACE;
+
+		// Fill the occluder on its own first, into a buffer a pixel bigger than the occlusion buffer all round so erosion can
+		// see what it covers just past the edges. Pixel x, y of the occlusion buffer is x + 1, y + 1 of this one
+		RenderStats stats;
+		const int width = occlusionBuffer.width;
+		const int height = occlusionBuffer.height;
+		RenderBuffer occluderBuffer = GetOcclusionRenderBuffer(occlusionBuffer);
+		occluderBuffer.width = width + 2;
+		occluderBuffer.height = height + 2;
+		occluderBuffer.depth = occlusionBuffer.occluderDepth.data();
+		occluderBuffer.tiles = nullptr;
+		static thread_local std::vector<ScreenTriangle> trianglesToFill;
+		trianglesToFill.clear();
+		SetUpIndexedMesh(mesh, MakeView(occluderBuffer, (T)occlusionBuffer.viewportScale, camera, projectionMatrix), transformMatrix, (ShadingCache<T>*)nullptr, settings, trianglesToFill, stats);
+
+		// Only the pixels around the triangles need clearing, along with a pixel more that erosion reads as uncovered
+		PixelRect bounds = { INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+		for (const ScreenTriangle &tri : trianglesToFill)
+		{
+			for (const Vec2<float> &p : tri.p)
+			{
+				bounds.x0 = std::min(bounds.x0, (int)floorf(p.x));
+				bounds.y0 = std::min(bounds.y0, (int)floorf(p.y));
+				bounds.x1 = std::max(bounds.x1, (int)floorf(p.x) + 1);
+				bounds.y1 = std::max(bounds.y1, (int)floorf(p.y) + 1);
+			}
+		}
+		bounds = IntersectPixelRects(bounds, PixelRect { 1, 1, width + 1, height + 1 });
+		if (trianglesToFill.empty() || IsPixelRectEmpty(bounds))
+		{
+			return stats;
+		}
+		for (int y = bounds.y0 - 1; y < bounds.y1 + 1; y += 1)
+		{
+			FillRow(occluderBuffer.depth + (occluderBuffer.width * y) + bounds.x0 - 1, 0.0f, bounds.x1 - bounds.x0 + 2, false);
+		}
+		RasterizeTriangles(occluderBuffer, trianglesToFill, settings);
+
+		// Then keep the farthest depth of each pixel & its neighbours, where 0 is uncovered. A pixel is only left covered when
+		// the centres all round it are, so the occluder covers all of it, & its depth is no nearer than any part of it
+		RenderBuffer renderBuffer = GetOcclusionRenderBuffer(occlusionBuffer);
+		ResolvePendingClears(renderBuffer, bounds.x0 - 1, bounds.y0 - 1, bounds.x1 - 2, bounds.y1 - 2);
+		float maxDepthWritten = 0.0f;
+		for (int y = bounds.y0; y < bounds.y1; y += 1)
+		{
+			float* depthPointer = renderBuffer.depth + (width * (y - 1)) + (bounds.x0 - 1);
+			for (int x = bounds.x0; x < bounds.x1; x += 1)
+			{
+				float erodedDepth = std::numeric_limits<float>::max();
+				for (int neighbourY = y - 1; neighbourY <= y + 1; neighbourY += 1)
+				{
+					const float* neighbours = occluderBuffer.depth + (occluderBuffer.width * neighbourY) + x - 1;
+					erodedDepth = std::min(erodedDepth, std::min(neighbours[0], std::min(neighbours[1], neighbours[2])));
+				}
+				if (erodedDepth > *depthPointer)
+				{
+					*depthPointer = erodedDepth;
+					maxDepthWritten = std::max(maxDepthWritten, erodedDepth);
+				}
+				depthPointer++;
+			}
+		}
+		if (maxDepthWritten > 0.0f)
+		{
+			MarkDepthTilesWritten(renderBuffer, bounds.x0 - 1, bounds.y0 - 1, bounds.x1 - 2, bounds.y1 - 2, maxDepthWritten);
+		}
+		return stats;
 	}
-	template void TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<float> &mesh, const Camera<float> &camera, const Matrix4x4<float> transformMatrix, const Matrix4x4<float> projectionMatrix);
-}
+	template RenderStats RenderOccluder(OcclusionBuffer &occlusionBuffer, const IndexedMesh<float> &mesh, const Camera<float> &camera, const Matrix4x4<float> &transformMatrix, const Matrix4x4<float> &projectionMatrix);
+}
\ No newline at end of file
@@ -2,11 +2,85 @@
 #define SOFTWARE_RENDERING_H
 
 #include "platform.hpp"
+#include "dirty_region.hpp"
 #include "math.hpp"
 #include "geometry.hpp"
+#include "memory.hpp"
+#include "thread_pool.hpp"
 
 namespace gentle
 {
+	enum FillEngine
+	{
+		FILL_ENGINE_SCANLINE,	// FillTriangleInPixels
+		FILL_ENGINE_HALF_SPACE	// FillTriangleHalfSpace
+	};
+
+	/**
+	 * Low resolution, depth only copy of the screen for occlusion culling. Make it with MakeOcclusionBuffer, render a few big
+	 * occluders such as walls & floors into it each frame with RenderOccluder, then point RenderSettings::occlusionBuffer at it
+	 * so meshes whose bounds are entirely behind the occluders get skipped before any of their vertices are transformed.
+	 */
+	struct OcclusionBuffer
+	{
+		int width;
+		int height;
+		float viewportScale;	// Pixels per unit of normalized device co-ordinates, the screen's scaled down to fit
+		std::vector<float> depth;
+		std::vector<RenderTile> tiles;
+		std::vector<float> occluderDepth;	// Scratch for RenderOccluder to fill each occluder into before eroding it, a pixel bigger all round
+	};
+
+	struct RenderSettings
+	{
+		ThreadPool* threadPool = nullptr;	// Optional. Its workers help the calling thread fill triangles binned into screen tiles. Without one everything fills on the calling thread
+		int tileSize = 64;		// Width & height in pixels of the screen tiles triangles get binned into with a threadPool. Rounded up to a multiple of RENDER_TILE_SIZE
+		FillEngine fillEngine = FILL_ENGINE_SCANLINE;
+		Vec3<float> lightDirection = { 0.0f, 0.0f, 1.0f };	// Direction the light travels in world space. Needn't be unit length
+		OcclusionBuffer* occlusionBuffer = nullptr;	// Optional. Holds occluders rendered with the same camera & projection as the meshes tested against it
+		MemoryArena* scratchArena = nullptr;		// Optional. Memory that only lives as long as each render call, used instead of the heap where it's given
+	};
+
+	/**
+	 * What happened to the triangles of a mesh on their way through TransformAndRenderMesh. A culled triangle only counts
+	 * against the first test that threw it away.
+	 */
+	struct RenderStats
+	{
+		int meshesCulled = 0;				// Meshes whose bounds were entirely outside the view, so none of their triangles got looked at
+		int meshesOccluded = 0;				// Meshes whose bounds were entirely behind the occluders in RenderSettings::occlusionBuffer
+		int clustersCulled = 0;				// Clusters of an IndexedMesh outside the view or facing away. Their triangles count as outside or back facing too
+		int trianglesSubmitted = 0;
+		int trianglesOutside = 0;			// Every vertex outside the same clip plane, e.g. off one side of the screen or behind the camera
+		int trianglesDegenerate = 0;		// No area, e.g. seen exactly edge on
+		int trianglesBackFacing = 0;
+		int trianglesMissingSamples = 0;	// Too small or thin to cover any pixel centre. Only culled with FILL_ENGINE_HALF_SPACE
+		int trianglesClipped = 0;			// Crossed the near, far or guard band planes so got clipped before filling
+		int trianglesFilled = 0;			// Screen triangles sent to the fill engine, including the ones clipped polygons got fanned into
+	};
+
+	// One copy of a mesh placed in the world with its own transform. Any number of instances can share the same mesh
+	template<typename T>
+	struct MeshInstance
+	{
+		const IndexedMesh<T>* mesh;
+		Matrix4x4<T> transformMatrix;
+		ShadingCache<T>* shadingCache;	// Optional. Belongs to this instance alone, so no other instance or thread renders with it
+	};
+
+	// Everything to render in a frame. The meshes aren't copied, so they have to outlive the draw list
+	template<typename T>
+	struct DrawList
+	{
+		std::vector<MeshInstance<T>> instances;
+	};
+
+	/**
+	 * Everything below that draws or clears only writes the pixels inside renderBuffer.scissor when it has one, & adds the
+	 * pixels it writes to renderBuffer.dirtyRegion when it has one. A frame where only a little has changed can then clear &
+	 * redraw each changed rect with the scissor set to it, & present just the dirty region rather than the whole buffer.
+	 */
+
 	/**
 	 *	|---|---|---|
 	 *	| 0 | 1 | 2 |	pixel ordinals
@@ -45,17 +119,94 @@ namespace gentle
 	);
 
 	// Triangles
+	/**
+	 * Depth is reversed, the pixel with the greatest depth value wins. ClearScreen sets depth to 0, i.e. infinitely far away.
+	 * Triangles either get a single depth value z, or depth values z0, z1 & z2 for p0, p1 & p2 that get interpolated across each pixel.
+	 * Depth values proportional to 1/w, such as near / w, interpolate correctly under perspective.
+	 */
+	// Implemented by walking the edges with Bresenham's algorithm and filling the scanlines between them
 	void FillTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z);
 
+	void FillTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z0, float z1, float z2);
+
+	/**
+	 * Implemented by testing blocks of pixels against the edge functions of the triangle with SIMD.
+	 * Pixels are sampled at their centre with a top-left fill rule, so unlike FillTriangleInPixels pixels on the
+	 * right & bottom edges are not filled and triangles sharing an edge never overlap.
+	 */
+	void FillTriangleHalfSpace(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z);
+
+	void FillTriangleHalfSpace(const RenderBuffer &renderBuffer, uint32_t color, const Vec3<int> &p0, const Vec3<int> &p1, const Vec3<int> &p2, float z0, float z1, float z2);
+
 
 	void DrawTriangleInPixels(const RenderBuffer &renderBuffer, uint32_t color, const Vec2<int> &p0, const Vec2<int> &p1, const Vec2<int> &p2);
 
+	// Also resets the depth buffer and render tiles. With a scissor, only the pixels inside it get cleared
 	void ClearScreen(const RenderBuffer &renderBuffer, uint32_t color);
 
+	/**
+	 * Only marks the render tiles as cleared. Each tile gets cleared the first time something is drawn to it, or not at all when
+	 * a triangle covers it completely. Call ResolveDeferredClear before the pixels get read, e.g. when presenting them.
+	 * Falls back to ClearScreen when the render buffer has no tiles, or a scissor that leaves part of it out.
+	 */
+	void ClearScreenDeferred(const RenderBuffer &renderBuffer, uint32_t color);
+
+	// Clear the tiles that nothing has been drawn to since ClearScreenDeferred
+	void ResolveDeferredClear(const RenderBuffer &renderBuffer);
+
 	unsigned int GetColorFromRGB(int red, int green, int blue);
 
+	/**
+	 * Meshes with valid bounds, see ComputeBounds, are skipped without transforming any vertices when the bounds are
+	 * entirely outside the view.
+	 */
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix);
+
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings);
+
+	/**
+	 * Render a mesh stored as a vertex stream, every three consecutive vertices making a triangle. Cheaper than passing a Mesh,
+	 * which gets copied into a vertex stream first, so build the stream once with MakeVertexStream & keep it.
+	 */
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const VertexStream<T> &vertices, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings);
+
+	/**
+	 * The cheapest mesh to render, as vertices shared between triangles only get transformed once. When the mesh has clusters,
+	 * see BuildClusters, the ones outside the view or facing away get skipped without transforming their vertices.
+	 * With a shadingCache, the lighting of each triangle only gets worked out again when the transform or light changes.
+	 */
+	template<typename T>
+	RenderStats TransformAndRenderMesh(const RenderBuffer &renderBuffer, const IndexedMesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings, ShadingCache<T>* shadingCache = nullptr);
+
+	template<typename T>
+	void AddMeshInstance(DrawList<T> &drawList, const IndexedMesh<T> &mesh, const Matrix4x4<T> &transformMatrix, ShadingCache<T>* shadingCache = nullptr);
+
+	/**
+	 * Render every instance in drawList. The camera & projection only get worked out once, & the triangles of every instance
+	 * get filled together in one pass at the end, so with a threadPool the screen tiles only get binned & filled once.
+	 * Instances with a shading cache get their lighting from it, the rest get shaded straight from the face normals of their mesh.
+	 * Returns the stats of all the instances added together.
+	 */
+	template<typename T>
+	RenderStats RenderDrawList(const RenderBuffer &renderBuffer, const DrawList<T> &drawList, const Camera<T> &camera, const Matrix4x4<T> &projectionMatrix, const RenderSettings &settings);
+
+	// Occlusion buffer of width x height pixels that sees at least as much as screen does, e.g. 256 x 144 for a 1280 x 720 screen
+	OcclusionBuffer MakeOcclusionBuffer(int width, int height, const RenderBuffer &screen);
+
+	// Call at the start of each frame, before rendering the occluders
+	void ClearOcclusionBuffer(OcclusionBuffer &occlusionBuffer);
+
+	/**
+	 * Render the depth of mesh into occlusionBuffer, with the same fill code as the screen but without writing any pixels.
+	 * The fill covers a pixel when it covers its centre, which would let an occluder stick out half a low resolution pixel
+	 * past its edges, so each occluder is eroded by a pixel on the way in. Only pixels it really covers all over are kept,
+	 * & a mesh peeking out around its edges doesn't get culled. Occluders should still be no bigger than what they stand in for.
+	 */
 	template<typename T>
-	void TransformAndRenderMesh(const RenderBuffer &renderBuffer, const Mesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> transformMatrix, const Matrix4x4<T> projectionMatrix);
+	RenderStats RenderOccluder(OcclusionBuffer &occlusionBuffer, const IndexedMesh<T> &mesh, const Camera<T> &camera, const Matrix4x4<T> &transformMatrix, const Matrix4x4<T> &projectionMatrix);
 }
 
 #endif
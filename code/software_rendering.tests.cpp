@@ -1,5 +1,7 @@
 #include "software_rendering.hpp"
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 
 const uint32_t EMPTY = 0x000000;
 const uint32_t FILLED = 0xFFFFFF;
@@ -143,6 +145,1215 @@ void Run6x4FillTriangleTest(gentle::Vec3<int> p0, gentle::Vec3<int> p1, gentle::
 	assert(pixelArray[25] == EMPTY);	// Should NEVER get written to
 }
 
+void Run4x4FillTriangleHalfSpaceTest(gentle::Vec3<int> p0, gentle::Vec3<int> p1, gentle::Vec3<int> p2, uint32_t* expectedPixels)
+{
+	uint32_t pixelArray[18] = { EMPTY };	// 16 pixels in the RenderBuffer plus one either side to pick up illegal memory writes
+	float depthArray[18] = { 0.0f };
+	ClearPixelAndDepthArray(pixelArray, depthArray, 18);
+
+	RenderBuffer renderBuffer;
+	renderBuffer.height = 4;
+	renderBuffer.width = 4;
+	renderBuffer.pixels = &pixelArray[1];
+	renderBuffer.depth = &depthArray[1];
+
+	gentle::FillTriangleHalfSpace(renderBuffer, FILLED, p0, p1, p2, 1.0f);
+
+	assert(pixelArray[0] == EMPTY);	// Should NEVER get written to
+
+	for (int i = 0; i < renderBuffer.height * renderBuffer.width; i += 1)
+	{
+		assert(pixelArray[i + 1] == expectedPixels[i]);
+	}
+
+	assert(pixelArray[17] == EMPTY);	// Should NEVER get written to
+}
+
+void RunHalfSpaceFillTests()
+{
+	/**
+	 * FLAT TOP LEFT HAND SIDE RIGHT ANGLED TRIANGLE
+	 * Pixels on the top & left edges are filled, pixels on the right edge are not
+	 *
+	 *	    0   1   2   3
+	 *	  |---|---|---|---|
+	 *	0 | O | x | x | O |
+	 *	  |---|---|---|---|
+	 *	1 | x | x |   |   |
+	 *	  |---|---|---|---|
+	 *	2 | x |   |   |   |
+	 *	  |---|---|---|---|
+	 *	3 | O |   |   |   |
+	 *	  |---|---|---|---|
+	 */
+	uint32_t ehs1[16] = {
+		FILLED,	FILLED,	FILLED,	EMPTY,
+		FILLED,	FILLED,	EMPTY,	EMPTY,
+		FILLED,	EMPTY,	EMPTY,	EMPTY,
+		EMPTY,	EMPTY,	EMPTY,	EMPTY
+	};
+	Run4x4FillTriangleHalfSpaceTest(gentle::Vec3<int>{ 0, 0, 0 }, gentle::Vec3<int>{ 3, 0, 0 }, gentle::Vec3<int>{ 0, 3, 0 }, ehs1);
+	Run4x4FillTriangleHalfSpaceTest(gentle::Vec3<int>{ 0, 3, 0 }, gentle::Vec3<int>{ 3, 0, 0 }, gentle::Vec3<int>{ 0, 0, 0 }, ehs1);
+	Run4x4FillTriangleHalfSpaceTest(gentle::Vec3<int>{ 3, 0, 0 }, gentle::Vec3<int>{ 0, 3, 0 }, gentle::Vec3<int>{ 0, 0, 0 }, ehs1);
+
+	/**
+	 * TRIANGLE PARTIALLY OUTSIDE THE BUFFER
+	 * The long edge runs through the pixel centres on the diagonal. It is a left edge so those pixels are filled.
+	 *
+	 *	    0   1   2   3
+	 *	  |---|---|---|---|
+	 *	0 | x | x | x | x |
+	 *	  |---|---|---|---|
+	 *	1 |   | x | x | x |
+	 *	  |---|---|---|---|
+	 *	2 |   |   | x | x |
+	 *	  |---|---|---|---|
+	 *	3 |   |   |   | x |
+	 *	  |---|---|---|---|
+	 */
+	uint32_t ehs2[16] = {
+		FILLED,	FILLED,	FILLED,	FILLED,
+		EMPTY,	FILLED,	FILLED,	FILLED,
+		EMPTY,	EMPTY,	FILLED,	FILLED,
+		EMPTY,	EMPTY,	EMPTY,	FILLED
+	};
+	Run4x4FillTriangleHalfSpaceTest(gentle::Vec3<int>{ -2, -2, 0 }, gentle::Vec3<int>{ 6, -2, 0 }, gentle::Vec3<int>{ 6, 6, 0 }, ehs2);
+
+	// Degenerate triangles have no area so fill nothing
+	uint32_t ehs3[16] = { EMPTY };
+	Run4x4FillTriangleHalfSpaceTest(gentle::Vec3<int>{ 0, 0, 0 }, gentle::Vec3<int>{ 3, 3, 0 }, gentle::Vec3<int>{ 1, 1, 0 }, ehs3);
+
+	/**
+	 * Two triangles sharing an edge must fill every pixel of the quad they form exactly once.
+	 * The quad is bigger than a single block so multiple blocks get walked.
+	 */
+	const int size = 21;
+	uint32_t firstPixels[size * size];
+	uint32_t secondPixels[size * size];
+	float firstDepth[size * size];
+	float secondDepth[size * size];
+	ClearPixelAndDepthArray(firstPixels, firstDepth, size * size);
+	ClearPixelAndDepthArray(secondPixels, secondDepth, size * size);
+
+	RenderBuffer first;
+	first.width = size;
+	first.height = size;
+	first.pixels = firstPixels;
+	first.depth = firstDepth;
+	RenderBuffer second = first;
+	second.pixels = secondPixels;
+	second.depth = secondDepth;
+
+	gentle::Vec3<int> topLeft = { 1, 2, 0 };
+	gentle::Vec3<int> topRight = { 19, 0, 0 };
+	gentle::Vec3<int> bottomRight = { 20, 17, 0 };
+	gentle::Vec3<int> bottomLeft = { 0, 19, 0 };
+	gentle::FillTriangleHalfSpace(first, FILLED, topLeft, topRight, bottomRight, 1.0f);
+	gentle::FillTriangleHalfSpace(second, FILLED, topLeft, bottomRight, bottomLeft, 1.0f);
+
+	int filledPixelCount = 0;
+	for (int i = 0; i < size * size; i += 1)
+	{
+		assert(!(firstPixels[i] == FILLED && secondPixels[i] == FILLED));
+		if (firstPixels[i] == FILLED || secondPixels[i] == FILLED)
+		{
+			filledPixelCount += 1;
+		}
+	}
+	// The shoelace formula gives an area of 323 pixels. Pixels are sampled at their centre, so the shared diagonal
+	// edge does not add or lose any pixels. Along the outer edges some pixels get rounded in and some out.
+	assert(filledPixelCount > 300 && filledPixelCount < 345);
+}
+
+void RunInterpolatedDepthTest(bool halfSpace, bool rampFirst)
+{
+	const int width = 8;
+	const int height = 4;
+	const uint32_t RAMP = 0xFF0000;
+	const uint32_t FLAT = 0x00FF00;
+	uint32_t pixelArray[width * height];
+	float depthArray[width * height];
+	ClearPixelAndDepthArray(pixelArray, depthArray, width * height);
+
+	RenderBuffer renderBuffer;
+	renderBuffer.width = width;
+	renderBuffer.height = height;
+	renderBuffer.pixels = pixelArray;
+	renderBuffer.depth = depthArray;
+
+	// Both triangles cover the whole buffer. The ramp's depth grows by 1/8 per pixel left to right so it passes
+	// through the flat triangle at 0.45 and each one should win on its own half regardless of draw order.
+	gentle::Vec3<int> p0{ -8, -8, 0 };
+	gentle::Vec3<int> p1{ 24, -8, 0 };
+	gentle::Vec3<int> p2{ -8, 24, 0 };
+	for (int pass = 0; pass < 2; pass += 1)
+	{
+		if ((pass == 0) == rampFirst)
+		{
+			if (halfSpace) gentle::FillTriangleHalfSpace(renderBuffer, RAMP, p0, p1, p2, -1.0f, 3.0f, -1.0f);
+			else gentle::FillTriangleInPixels(renderBuffer, RAMP, p0, p1, p2, -1.0f, 3.0f, -1.0f);
+		}
+		else
+		{
+			if (halfSpace) gentle::FillTriangleHalfSpace(renderBuffer, FLAT, p0, p1, p2, 0.45f);
+			else gentle::FillTriangleInPixels(renderBuffer, FLAT, p0, p1, p2, 0.45f);
+		}
+	}
+
+	for (int y = 0; y < height; y += 1)
+	{
+		for (int x = 0; x < width; x += 1)
+		{
+			assert(pixelArray[y * width + x] == (x < 4 ? FLAT : RAMP));
+		}
+	}
+}
+
+void RunInterpolatedDepthTests()
+{
+	RunInterpolatedDepthTest(false, false);
+	RunInterpolatedDepthTest(false, true);
+	RunInterpolatedDepthTest(true, false);
+	RunInterpolatedDepthTest(true, true);
+}
+
+gentle::Mesh<float> MakeUnitCubeMesh()
+{
+	// Using a clockwise winding convention
+	gentle::Mesh<float> cube;
+	cube.triangles = {
+		// SOUTH
+		{ 0.0f, 0.0f, 0.0f, 1.0f,		0.0f, 1.0f, 0.0f, 1.0f,		1.0f, 1.0f, 0.0f, 1.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f,		1.0f, 1.0f, 0.0f, 1.0f,		1.0f, 0.0f, 0.0f, 1.0f },
+		// EAST
+		{ 1.0f, 0.0f, 0.0f, 1.0f,		1.0f, 1.0f, 0.0f, 1.0f,		1.0f, 1.0f, 1.0f, 1.0f },
+		{ 1.0f, 0.0f, 0.0f, 1.0f,		1.0f, 1.0f, 1.0f, 1.0f,		1.0f, 0.0f, 1.0f, 1.0f },
+		// NORTH
+		{ 1.0f, 0.0f, 1.0f, 1.0f,		1.0f, 1.0f, 1.0f, 1.0f,		0.0f, 1.0f, 1.0f, 1.0f },
+		{ 1.0f, 0.0f, 1.0f, 1.0f,		0.0f, 1.0f, 1.0f, 1.0f,		0.0f, 0.0f, 1.0f, 1.0f },
+		// WEST
+		{ 0.0f, 0.0f, 1.0f, 1.0f,		0.0f, 1.0f, 1.0f, 1.0f,		0.0f, 1.0f, 0.0f, 1.0f },
+		{ 0.0f, 0.0f, 1.0f, 1.0f,		0.0f, 1.0f, 0.0f, 1.0f,		0.0f, 0.0f, 0.0f, 1.0f },
+		// TOP
+		{ 0.0f, 1.0f, 0.0f, 1.0f,		0.0f, 1.0f, 1.0f, 1.0f,		1.0f, 1.0f, 1.0f, 1.0f },
+		{ 0.0f, 1.0f, 0.0f, 1.0f,		1.0f, 1.0f, 1.0f, 1.0f,		1.0f, 1.0f, 0.0f, 1.0f },
+		// BOTTOM
+		{ 1.0f, 0.0f, 1.0f, 1.0f,		0.0f, 0.0f, 0.0f, 1.0f,		1.0f, 0.0f, 0.0f, 1.0f },
+		{ 1.0f, 0.0f, 1.0f, 1.0f,		0.0f, 0.0f, 1.0f, 1.0f,		0.0f, 0.0f, 0.0f, 1.0f }
+	};
+	return cube;
+}
+
+template<typename MeshType>
+void RenderCubeInstance(const RenderBuffer &renderBuffer, const MeshType &cube, const gentle::Camera<float> &camera, const gentle::Matrix4x4<float> &world, const gentle::Matrix4x4<float> &projectionMatrix, const gentle::RenderSettings &settings, gentle::ShadingCache<float>* shadingCache)
+{
+	gentle::TransformAndRenderMesh(renderBuffer, cube, camera, world, projectionMatrix, settings);
+}
+
+void RenderCubeInstance(const RenderBuffer &renderBuffer, const gentle::IndexedMesh<float> &cube, const gentle::Camera<float> &camera, const gentle::Matrix4x4<float> &world, const gentle::Matrix4x4<float> &projectionMatrix, const gentle::RenderSettings &settings, gentle::ShadingCache<float>* shadingCache)
+{
+	gentle::TransformAndRenderMesh(renderBuffer, cube, camera, world, projectionMatrix, settings, shadingCache);
+}
+
+// An IndexedMesh cube shades the far & near cubes from shadingCaches[0] & [1] when there are any, like two instances would
+template<typename MeshType>
+void RenderCubeMesh(const RenderBuffer &renderBuffer, const MeshType &cube, const gentle::RenderSettings &settings, bool drawNearCubeFirst = false, gentle::ShadingCache<float>* shadingCaches = nullptr)
+{
+	gentle::Camera<float> camera;
+	camera.up = { 0.0f, 1.0f, 0.0f };
+	camera.position = { 0.0f, 0.0f, 0.0f };
+	camera.direction = { 0.0f, 0.0f, 1.0f };
+	gentle::Matrix4x4<float> projectionMatrix = gentle::MakeProjectionMatrix(90.0f, 1.0f, 0.1f, 1000.0f);
+
+	// Two overlapping cubes so the depth test decides which one ends up in front
+	gentle::Matrix4x4<float> rotation = gentle::MultiplyMatrixWithMatrix(gentle::MakeYAxisRotationMatrix(0.6f), gentle::MakeXAxisRotationMatrix(0.4f));
+	gentle::Matrix4x4<float> nearWorld = gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(-0.5f, -0.5f, 6.0f));
+	gentle::Matrix4x4<float> farWorld = gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(0.0f, -0.2f, 7.0f));
+	gentle::ShadingCache<float>* farCache = (shadingCaches) ? &shadingCaches[0] : nullptr;
+	gentle::ShadingCache<float>* nearCache = (shadingCaches) ? &shadingCaches[1] : nullptr;
+	if (drawNearCubeFirst)
+	{
+		RenderCubeInstance(renderBuffer, cube, camera, nearWorld, projectionMatrix, settings, nearCache);
+		RenderCubeInstance(renderBuffer, cube, camera, farWorld, projectionMatrix, settings, farCache);
+	}
+	else
+	{
+		RenderCubeInstance(renderBuffer, cube, camera, farWorld, projectionMatrix, settings, farCache);
+		RenderCubeInstance(renderBuffer, cube, camera, nearWorld, projectionMatrix, settings, nearCache);
+	}
+}
+
+void RunTiledRasterizationTest()
+{
+	const int width = 100;
+	const int height = 70;
+	uint32_t singleThreadPixels[width * height];
+	float singleThreadDepth[width * height];
+	uint32_t tiledPixels[width * height];
+	float tiledDepth[width * height];
+
+	RenderBuffer singleThreadBuffer;
+	singleThreadBuffer.width = width;
+	singleThreadBuffer.height = height;
+	singleThreadBuffer.pixels = singleThreadPixels;
+	singleThreadBuffer.depth = singleThreadDepth;
+
+	RenderBuffer tiledBuffer = singleThreadBuffer;
+	tiledBuffer.pixels = tiledPixels;
+	tiledBuffer.depth = tiledDepth;
+
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+
+	gentle::ThreadPool workers;
+	gentle::StartThreadPool(workers, 3);
+
+	gentle::FillEngine fillEngines[2] = { gentle::FILL_ENGINE_SCANLINE, gentle::FILL_ENGINE_HALF_SPACE };
+	for (gentle::FillEngine fillEngine : fillEngines)
+	{
+		gentle::RenderSettings singleThreadSettings;
+		singleThreadSettings.fillEngine = fillEngine;
+		gentle::ClearScreen(singleThreadBuffer, EMPTY);
+		RenderCubeMesh(singleThreadBuffer, cube, singleThreadSettings);
+
+		// Tile size deliberately does not divide the buffer size so partial tiles on the edges get exercised
+		gentle::RenderSettings tiledSettings;
+		tiledSettings.threadPool = &workers;
+		tiledSettings.tileSize = 16;
+		tiledSettings.fillEngine = fillEngine;
+		gentle::ClearScreen(tiledBuffer, EMPTY);
+		RenderCubeMesh(tiledBuffer, cube, tiledSettings);
+
+		int filledPixelCount = 0;
+		for (int i = 0; i < width * height; i += 1)
+		{
+			assert(tiledPixels[i] == singleThreadPixels[i]);
+			assert(tiledDepth[i] == singleThreadDepth[i]);
+			if (singleThreadPixels[i] != EMPTY)
+			{
+				filledPixelCount += 1;
+			}
+		}
+		assert(filledPixelCount > 0);
+	}
+}
+
+void RunDepthTileTests()
+{
+	// Render tiles only skip work that would fail the depth test anyway, so the output has to match rendering without them
+	const int width = 100;
+	const int height = 70;
+	uint32_t plainPixels[width * height];
+	float plainDepth[width * height];
+	uint32_t tiledPixels[width * height];
+	float tiledDepth[width * height];
+	RenderTile tiles[13 * 9];	// 100 x 70 pixels rounded up to whole 8 x 8 tiles
+
+	RenderBuffer plainBuffer;
+	plainBuffer.width = width;
+	plainBuffer.height = height;
+	plainBuffer.pixels = plainPixels;
+	plainBuffer.depth = plainDepth;
+
+	RenderBuffer tiledBuffer = plainBuffer;
+	tiledBuffer.pixels = tiledPixels;
+	tiledBuffer.depth = tiledDepth;
+	tiledBuffer.tiles = tiles;
+
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+
+	gentle::FillEngine fillEngines[2] = { gentle::FILL_ENGINE_SCANLINE, gentle::FILL_ENGINE_HALF_SPACE };
+	gentle::ThreadPool workers;
+	gentle::StartThreadPool(workers, 2);
+	gentle::ThreadPool* threadPools[2] = { nullptr, &workers };
+	for (gentle::FillEngine fillEngine : fillEngines)
+	{
+		for (gentle::ThreadPool* threadPool : threadPools)
+		{
+			for (int drawNearCubeFirst = 0; drawNearCubeFirst < 2; drawNearCubeFirst += 1)
+			{
+				gentle::RenderSettings settings;
+				settings.threadPool = threadPool;
+				settings.tileSize = 12;	// Gets rounded up to 16 to line up with the render tiles
+				settings.fillEngine = fillEngine;
+				gentle::ClearScreen(plainBuffer, EMPTY);
+				RenderCubeMesh(plainBuffer, cube, settings, drawNearCubeFirst == 1);
+				gentle::ClearScreen(tiledBuffer, EMPTY);
+				RenderCubeMesh(tiledBuffer, cube, settings, drawNearCubeFirst == 1);
+
+				for (int i = 0; i < width * height; i += 1)
+				{
+					assert(tiledPixels[i] == plainPixels[i]);
+					assert(tiledDepth[i] == plainDepth[i]);
+				}
+			}
+		}
+	}
+
+	// A triangle behind the min depth of every tile it touches never gets drawn, even though the depth buffer underneath is empty
+	uint32_t pixelArray[16 * 8];
+	float depthArray[16 * 8];
+	RenderTile twoTiles[2];
+	RenderBuffer renderBuffer;
+	renderBuffer.width = 16;
+	renderBuffer.height = 8;
+	renderBuffer.pixels = pixelArray;
+	renderBuffer.depth = depthArray;
+	renderBuffer.tiles = twoTiles;
+
+	gentle::Vec3<int> p0{ 0, 0, 0 };
+	gentle::Vec3<int> p1{ 15, 0, 0 };
+	gentle::Vec3<int> p2{ 0, 7, 0 };
+	for (int halfSpace = 0; halfSpace < 2; halfSpace += 1)
+	{
+		gentle::ClearScreen(renderBuffer, EMPTY);
+		for (RenderTile &tile : twoTiles)
+		{
+			tile.minDepth = 1.0f;
+			tile.maxDepth = 1.0f;
+		}
+		if (halfSpace) gentle::FillTriangleHalfSpace(renderBuffer, FILLED, p0, p1, p2, 0.5f);
+		else gentle::FillTriangleInPixels(renderBuffer, FILLED, p0, p1, p2, 0.5f);
+		for (int i = 0; i < 16 * 8; i += 1)
+		{
+			assert(pixelArray[i] == EMPTY);
+		}
+
+		// Clearing the screen resets the tiles so the same triangle gets drawn
+		gentle::ClearScreen(renderBuffer, EMPTY);
+		if (halfSpace) gentle::FillTriangleHalfSpace(renderBuffer, FILLED, p0, p1, p2, 0.5f);
+		else gentle::FillTriangleInPixels(renderBuffer, FILLED, p0, p1, p2, 0.5f);
+		assert(pixelArray[0] == FILLED);
+		assert(twoTiles[0].maxDepth >= 0.5f);
+	}
+}
+
+void RunClearScreenTests()
+{
+	// Buffer deliberately starts off a 16 byte boundary & has a size that isn't a multiple of 4, so every part of the SIMD fill gets used
+	const uint32_t CLEAR = 0x123456;
+	uint32_t pixelArray[17] = { EMPTY };	// 15 pixels in the RenderBuffer plus one either side to pick up illegal memory writes
+	float depthArray[17] = { 0.0f };
+	for (int i = 0; i < 17; i += 1)
+	{
+		depthArray[i] = 1.0f;
+	}
+
+	RenderBuffer renderBuffer;
+	renderBuffer.width = 5;
+	renderBuffer.height = 3;
+	renderBuffer.pixels = &pixelArray[1];
+	renderBuffer.depth = &depthArray[1];
+	gentle::ClearScreen(renderBuffer, CLEAR);
+
+	assert(pixelArray[0] == EMPTY);
+	assert(depthArray[0] == 1.0f);
+	for (int i = 1; i < 16; i += 1)
+	{
+		assert(pixelArray[i] == CLEAR);
+		assert(depthArray[i] == 0.0f);
+	}
+	assert(pixelArray[16] == EMPTY);
+	assert(depthArray[16] == 1.0f);
+
+	// Deferred clearing has to end up with exactly the same pixels & depth as clearing straight away
+	const int width = 100;
+	const int height = 70;
+	uint32_t immediatePixels[width * height];
+	float immediateDepth[width * height];
+	uint32_t deferredPixels[width * height];
+	float deferredDepth[width * height];
+	RenderTile immediateTiles[13 * 9];
+	RenderTile deferredTiles[13 * 9];
+
+	RenderBuffer immediateBuffer;
+	immediateBuffer.width = width;
+	immediateBuffer.height = height;
+	immediateBuffer.pixels = immediatePixels;
+	immediateBuffer.depth = immediateDepth;
+	immediateBuffer.tiles = immediateTiles;
+
+	RenderBuffer deferredBuffer = immediateBuffer;
+	deferredBuffer.pixels = deferredPixels;
+	deferredBuffer.depth = deferredDepth;
+	deferredBuffer.tiles = deferredTiles;
+
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+	gentle::FillEngine fillEngines[2] = { gentle::FILL_ENGINE_SCANLINE, gentle::FILL_ENGINE_HALF_SPACE };
+	gentle::ThreadPool workers;
+	gentle::StartThreadPool(workers, 2);
+	gentle::ThreadPool* threadPools[2] = { nullptr, &workers };
+	for (gentle::FillEngine fillEngine : fillEngines)
+	{
+		for (gentle::ThreadPool* threadPool : threadPools)
+		{
+			gentle::RenderSettings settings;
+			settings.threadPool = threadPool;
+			settings.tileSize = 16;
+			settings.fillEngine = fillEngine;
+
+			// Something left over from the last frame that the clear has to get rid of
+			gentle::ClearScreen(deferredBuffer, FILLED);
+
+			gentle::ClearScreen(immediateBuffer, CLEAR);
+			RenderCubeMesh(immediateBuffer, cube, settings);
+			gentle::DrawRect(immediateBuffer, FILLED, gentle::Rect<float>{ { 20.0f, 30.0f }, { 6.0f, 4.0f } });
+			gentle::PlotPixel(immediateBuffer, FILLED, 90, 5);
+
+			gentle::ClearScreenDeferred(deferredBuffer, CLEAR);
+			RenderCubeMesh(deferredBuffer, cube, settings);
+			gentle::DrawRect(deferredBuffer, FILLED, gentle::Rect<float>{ { 20.0f, 30.0f }, { 6.0f, 4.0f } });
+			gentle::PlotPixel(deferredBuffer, FILLED, 90, 5);
+			gentle::ResolveDeferredClear(deferredBuffer);
+
+			for (int i = 0; i < width * height; i += 1)
+			{
+				assert(deferredPixels[i] == immediatePixels[i]);
+				assert(deferredDepth[i] == immediateDepth[i]);
+			}
+			for (const RenderTile &tile : deferredTiles)
+			{
+				assert(!tile.isClearPending);
+			}
+		}
+	}
+
+	// A triangle covering whole tiles straight after a deferred clear mustn't get depth tested against the frame before it
+	gentle::Vec3<int> corners[3] = { { -5, -5, 0 }, { 300, -5, 0 }, { -5, 300, 0 } };
+	gentle::FillTriangleHalfSpace(deferredBuffer, FILLED, corners[0], corners[1], corners[2], 0.9f);
+	gentle::ClearScreenDeferred(deferredBuffer, CLEAR);
+	gentle::FillTriangleHalfSpace(deferredBuffer, EMPTY, corners[0], corners[1], corners[2], 0.5f);
+	gentle::ResolveDeferredClear(deferredBuffer);
+	for (int i = 0; i < width * height; i += 1)
+	{
+		assert(deferredPixels[i] == EMPTY);
+		assert(deferredDepth[i] == 0.5f);
+	}
+}
+
+const int SCISSOR_TEST_PRIMITIVE_COUNT = 7;
+
+// Draw one kind of primitive, some of it crossing the edges of the scissor & some of it entirely outside
+static void DrawScissorTestPrimitive(const RenderBuffer &renderBuffer, int primitive, const gentle::Mesh<float> &cube, const gentle::RenderSettings &settings)
+{
+	char sprite[] = "x x\n xx\nx  x";
+	switch (primitive)
+	{
+		case 0:
+			RenderCubeMesh(renderBuffer, cube, settings);
+			break;
+		case 1:
+			gentle::DrawLineInPixels(renderBuffer, FILLED, gentle::Vec2<int>{ 0, 0 }, gentle::Vec2<int>{ 99, 69 });
+			gentle::DrawLineInPixels(renderBuffer, FILLED, gentle::Vec2<int>{ 90, 3 }, gentle::Vec2<int>{ 2, 60 });
+			gentle::DrawLineInPixels(renderBuffer, FILLED, gentle::Vec2<int>{ -10, 35 }, gentle::Vec2<int>{ 120, 35 });
+			gentle::DrawLineInPixels(renderBuffer, FILLED, gentle::Vec2<int>{ 30, 80 }, gentle::Vec2<int>{ 30, -5 });
+			gentle::DrawLineInPixels(renderBuffer, FILLED, gentle::Vec2<int>{ 70, 60 }, gentle::Vec2<int>{ 90, 65 });
+			break;
+		case 2:
+			gentle::PlotPixel(renderBuffer, FILLED, 20, 30);
+			gentle::PlotPixel(renderBuffer, FILLED, 5, 5);
+			break;
+		case 3:
+			gentle::DrawRect(renderBuffer, FILLED, gentle::Rect<float>{ { 15.0f, 25.0f }, { 6.0f, 8.0f } });
+			break;
+		case 4:
+			gentle::DrawSprite(renderBuffer, sprite, gentle::Vec2<float>{ 50.0f, 52.0f }, 2.0f, FILLED);
+			break;
+		case 5:
+			gentle::FillTriangleInPixels(renderBuffer, FILLED, gentle::Vec3<int>{ 5, 40, 0 }, gentle::Vec3<int>{ 95, 45, 0 }, gentle::Vec3<int>{ 60, 68, 0 }, 0.9f);
+			break;
+		case 6:
+			gentle::FillTriangleHalfSpace(renderBuffer, FILLED, gentle::Vec3<int>{ 40, 2, 0 }, gentle::Vec3<int>{ 98, 10, 0 }, gentle::Vec3<int>{ 50, 30, 0 }, 0.2f, 0.9f, 0.5f);
+			break;
+	}
+}
+
+static bool IsInside(const gentle::PixelRect &rect, int x, int y)
+{
+	return (x >= rect.x0) && (x < rect.x1) && (y >= rect.y0) && (y < rect.y1);
+}
+
+static bool IsDirty(const gentle::DirtyRegion &region, int x, int y)
+{
+	for (int i = 0; i < region.rectCount; i += 1)
+	{
+		if (IsInside(region.rects[i], x, y))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void RunScissorTests()
+{
+	// Drawing with a scissor has to give the same pixels & depth as drawing without one inside the scissor, & leave
+	// everything outside it alone. The dirty region has to cover every pixel that changed, & nothing outside the scissor
+	const uint32_t CLEAR = 0x123456;
+	const uint32_t RECLEAR = 0x654321;
+	const int width = 100;
+	const int height = 70;
+	static uint32_t wholePixels[width * height];
+	static float wholeDepth[width * height];
+	static uint32_t scissoredPixels[width * height];
+	static float scissoredDepth[width * height];
+	static uint32_t previousPixels[width * height];
+	RenderTile wholeTiles[13 * 9];
+	RenderTile scissoredTiles[13 * 9];
+
+	RenderBuffer wholeBuffer;
+	wholeBuffer.width = width;
+	wholeBuffer.height = height;
+	wholeBuffer.pixels = wholePixels;
+	wholeBuffer.depth = wholeDepth;
+	wholeBuffer.tiles = wholeTiles;
+
+	RenderBuffer unscissoredBuffer = wholeBuffer;
+	unscissoredBuffer.pixels = scissoredPixels;
+	unscissoredBuffer.depth = scissoredDepth;
+	unscissoredBuffer.tiles = scissoredTiles;
+
+	// Deliberately not lined up with the render tiles
+	gentle::PixelRect scissor = { 13, 21, 58, 49 };
+	gentle::DirtyRegion dirtyRegion;
+	RenderBuffer scissoredBuffer = unscissoredBuffer;
+	scissoredBuffer.scissor = &scissor;
+	scissoredBuffer.dirtyRegion = &dirtyRegion;
+
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+	gentle::FillEngine fillEngines[2] = { gentle::FILL_ENGINE_SCANLINE, gentle::FILL_ENGINE_HALF_SPACE };
+	gentle::ThreadPool workers;
+	gentle::StartThreadPool(workers, 2);
+	gentle::ThreadPool* threadPools[2] = { nullptr, &workers };
+	for (gentle::FillEngine fillEngine : fillEngines)
+	{
+		for (gentle::ThreadPool* threadPool : threadPools)
+		{
+			gentle::RenderSettings settings;
+			settings.threadPool = threadPool;
+			settings.tileSize = 16;
+			settings.fillEngine = fillEngine;
+
+			// One primitive at a time, so the dirty rect of one can't cover for another that forgot to add its own
+			gentle::ClearScreenDeferred(wholeBuffer, CLEAR);
+			gentle::ClearScreenDeferred(unscissoredBuffer, CLEAR);
+			for (int primitive = 0; primitive < SCISSOR_TEST_PRIMITIVE_COUNT; primitive += 1)
+			{
+				DrawScissorTestPrimitive(wholeBuffer, primitive, cube, settings);
+
+				gentle::ResolveDeferredClear(unscissoredBuffer);
+				memcpy(previousPixels, scissoredPixels, sizeof(previousPixels));
+				gentle::ResetDirtyRegion(dirtyRegion);
+				DrawScissorTestPrimitive(scissoredBuffer, primitive, cube, settings);
+				gentle::ResolveDeferredClear(unscissoredBuffer);
+
+				for (int y = 0; y < height; y += 1)
+				{
+					for (int x = 0; x < width; x += 1)
+					{
+						int i = (y * width) + x;
+						assert((scissoredPixels[i] == previousPixels[i]) || IsDirty(dirtyRegion, x, y));
+					}
+				}
+				for (int i = 0; i < dirtyRegion.rectCount; i += 1)
+				{
+					gentle::PixelRect clipped = gentle::IntersectPixelRects(dirtyRegion.rects[i], scissor);
+					assert((clipped.x0 == dirtyRegion.rects[i].x0) && (clipped.y0 == dirtyRegion.rects[i].y0));
+					assert((clipped.x1 == dirtyRegion.rects[i].x1) && (clipped.y1 == dirtyRegion.rects[i].y1));
+				}
+			}
+			gentle::ResolveDeferredClear(wholeBuffer);
+
+			for (int y = 0; y < height; y += 1)
+			{
+				for (int x = 0; x < width; x += 1)
+				{
+					int i = (y * width) + x;
+					bool isInside = IsInside(scissor, x, y);
+					assert(scissoredPixels[i] == (isInside ? wholePixels[i] : CLEAR));
+					assert(scissoredDepth[i] == (isInside ? wholeDepth[i] : 0.0f));
+				}
+			}
+
+			// Clearing & redrawing just the scissor has to match clearing & redrawing everything. The render tiles it clears
+			// some or all of mustn't still think they hold the nearer triangle that was there before
+			gentle::ClearScreen(wholeBuffer, RECLEAR);
+			gentle::FillTriangleHalfSpace(unscissoredBuffer, FILLED, gentle::Vec3<int>{ -5, -5, 0 }, gentle::Vec3<int>{ 300, -5, 0 }, gentle::Vec3<int>{ -5, 300, 0 }, 0.95f);
+			gentle::ResetDirtyRegion(dirtyRegion);
+			gentle::ClearScreenDeferred(scissoredBuffer, RECLEAR);
+			assert((dirtyRegion.rectCount == 1) && (dirtyRegion.rects[0].x0 == scissor.x0) && (dirtyRegion.rects[0].y1 == scissor.y1));
+			for (int primitive = 0; primitive < SCISSOR_TEST_PRIMITIVE_COUNT; primitive += 1)
+			{
+				DrawScissorTestPrimitive(wholeBuffer, primitive, cube, settings);
+				DrawScissorTestPrimitive(scissoredBuffer, primitive, cube, settings);
+			}
+			for (int y = 0; y < height; y += 1)
+			{
+				for (int x = 0; x < width; x += 1)
+				{
+					int i = (y * width) + x;
+					bool isInside = IsInside(scissor, x, y);
+					assert(scissoredPixels[i] == (isInside ? wholePixels[i] : FILLED));
+					assert(scissoredDepth[i] == (isInside ? wholeDepth[i] : 0.95f));
+				}
+			}
+
+			// Nor may a deferred clear still waiting on the tiles the scissor covers part of undo the scissored clear
+			gentle::ClearScreenDeferred(unscissoredBuffer, CLEAR);
+			gentle::ClearScreen(scissoredBuffer, RECLEAR);
+			gentle::ResolveDeferredClear(unscissoredBuffer);
+			for (int y = 0; y < height; y += 1)
+			{
+				for (int x = 0; x < width; x += 1)
+				{
+					assert(scissoredPixels[(y * width) + x] == (IsInside(scissor, x, y) ? RECLEAR : CLEAR));
+				}
+			}
+		}
+	}
+}
+
+void RunClippingTests()
+{
+	// A triangle thousands of times bigger than the screen reaches past the guard band so it gets clipped.
+	// Whatever is left still has to cover every pixel, including the last row & column.
+	const int width = 40;
+	const int height = 30;
+	uint32_t pixelArray[width * height];
+	float depthArray[width * height];
+
+	RenderBuffer renderBuffer;
+	renderBuffer.width = width;
+	renderBuffer.height = height;
+	renderBuffer.pixels = pixelArray;
+	renderBuffer.depth = depthArray;
+
+	gentle::Mesh<float> mesh;
+	mesh.triangles = {
+		{ -1000.0f, -1000.0f, 10.0f, 1.0f,		1000.0f, -1000.0f, 10.0f, 1.0f,		0.0f, 1000.0f, 10.0f, 1.0f }
+	};
+
+	gentle::Camera<float> camera;
+	camera.up = { 0.0f, 1.0f, 0.0f };
+	camera.position = { 0.0f, 0.0f, 0.0f };
+	camera.direction = { 0.0f, 0.0f, 1.0f };
+	gentle::Matrix4x4<float> projectionMatrix = gentle::MakeProjectionMatrix(90.0f, 1.0f, 0.1f, 1000.0f);
+
+	gentle::FillEngine fillEngines[2] = { gentle::FILL_ENGINE_SCANLINE, gentle::FILL_ENGINE_HALF_SPACE };
+	for (gentle::FillEngine fillEngine : fillEngines)
+	{
+		gentle::RenderSettings settings;
+		settings.fillEngine = fillEngine;
+		gentle::ClearScreen(renderBuffer, EMPTY);
+		gentle::TransformAndRenderMesh(renderBuffer, mesh, camera, gentle::MakeIdentityMatrix<float>(), projectionMatrix, settings);
+
+		for (int i = 0; i < width * height; i += 1)
+		{
+			assert(pixelArray[i] != EMPTY);
+		}
+	}
+
+	// A triangle passing through the camera gets clipped at the near plane, so nothing drawn is nearer than depth 1
+	mesh.triangles = {
+		{ -1.0f, -1.0f, -5.0f, 1.0f,		1.0f, -1.0f, -5.0f, 1.0f,		0.0f, 0.0f, 10.0f, 1.0f }
+	};
+	for (gentle::FillEngine fillEngine : fillEngines)
+	{
+		gentle::RenderSettings settings;
+		settings.fillEngine = fillEngine;
+		gentle::ClearScreen(renderBuffer, EMPTY);
+		gentle::TransformAndRenderMesh(renderBuffer, mesh, camera, gentle::MakeIdentityMatrix<float>(), projectionMatrix, settings);
+
+		int filledPixelCount = 0;
+		for (int i = 0; i < width * height; i += 1)
+		{
+			assert(depthArray[i] <= 1.0001f);
+			if (pixelArray[i] != EMPTY)
+			{
+				filledPixelCount += 1;
+			}
+		}
+		assert(filledPixelCount > 0);
+	}
+}
+
+void RunIndexedMeshTests()
+{
+	// The cube's 36 corners are only 8 unique vertices, & drawing it indexed has to match drawing it as a triangle list
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+	gentle::IndexedMesh<float> indexedCube = gentle::MakeIndexedMesh(cube);
+	assert(indexedCube.vertices.x.size() == 8);
+	assert(indexedCube.vertices.w.empty());
+	assert(indexedCube.indices.size() == 36);
+
+	const int width = 100;
+	const int height = 70;
+	uint32_t listPixels[width * height];
+	float listDepth[width * height];
+	uint32_t indexedPixels[width * height];
+	float indexedDepth[width * height];
+
+	RenderBuffer listBuffer;
+	listBuffer.width = width;
+	listBuffer.height = height;
+	listBuffer.pixels = listPixels;
+	listBuffer.depth = listDepth;
+
+	RenderBuffer indexedBuffer = listBuffer;
+	indexedBuffer.pixels = indexedPixels;
+	indexedBuffer.depth = indexedDepth;
+
+	// Each indexed cube shades from its own cache of face normals, which has to follow changes to the light. The second pass
+	// changes the light & flips the draw order, & the third reuses what the second cached
+	gentle::Vec3<float> lightDirections[3] = { { 0.0f, 0.0f, 1.0f }, { 1.0f, -2.0f, 3.0f }, { 1.0f, -2.0f, 3.0f } };
+	gentle::ShadingCache<float> shadingCaches[2];
+	for (int pass = 0; pass < 3; pass += 1)
+	{
+		gentle::RenderSettings settings;
+		settings.lightDirection = lightDirections[pass];
+		gentle::ClearScreen(listBuffer, EMPTY);
+		RenderCubeMesh(listBuffer, cube, settings);
+		gentle::ClearScreen(indexedBuffer, EMPTY);
+		RenderCubeMesh(indexedBuffer, indexedCube, settings, pass == 1, shadingCaches);
+
+		int filledPixelCount = 0;
+		for (int i = 0; i < width * height; i += 1)
+		{
+			assert(indexedPixels[i] == listPixels[i]);
+			assert(indexedDepth[i] == listDepth[i]);
+			if (listPixels[i] != EMPTY)
+			{
+				filledPixelCount += 1;
+			}
+		}
+		assert(filledPixelCount > 0);
+	}
+
+	// The caches get used as they are while the transforms & light stay the same, until ComputeFaceNormals changes the normals
+	const uint32_t CACHED = 0x123456;
+	for (gentle::ShadingCache<float> &shadingCache : shadingCaches)
+	{
+		assert(shadingCache.isValid);
+		std::fill(shadingCache.colors.begin(), shadingCache.colors.end(), CACHED);
+	}
+	gentle::RenderSettings settings;
+	settings.lightDirection = lightDirections[2];
+	for (int pass = 0; pass < 2; pass += 1)
+	{
+		if (pass == 1)
+		{
+			gentle::ComputeFaceNormals(indexedCube);
+		}
+		gentle::ClearScreen(indexedBuffer, EMPTY);
+		RenderCubeMesh(indexedBuffer, indexedCube, settings, false, shadingCaches);
+		for (int i = 0; i < width * height; i += 1)
+		{
+			assert(indexedPixels[i] == ((pass == 0 && listPixels[i] != EMPTY) ? CACHED : listPixels[i]));
+		}
+	}
+}
+
+void RunCullingTests()
+{
+	const int width = 100;
+	const int height = 70;
+	uint32_t pixelArray[width * height];
+	float depthArray[width * height];
+
+	RenderBuffer renderBuffer;
+	renderBuffer.width = width;
+	renderBuffer.height = height;
+	renderBuffer.pixels = pixelArray;
+	renderBuffer.depth = depthArray;
+
+	gentle::Camera<float> camera;
+	camera.up = { 0.0f, 1.0f, 0.0f };
+	camera.position = { 0.0f, 0.0f, 0.0f };
+	camera.direction = { 0.0f, 0.0f, 1.0f };
+	gentle::Matrix4x4<float> projectionMatrix = gentle::MakeProjectionMatrix(90.0f, 1.0f, 0.1f, 1000.0f);
+	gentle::Matrix4x4<float> rotation = gentle::MultiplyMatrixWithMatrix(gentle::MakeYAxisRotationMatrix(0.6f), gentle::MakeXAxisRotationMatrix(0.4f));
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+
+	// Half of a closed cube faces away from the camera
+	gentle::RenderSettings settings;
+	gentle::ClearScreen(renderBuffer, EMPTY);
+	gentle::Matrix4x4<float> inFront = gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(0.0f, 0.0f, 30.0f));
+	gentle::RenderStats stats = gentle::TransformAndRenderMesh(renderBuffer, cube, camera, inFront, projectionMatrix, settings);
+	assert(stats.trianglesSubmitted == 12);
+	assert(stats.trianglesBackFacing == 6);
+	assert(stats.trianglesOutside == 0);
+	assert(stats.trianglesFilled == 6);
+
+	// Behind the camera, everything is outside the near plane
+	gentle::Matrix4x4<float> behind = gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(-0.5f, -0.5f, -6.0f));
+	stats = gentle::TransformAndRenderMesh(renderBuffer, cube, camera, behind, projectionMatrix, settings);
+	assert(stats.trianglesOutside == 12);
+	assert(stats.trianglesFilled == 0);
+
+	// With bounds the whole cube gets culled before any of its triangles are looked at, whether it's behind the camera, off
+	// the side of the screen or past the far plane
+	gentle::ComputeBounds(cube);
+	gentle::Matrix4x4<float> offScreen = gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(-60.0f, 0.0f, 30.0f));
+	gentle::Matrix4x4<float> pastFarPlane = gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(0.0f, 0.0f, 1100.0f));
+	gentle::Matrix4x4<float> outsideView[3] = { behind, offScreen, pastFarPlane };
+	for (const gentle::Matrix4x4<float> &transform : outsideView)
+	{
+		stats = gentle::TransformAndRenderMesh(renderBuffer, cube, camera, transform, projectionMatrix, settings);
+		assert(stats.meshesCulled == 1);
+		assert(stats.trianglesSubmitted == 12);
+		assert(stats.trianglesOutside == 0);
+		assert(stats.trianglesFilled == 0);
+	}
+
+	// Straddling the near plane keeps the cube
+	gentle::Matrix4x4<float> throughNearPlane = gentle::MakeTranslationMatrix(-0.5f, -0.5f, -0.5f);
+	stats = gentle::TransformAndRenderMesh(renderBuffer, cube, camera, throughNearPlane, projectionMatrix, settings);
+	assert(stats.meshesCulled == 0);
+
+	stats = gentle::TransformAndRenderMesh(renderBuffer, cube, camera, inFront, projectionMatrix, settings);
+	assert(stats.meshesCulled == 0);
+	assert(stats.trianglesFilled == 6);
+
+	gentle::IndexedMesh<float> indexedCube = gentle::MakeIndexedMesh(cube);
+	stats = gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, offScreen, projectionMatrix, settings);
+	assert(stats.meshesCulled == 1);
+	cube.bounds.isValid = false;
+
+	// Clusters of two triangles make a cluster per side of the cube, & the three sides facing away get thrown away whole.
+	// Mirroring the cube turns it inside out, but the same sides still face away
+	gentle::BuildClusters(indexedCube, 2);
+	assert(indexedCube.clusters.size() == 6);
+	gentle::Matrix4x4<float> mirror = gentle::MakeIdentityMatrix<float>();
+	mirror.m[0][0] = -1.0f;
+	gentle::Matrix4x4<float> clusterTransforms[2] = { inFront, gentle::MultiplyMatrixWithMatrix(mirror, inFront) };
+	for (const gentle::Matrix4x4<float> &transform : clusterTransforms)
+	{
+		stats = gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, transform, projectionMatrix, settings);
+		assert(stats.clustersCulled == 3);
+		assert(stats.trianglesBackFacing == 6);
+		assert(stats.trianglesFilled == 6);
+	}
+
+	// Stretched along x, the far end of the cube is off the side of the screen, so its cluster counts as outside
+	gentle::Matrix4x4<float> stretched = gentle::MakeIdentityMatrix<float>();
+	stretched.m[0][0] = 200.0f;
+	stretched = gentle::MultiplyMatrixWithMatrix(stretched, gentle::MakeTranslationMatrix(-199.5f, -0.5f, 30.0f));
+	stats = gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, stretched, projectionMatrix, settings);
+	assert(stats.meshesCulled == 0);
+	assert(stats.trianglesOutside == 2);
+	assert(stats.trianglesBackFacing == 2);
+	assert(stats.clustersCulled == 2);
+	assert(stats.trianglesFilled == 8);
+
+	// A triangle seen exactly edge on has no area
+	gentle::Mesh<float> edgeOn;
+	edgeOn.triangles = {
+		{ 0.0f, 0.0f, 5.0f, 1.0f,		0.0f, 1.0f, 6.0f, 1.0f,		0.0f, -1.0f, 7.0f, 1.0f }
+	};
+	stats = gentle::TransformAndRenderMesh(renderBuffer, edgeOn, camera, gentle::MakeIdentityMatrix<float>(), projectionMatrix, settings);
+	assert(stats.trianglesDegenerate == 1);
+
+	// A cube far enough away to fall between pixel centres gets culled by the half-space engine without changing the
+	// picture, while the scanline engine still fills the pixels its corners land in
+	gentle::Matrix4x4<float> farAway = gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(0.0f, 0.0f, 900.0f));
+	gentle::FillEngine fillEngines[2] = { gentle::FILL_ENGINE_SCANLINE, gentle::FILL_ENGINE_HALF_SPACE };
+	for (gentle::FillEngine fillEngine : fillEngines)
+	{
+		settings.fillEngine = fillEngine;
+		gentle::ClearScreen(renderBuffer, EMPTY);
+		stats = gentle::TransformAndRenderMesh(renderBuffer, cube, camera, farAway, projectionMatrix, settings);
+		assert(stats.trianglesBackFacing == 6);
+
+		int filledPixelCount = 0;
+		for (int i = 0; i < width * height; i += 1)
+		{
+			if (pixelArray[i] != EMPTY)
+			{
+				filledPixelCount += 1;
+			}
+		}
+		if (fillEngine == gentle::FILL_ENGINE_HALF_SPACE)
+		{
+			assert(stats.trianglesMissingSamples == 6);
+			assert(filledPixelCount == 0);
+		}
+		else
+		{
+			assert(stats.trianglesMissingSamples == 0);
+			assert(filledPixelCount > 0);
+		}
+	}
+}
+
+void RunDrawListTests()
+{
+	// Rendering a draw list in one pass has to match rendering each of its instances on its own, overlaps included, with the
+	// stats of every instance added together
+	const int width = 100;
+	const int height = 70;
+	uint32_t separatePixels[width * height];
+	float separateDepth[width * height];
+	uint32_t drawListPixels[width * height];
+	float drawListDepth[width * height];
+
+	RenderBuffer separateBuffer;
+	separateBuffer.width = width;
+	separateBuffer.height = height;
+	separateBuffer.pixels = separatePixels;
+	separateBuffer.depth = separateDepth;
+
+	RenderBuffer drawListBuffer = separateBuffer;
+	drawListBuffer.pixels = drawListPixels;
+	drawListBuffer.depth = drawListDepth;
+
+	gentle::Camera<float> camera;
+	camera.up = { 0.0f, 1.0f, 0.0f };
+	camera.position = { 0.0f, 0.0f, 0.0f };
+	camera.direction = { 0.0f, 0.0f, 1.0f };
+	gentle::Matrix4x4<float> projectionMatrix = gentle::MakeProjectionMatrix(90.0f, 1.0f, 0.1f, 1000.0f);
+	gentle::Matrix4x4<float> rotation = gentle::MultiplyMatrixWithMatrix(gentle::MakeYAxisRotationMatrix(0.6f), gentle::MakeXAxisRotationMatrix(0.4f));
+	gentle::IndexedMesh<float> cube = gentle::MakeIndexedMesh(MakeUnitCubeMesh());
+
+	gentle::DrawList<float> drawList;
+	// Each instance of the same mesh keeps its own shading cache. The separate renders below shade without one
+	gentle::ShadingCache<float> shadingCaches[3];
+	gentle::AddMeshInstance(drawList, cube, gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(0.0f, 0.0f, 30.0f)), &shadingCaches[0]);
+	gentle::AddMeshInstance(drawList, cube, gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(0.5f, 0.3f, 31.0f)), &shadingCaches[1]);
+	gentle::AddMeshInstance(drawList, cube, gentle::MultiplyMatrixWithMatrix(rotation, gentle::MakeTranslationMatrix(-60.0f, 0.0f, 30.0f)), &shadingCaches[2]);
+	gentle::AddMeshInstance(drawList, cube, gentle::MakeTranslationMatrix(-3.0f, -2.0f, 40.0f));
+
+	// Binning triangles into tiles uses the scratch arena & gives it all back afterwards
+	static uint8_t scratchMemory[64 * 1024];
+	gentle::MemoryArena scratchArena = gentle::MakeMemoryArena(scratchMemory, sizeof(scratchMemory));
+
+	gentle::ThreadPool workers;
+	gentle::StartThreadPool(workers, 3);
+	gentle::ThreadPool* threadPools[2] = { nullptr, &workers };
+	for (gentle::ThreadPool* threadPool : threadPools)
+	{
+		gentle::RenderSettings settings;
+		settings.threadPool = threadPool;
+		settings.scratchArena = &scratchArena;
+		gentle::ClearScreen(separateBuffer, EMPTY);
+		gentle::RenderStats separateStats;
+		for (const gentle::MeshInstance<float> &instance : drawList.instances)
+		{
+			gentle::RenderStats stats = gentle::TransformAndRenderMesh(separateBuffer, *instance.mesh, camera, instance.transformMatrix, projectionMatrix, settings);
+			separateStats.trianglesSubmitted += stats.trianglesSubmitted;
+			separateStats.trianglesBackFacing += stats.trianglesBackFacing;
+			separateStats.trianglesFilled += stats.trianglesFilled;
+			separateStats.meshesCulled += stats.meshesCulled;
+		}
+
+		// By the time the pool gets used everything has been rendered once, so with the bins in the arena & the workers already
+		// running, filling the tiles in parallel mustn't touch the heap. Only counted with allocation tracking built in
+		gentle::ClearScreen(drawListBuffer, EMPTY);
+		gentle::BeginAllocationFrame();
+		gentle::RenderStats drawListStats = gentle::RenderDrawList(drawListBuffer, drawList, camera, projectionMatrix, settings);
+		assert(!threadPool || (gentle::GetTotalAllocationCount(gentle::GetFrameAllocationStats()) == 0));
+		assert(drawListStats.trianglesSubmitted == 48);
+		assert(drawListStats.meshesCulled == 1);
+		assert(drawListStats.trianglesSubmitted == separateStats.trianglesSubmitted);
+		assert(drawListStats.trianglesBackFacing == separateStats.trianglesBackFacing);
+		assert(drawListStats.trianglesFilled == separateStats.trianglesFilled);
+		assert(drawListStats.meshesCulled == separateStats.meshesCulled);
+		assert(scratchArena.used == 0);
+		assert((scratchArena.peakUsed > 0) == (threadPool != nullptr));
+
+		int filledPixelCount = 0;
+		for (int i = 0; i < width * height; i += 1)
+		{
+			assert(drawListPixels[i] == separatePixels[i]);
+			assert(drawListDepth[i] == separateDepth[i]);
+			if (separatePixels[i] != EMPTY)
+			{
+				filledPixelCount += 1;
+			}
+		}
+		assert(filledPixelCount > 0);
+	}
+}
+
+void RunOcclusionTests()
+{
+	const int width = 100;
+	const int height = 70;
+	uint32_t pixelArray[width * height];
+	float depthArray[width * height];
+
+	RenderBuffer renderBuffer;
+	renderBuffer.width = width;
+	renderBuffer.height = height;
+	renderBuffer.pixels = pixelArray;
+	renderBuffer.depth = depthArray;
+
+	gentle::Camera<float> camera;
+	camera.up = { 0.0f, 1.0f, 0.0f };
+	camera.position = { 0.0f, 0.0f, 0.0f };
+	camera.direction = { 0.0f, 0.0f, 1.0f };
+	gentle::Matrix4x4<float> projectionMatrix = gentle::MakeProjectionMatrix(90.0f, 1.0f, 0.1f, 1000.0f);
+
+	// A wall across the middle of the screen, rendered at half resolution without any pixels
+	gentle::Mesh<float> wall;
+	wall.triangles = {
+		{ -1.5f, -1.0f, 20.0f, 1.0f,		1.5f, -1.0f, 20.0f, 1.0f,		1.5f, 1.0f, 20.0f, 1.0f },
+		{ -1.5f, -1.0f, 20.0f, 1.0f,		1.5f, 1.0f, 20.0f, 1.0f,		-1.5f, 1.0f, 20.0f, 1.0f }
+	};
+	gentle::IndexedMesh<float> indexedWall = gentle::MakeIndexedMesh(wall);
+	gentle::OcclusionBuffer occlusionBuffer = gentle::MakeOcclusionBuffer(width / 2, height / 2, renderBuffer);
+	gentle::RenderStats stats = gentle::RenderOccluder(occlusionBuffer, indexedWall, camera, gentle::MakeIdentityMatrix<float>(), projectionMatrix);
+	assert(stats.trianglesFilled == 2);
+	assert(occlusionBuffer.depth[(occlusionBuffer.width * (occlusionBuffer.height / 2)) + (occlusionBuffer.width / 2)] > 0.0f);
+	assert(occlusionBuffer.depth[0] == 0.0f);
+
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+	gentle::ComputeBounds(cube);
+	gentle::IndexedMesh<float> indexedCube = gentle::MakeIndexedMesh(cube);
+	gentle::RenderSettings settings;
+	settings.occlusionBuffer = &occlusionBuffer;
+
+	// Behind the wall the cube gets skipped, whether it's a triangle list or indexed
+	gentle::Matrix4x4<float> behindWall = gentle::MakeTranslationMatrix(-0.5f, -0.5f, 30.0f);
+	gentle::ClearScreen(renderBuffer, EMPTY);
+	stats = gentle::TransformAndRenderMesh(renderBuffer, cube, camera, behindWall, projectionMatrix, settings);
+	assert(stats.meshesOccluded == 1);
+	assert(stats.trianglesSubmitted == 12);
+	assert(stats.trianglesFilled == 0);
+	stats = gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, behindWall, projectionMatrix, settings);
+	assert(stats.meshesOccluded == 1);
+	assert(stats.trianglesFilled == 0);
+
+	// In front of the wall, peeking out from behind it, or straddling the near plane, the cube is kept
+	gentle::Matrix4x4<float> visible[3] = {
+		gentle::MakeTranslationMatrix(-0.5f, -0.5f, 10.0f),
+		gentle::MakeTranslationMatrix(2.0f, -0.5f, 30.0f),
+		gentle::MakeTranslationMatrix(-0.5f, -0.5f, -0.5f)
+	};
+	for (const gentle::Matrix4x4<float> &transform : visible)
+	{
+		stats = gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, transform, projectionMatrix, settings);
+		assert(stats.meshesOccluded == 0);
+	}
+
+	// A cube peeking out past the edge of a wall by even a pixel of the screen is kept. Covering a pixel of the occlusion buffer
+	// by its centre would hide a screen pixel or two past the wall's edge, more with coarser occlusion buffers. The second
+	// wall stops a quarter of a screen pixel short of the right of the screen, so the cube can peek out between them
+	gentle::Mesh<float> edgeWall;
+	edgeWall.triangles = {
+		{ -1.5f, -1.0f, 20.0f, 1.0f,		1.98f, -1.0f, 20.0f, 1.0f,		1.98f, 1.0f, 20.0f, 1.0f },
+		{ -1.5f, -1.0f, 20.0f, 1.0f,		1.98f, 1.0f, 20.0f, 1.0f,		-1.5f, 1.0f, 20.0f, 1.0f }
+	};
+	const gentle::Mesh<float>* peekWalls[2] = { &wall, &edgeWall };
+	const int peekScales[2] = { 4, 2 };
+	gentle::RenderSettings exactSettings;
+	exactSettings.fillEngine = gentle::FILL_ENGINE_HALF_SPACE;
+	const uint32_t WALL = 0x0000FF;
+	for (int i = 0; i < 2; i += 1)
+	{
+		gentle::OcclusionBuffer peekOcclusionBuffer = gentle::MakeOcclusionBuffer(width / peekScales[i], height / peekScales[i], renderBuffer);
+		gentle::RenderOccluder(peekOcclusionBuffer, gentle::MakeIndexedMesh(*peekWalls[i]), camera, gentle::MakeIdentityMatrix<float>(), projectionMatrix);
+		int culledCount = 0;
+		int peekingCount = 0;
+		for (int step = 0; step <= 150; step += 1)
+		{
+			gentle::Matrix4x4<float> transform = gentle::MakeTranslationMatrix(1.0f + (0.01f * (float)step), -0.5f, 30.0f);
+			gentle::ClearScreen(renderBuffer, EMPTY);
+			gentle::TransformAndRenderMesh(renderBuffer, *peekWalls[i], camera, gentle::MakeIdentityMatrix<float>(), projectionMatrix, exactSettings);
+			std::replace_if(pixelArray, pixelArray + (width * height), [&](uint32_t pixel) { return pixel != EMPTY; }, WALL);
+			gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, transform, projectionMatrix, exactSettings);
+			bool isCubeVisible = std::any_of(pixelArray, pixelArray + (width * height), [&](uint32_t pixel) { return (pixel != EMPTY) && (pixel != WALL); });
+
+			exactSettings.occlusionBuffer = &peekOcclusionBuffer;
+			stats = gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, transform, projectionMatrix, exactSettings);
+			exactSettings.occlusionBuffer = nullptr;
+			assert(!isCubeVisible || (stats.meshesOccluded == 0));
+			culledCount += stats.meshesOccluded;
+			peekingCount += isCubeVisible ? 1 : 0;
+		}
+		assert((culledCount > 0) && (peekingCount > 0));
+	}
+
+	// An occluder never hides itself
+	gentle::ClearOcclusionBuffer(occlusionBuffer);
+	gentle::RenderOccluder(occlusionBuffer, indexedCube, camera, behindWall, projectionMatrix);
+	stats = gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, behindWall, projectionMatrix, settings);
+	assert(stats.meshesOccluded == 0);
+	assert(stats.trianglesFilled > 0);
+}
+
+void RunAllocationFreeRenderTests()
+{
+	if (!gentle::IsTrackingAllocations())
+	{
+		return;
+	}
+
+	const int width = 100;
+	const int height = 70;
+	uint32_t pixelArray[width * height];
+	float depthArray[width * height];
+
+	RenderBuffer renderBuffer;
+	renderBuffer.width = width;
+	renderBuffer.height = height;
+	renderBuffer.pixels = pixelArray;
+	renderBuffer.depth = depthArray;
+
+	gentle::Camera<float> camera;
+	camera.up = { 0.0f, 1.0f, 0.0f };
+	camera.position = { 0.0f, 0.0f, 0.0f };
+	camera.direction = { 0.0f, 0.0f, 1.0f };
+	gentle::Matrix4x4<float> projectionMatrix = gentle::MakeProjectionMatrix(90.0f, 1.0f, 0.1f, 1000.0f);
+
+	gentle::Mesh<float> cube = MakeUnitCubeMesh();
+	gentle::ComputeBounds(cube);
+	gentle::IndexedMesh<float> indexedCube = gentle::MakeIndexedMesh(cube);
+	gentle::OcclusionBuffer occlusionBuffer = gentle::MakeOcclusionBuffer(width / 2, height / 2, renderBuffer);
+	gentle::DrawList<float> drawList;
+	gentle::RenderSettings settings;
+	settings.occlusionBuffer = &occlusionBuffer;
+
+	// The triangles binned for a thread pool go in the scratch arena
+	static uint8_t scratchMemory[64 * 1024];
+	gentle::MemoryArena scratchArena = gentle::MakeMemoryArena(scratchMemory, sizeof(scratchMemory));
+	settings.scratchArena = &scratchArena;
+	gentle::ThreadPool workers;
+	gentle::StartThreadPool(workers, 3);
+
+	// One cube in view & one poking through the near plane, so clipping runs too
+	gentle::Matrix4x4<float> transforms[2] = {
+		gentle::MakeTranslationMatrix(-0.5f, -0.5f, 30.0f),
+		gentle::MakeTranslationMatrix(-0.05f, -0.5f, 0.05f)
+	};
+
+	// Once the first frame has sized the scratch buffers, later frames shouldn't touch the heap, whether they fill triangles
+	// on the calling thread or on the pool. The workers have allocation forbidden while they fill too
+	for (int frame = 0; frame < 3; frame += 1)
+	{
+		settings.threadPool = (frame == 2) ? &workers : nullptr;
+		if (frame == 1)
+		{
+			gentle::BeginAllocationFrame();
+			gentle::SetHeapAllocationForbidden(true);
+		}
+
+		gentle::ClearScreen(renderBuffer, EMPTY);
+		gentle::ClearOcclusionBuffer(occlusionBuffer);
+		gentle::RenderOccluder(occlusionBuffer, indexedCube, camera, transforms[0], projectionMatrix);
+		drawList.instances.clear();
+		for (const gentle::Matrix4x4<float> &transform : transforms)
+		{
+			gentle::TransformAndRenderMesh(renderBuffer, cube, camera, transform, projectionMatrix, settings);
+			gentle::TransformAndRenderMesh(renderBuffer, indexedCube, camera, transform, projectionMatrix, settings);
+			gentle::AddMeshInstance(drawList, indexedCube, transform);
+		}
+		gentle::RenderStats stats = gentle::RenderDrawList(renderBuffer, drawList, camera, projectionMatrix, settings);
+		assert(stats.trianglesClipped > 0);
+	}
+
+	gentle::SetHeapAllocationForbidden(false);
+	assert(gentle::GetTotalAllocationCount(gentle::GetFrameAllocationStats()) == 0);
+}
+
 void RunSoftwareRenderingTests()
 {
 	/**
@@ -1029,4 +2240,17 @@ void RunSoftwareRenderingTests()
 		FILLED,	FILLED,	FILLED,	FILLED,	EMPTY,	EMPTY
 	};
 	Run6x4FillTriangleTest(gentle::Vec3<int>{ 5, 0, 0 }, gentle::Vec3<int>{ 0, 3, 0 }, gentle::Vec3<int>{ 3, 3, 0 }, efb10);
+
+	RunHalfSpaceFillTests();
+	RunInterpolatedDepthTests();
+	RunTiledRasterizationTest();
+	RunDepthTileTests();
+	RunClearScreenTests();
+	RunScissorTests();
+	RunClippingTests();
+	RunIndexedMeshTests();
+	RunCullingTests();
+	RunDrawListTests();
+	RunOcclusionTests();
+	RunAllocationFreeRenderTests();
 }
\ No newline at end of file
@@ -4,6 +4,14 @@
 #include "../software_rendering.tests.cpp"
 #include "../geometry.tests.cpp"
 #include "../collision.tests.cpp"
+#include "../memory.tests.cpp"
+#include "../input_recording.tests.cpp"
+#include "../frame_pacing.tests.cpp"
+#include "../fixed_timestep.tests.cpp"
+#include "../dirty_region.tests.cpp"
+#include "../present_queue.tests.cpp"
+#include "../snapshot_queue.tests.cpp"
+#include "../thread_pool.tests.cpp"
 
 int main()
 {
@@ -22,4 +30,36 @@ int main()
 	std::cout << "Starting collision tests.\n";
 	RunCollisionTests();
 	std::cout << "collision tests passed.\n";
+
+	std::cout << "Starting memory tests.\n";
+	RunMemoryTests();
+	std::cout << "memory tests passed.\n";
+
+	std::cout << "Starting input_recording tests.\n";
+	RunInputRecordingTests();
+	std::cout << "input_recording tests passed.\n";
+
+	std::cout << "Starting frame_pacing tests.\n";
+	RunFramePacingTests();
+	std::cout << "frame_pacing tests passed.\n";
+
+	std::cout << "Starting fixed_timestep tests.\n";
+	RunFixedTimestepTests();
+	std::cout << "fixed_timestep tests passed.\n";
+
+	std::cout << "Starting dirty_region tests.\n";
+	RunDirtyRegionTests();
+	std::cout << "dirty_region tests passed.\n";
+
+	std::cout << "Starting present_queue tests.\n";
+	RunPresentQueueTests();
+	std::cout << "present_queue tests passed.\n";
+
+	std::cout << "Starting snapshot_queue tests.\n";
+	RunSnapshotQueueTests();
+	std::cout << "snapshot_queue tests passed.\n";
+
+	std::cout << "Starting thread_pool tests.\n";
+	RunThreadPoolTests();
+	std::cout << "thread_pool tests passed.\n";
 }
\ No newline at end of file
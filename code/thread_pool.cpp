@@ -0,0 +1,110 @@
+#include <assert.h>
+#include <algorithm>
+#include "memory.hpp"
+#include "thread_pool.hpp"
+
+namespace gentle
+{
+	static void RunThreadPoolWorker(ThreadPool* pool)
+	{
+		uint64_t lastJobIndex = 0;
+		std::unique_lock<std::mutex> lock(pool->mutex);
+		for (;;)
+		{
+			pool->workReady.wait(lock, [&] { return pool->isStopping || (pool->jobIndex != lastJobIndex); });
+			if (pool->isStopping)
+			{
+				return;
+			}
+
+			lastJobIndex = pool->jobIndex;
+			if (pool->unclaimedCount == 0)
+			{
+				continue;
+			}
+			pool->unclaimedCount -= 1;
+			pool->runningCount += 1;
+			void (*job)(void* data) = pool->job;
+			void* data = pool->jobData;
+			bool isAllocationForbidden = pool->isJobAllocationForbidden;
+
+			lock.unlock();
+			SetHeapAllocationForbidden(isAllocationForbidden);
+			job(data);
+			SetHeapAllocationForbidden(false);
+			lock.lock();
+
+			pool->runningCount -= 1;
+			if (pool->runningCount == 0)
+			{
+				pool->workDone.notify_all();
+			}
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		StopThreadPool(*this);
+	}
+
+	void StartThreadPool(ThreadPool &pool, int workerCount)
+	{
+		assert(pool.workers.empty());
+		{
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			pool.isStopping = false;
+		}
+		pool.workers.reserve(workerCount);
+		for (int i = 0; i < workerCount; i += 1)
+		{
+			pool.workers.emplace_back(RunThreadPoolWorker, &pool);
+		}
+	}
+
+	void StopThreadPool(ThreadPool &pool)
+	{
+		{
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			pool.isStopping = true;
+		}
+		pool.workReady.notify_all();
+		for (std::thread &worker : pool.workers)
+		{
+			worker.join();
+		}
+		pool.workers.clear();
+	}
+
+	int GetThreadPoolWorkerCount(const ThreadPool &pool)
+	{
+		return (int)pool.workers.size();
+	}
+
+	void RunOnThreadPool(ThreadPool &pool, int maxWorkerCount, void (*job)(void* data), void* data)
+	{
+		int workerCount = std::min(maxWorkerCount, GetThreadPoolWorkerCount(pool));
+		if (workerCount > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				assert((pool.unclaimedCount == 0) && (pool.runningCount == 0) && "Only one thread at a time can run jobs on a pool");
+				pool.job = job;
+				pool.jobData = data;
+				pool.isJobAllocationForbidden = IsHeapAllocationForbidden();
+				pool.jobIndex += 1;
+				pool.unclaimedCount = workerCount;
+			}
+			pool.workReady.notify_all();
+		}
+
+		job(data);
+
+		if (workerCount > 0)
+		{
+			// Workers that haven't woken up yet would only find the job already done, so don't wait for them
+			std::unique_lock<std::mutex> lock(pool.mutex);
+			pool.unclaimedCount = 0;
+			pool.workDone.wait(lock, [&] { return pool.runningCount == 0; });
+		}
+	}
+}
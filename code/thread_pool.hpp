@@ -0,0 +1,60 @@
+#ifndef GENTLE_THREAD_POOL_H
+#define GENTLE_THREAD_POOL_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gentle
+{
+	/**
+	 * Worker threads started once & then kept waiting for work, so code that runs in parallel every frame doesn't pay for
+	 * creating & joining threads each time, or allocate anything to hand them work. The thread that runs a job on the pool
+	 * works on it too, so a pool of N workers runs a job on up to N + 1 threads. One thread at a time runs jobs on a pool.
+	 */
+	struct ThreadPool
+	{
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable workReady;
+		std::condition_variable workDone;
+
+		void (*job)(void* data) = nullptr;
+		void* jobData = nullptr;
+		bool isJobAllocationForbidden = false;	// Whether the thread running the job had heap allocation forbidden, so the workers do too
+		uint64_t jobIndex = 0;		// Bumped for every job, so a worker can tell a new one from the one it last saw
+		int unclaimedCount = 0;		// Workers the current job can still take on
+		int runningCount = 0;		// Workers still inside the current job
+		bool isStopping = false;
+
+		ThreadPool() = default;
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+	};
+
+	void StartThreadPool(ThreadPool &pool, int workerCount);
+
+	// Wait for the workers to finish what they're doing & exit. Destroying a pool stops it too
+	void StopThreadPool(ThreadPool &pool);
+
+	int GetThreadPoolWorkerCount(const ThreadPool &pool);
+
+	/**
+	 * Run job(data) on the calling thread & on up to maxWorkerCount of the pool's workers at the same time, & return once every
+	 * one of them has returned. Workers that haven't picked the job up by the time the calling thread finishes it don't run it
+	 * at all, so the job must be fine on any number of threads, e.g. each taking the next item off a shared atomic counter
+	 * until there are none left. When the calling thread has heap allocation forbidden, so do the workers while they run it.
+	 */
+	void RunOnThreadPool(ThreadPool &pool, int maxWorkerCount, void (*job)(void* data), void* data);
+
+	template<typename Job>
+	void RunOnThreadPool(ThreadPool &pool, int maxWorkerCount, Job &job)
+	{
+		RunOnThreadPool(pool, maxWorkerCount, [](void* data) { (*(Job*)data)(); }, &job);
+	}
+}
+
+#endif
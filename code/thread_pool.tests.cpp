@@ -0,0 +1,91 @@
+#include "thread_pool.hpp"
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+void RunThreadPoolTests()
+{
+	// Every item of every job gets done exactly once, & always by the same few threads rather than new ones each job
+	const int itemCount = 1000;
+	const int jobCount = 50;
+	gentle::ThreadPool pool;
+	gentle::StartThreadPool(pool, 3);
+	assert(gentle::GetThreadPoolWorkerCount(pool) == 3);
+
+	std::mutex threadIdsMutex;
+	std::set<std::thread::id> threadIds;
+	for (int jobIndex = 0; jobIndex < jobCount; jobIndex += 1)
+	{
+		std::atomic<int> doneCounts[itemCount] = {};
+		std::atomic<int> nextItem(0);
+		auto job = [&]()
+		{
+			{
+				std::lock_guard<std::mutex> lock(threadIdsMutex);
+				threadIds.insert(std::this_thread::get_id());
+			}
+			for (int item = nextItem++; item < itemCount; item = nextItem++)
+			{
+				doneCounts[item] += 1;
+			}
+		};
+		gentle::RunOnThreadPool(pool, 3, job);
+		for (int item = 0; item < itemCount; item += 1)
+		{
+			assert(doneCounts[item] == 1);
+		}
+	}
+	assert(threadIds.size() <= 4);
+	assert(threadIds.count(std::this_thread::get_id()) == 1);
+
+	// Without any workers to spare, the job runs on the calling thread alone
+	std::atomic<int> runCount(0);
+	bool isOnCallingThread = true;
+	std::thread::id callingThread = std::this_thread::get_id();
+	auto job = [&]()
+	{
+		runCount += 1;
+		isOnCallingThread = isOnCallingThread && (std::this_thread::get_id() == callingThread);
+	};
+	gentle::RunOnThreadPool(pool, 0, job);
+	assert((runCount == 1) && isOnCallingThread);
+
+	// A stopped pool runs everything on the calling thread, & can be started again
+	gentle::StopThreadPool(pool);
+	assert(gentle::GetThreadPoolWorkerCount(pool) == 0);
+	runCount = 0;
+	gentle::RunOnThreadPool(pool, 3, job);
+	assert((runCount == 1) && isOnCallingThread);
+
+	gentle::StartThreadPool(pool, 2);
+	std::atomic<int> waitingCount(0);
+	auto waitForEveryone = [&]()
+	{
+		// Only finishes once all three threads are in the job at the same time
+		waitingCount += 1;
+		while (waitingCount < 3)
+		{
+			std::this_thread::yield();
+		}
+	};
+	gentle::RunOnThreadPool(pool, 2, waitForEveryone);
+	assert(waitingCount == 3);
+
+	// Workers forbid heap allocation while they run a job from a thread that forbids it, & only then
+	for (int isForbidden = 0; isForbidden < 2; isForbidden += 1)
+	{
+		waitingCount = 0;
+		std::atomic<int> forbiddenCount(0);
+		auto checkForbidden = [&]()
+		{
+			forbiddenCount += gentle::IsHeapAllocationForbidden() ? 1 : 0;
+			waitForEveryone();
+		};
+		gentle::SetHeapAllocationForbidden(isForbidden == 1);
+		gentle::RunOnThreadPool(pool, 2, checkForbidden);
+		gentle::SetHeapAllocationForbidden(false);
+		assert(forbiddenCount == (((isForbidden == 1) && gentle::IsTrackingAllocations()) ? 3 : 0));
+	}
+}